@@ -31,23 +31,15 @@ function main(conf) {
 
   var sd = new StringDecoder(isBase64 ? 'base64' : encoding);
 
-  for (var i = 0; i < inLen; ++i) {
-    if (i > 0 && (i % chunkLen) === 0 && !isBase64) {
-      chunks.push(new Buffer(str, encoding));
-      str = '';
-    }
+  for (var i = 0; i < inLen; ++i)
     str += alpha[i % alpha.length];
-  }
-  if (str.length > 0 && !isBase64)
-    chunks.push(new Buffer(str, encoding));
-  if (isBase64) {
-    str = new Buffer(str, 'utf8').toString('base64');
-    while (str.length > 0) {
-      var len = Math.min(chunkLen, str.length);
-      chunks.push(new Buffer(str.substring(0, len), 'utf8'));
-      str = str.substring(len);
-    }
-  }
+
+  // Split the input at byte offsets, like a stream would, so multi-byte
+  // characters end up spread over two chunks.
+  var input = isBase64 ? new Buffer(new Buffer(str, 'utf8').toString('base64'))
+                       : new Buffer(str, encoding);
+  for (var offset = 0; offset < input.length; offset += chunkLen)
+    chunks.push(input.slice(offset, offset + chunkLen));
 
   var nChunks = chunks.length;
 
@@ -3,7 +3,7 @@ var querystring = require('querystring');
 var v8 = require('v8');
 
 var bench = common.createBenchmark(main, {
-  type: ['noencode', 'encodemany', 'encodelast'],
+  type: ['noencode', 'encodemany', 'encodelast', 'multibyte', 'manypairs'],
   n: [1e6],
 });
 
@@ -14,7 +14,9 @@ function main(conf) {
   var inputs = {
     noencode: 'foo=bar&baz=quux&xyzzy=thud',
     encodemany: '%66%6F%6F=bar&%62%61%7A=quux&xyzzy=%74h%75d',
-    encodelast: 'foo=bar&baz=quux&xyzzy=thu%64'
+    encodelast: 'foo=bar&baz=quux&xyzzy=thu%64',
+    multibyte: '%E4%B8%AD%E6%96%87=%E4%B8%AD%E6%96%87&foo=%F0%9F%98%80',
+    manypairs: new Array(64).join('foo=bar+baz&') + 'last=%2F'
   };
   var input = inputs[type];
 
@@ -29,6 +29,21 @@
 #include <string.h>
 #include <limits.h>
 
+/* See scan_token() and friends below. */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# if defined(__clang__) ? __clang_major__ >= 4 :                              \
+     __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)
+#  define HTTP_PARSER_SSE42 1
+#  include <cpuid.h>
+#  include <nmmintrin.h>
+# endif
+#endif
+
+#if defined(__GNUC__) && defined(__SSE2__)
+# define HTTP_PARSER_SSE2 1
+# include <emmintrin.h>
+#endif
+
 #ifndef ULLONG_MAX
 # define ULLONG_MAX ((uint64_t) -1) /* 2^64-1 */
 #endif
@@ -464,6 +479,142 @@ static struct {
 
 int http_message_needs_eof(const http_parser *parser);
 
+/* Fast paths for the runs of bytes that make up most of a request: header
+ * names, the URL and header values.  Each scanner returns the first byte in
+ * [p, end) that the state machine has to look at.  The vector loops may stop
+ * early on a byte that turns out to be valid, the scalar loop then carries
+ * on from there, but they never skip a byte that the byte-by-byte checks
+ * would reject, so HTTP_PARSER_STRICT validation is unchanged.
+ *
+ * PCMPESTRI matches 16 bytes against up to 8 byte ranges at once.  It needs
+ * SSE4.2, which is detected at run time.  CR/LF search only needs SSE2.
+ */
+
+#ifdef HTTP_PARSER_SSE42
+/* Bytes that end a token: CTLs, SP, separators and everything >= DEL.  Only
+ * 8 ranges fit, so '|' and '~' stop the vector loop too. */
+static const char token_stop_ranges[16] =
+  { 0x00, ' ', '"', '"', '(', ')', ',', ',', '/', '/', ':', '@', '[', ']'
+  , '{', (char) 0xff };
+
+/* Bytes that end a run of path, query string or fragment characters.  TAB
+ * and FF, valid in non-strict mode, stop the vector loop. */
+static const char url_stop_ranges[16] =
+#if HTTP_PARSER_STRICT
+  { 0x00, ' ', '#', '#', '?', '?', 0x7f, (char) 0xff };
+#else
+  { 0x00, ' ', '#', '#', '?', '?', 0x7f, 0x7f };
+#endif
+
+static int has_sse42 = -1;
+
+static int
+cpu_has_sse42(void)
+{
+  unsigned int eax, ebx, ecx, edx;
+
+  /* Racy but harmless, every thread comes up with the same answer. */
+  if (UNLIKELY(has_sse42 == -1)) {
+    has_sse42 = __get_cpuid(1, &eax, &ebx, &ecx, &edx) &&
+                (ecx & bit_SSE4_2) != 0;
+  }
+
+  return has_sse42;
+}
+
+__attribute__((target("sse4.2")))
+static const char *
+scan_ranges_sse42(const char *p, const char *end, const char *ranges,
+                  int ranges_len)
+{
+  const __m128i r = _mm_loadu_si128((const __m128i *) ranges);
+
+  for (; end - p >= 16; p += 16) {
+    const __m128i b = _mm_loadu_si128((const __m128i *) p);
+    int i = _mm_cmpestri(r, ranges_len, b, 16,
+                         _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES |
+                         _SIDD_LEAST_SIGNIFICANT);
+    if (i != 16)
+      return p + i;
+  }
+
+  return p;
+}
+#endif  /* HTTP_PARSER_SSE42 */
+
+
+/* Returns the first byte that is not a header name character. */
+static const char *
+scan_token(const char *p, const char *end)
+{
+#ifdef HTTP_PARSER_SSE42
+  if (cpu_has_sse42()) {
+    p = scan_ranges_sse42(p, end, token_stop_ranges,
+                          sizeof(token_stop_ranges));
+  }
+#endif
+
+  while (p != end && TOKEN(*p))
+    p++;
+
+  return p;
+}
+
+
+/* Returns the first byte that does not keep the URL parser in the path,
+ * query string or fragment state it is in. */
+static const char *
+scan_url(const char *p, const char *end)
+{
+#ifdef HTTP_PARSER_SSE42
+  if (cpu_has_sse42()) {
+    p = scan_ranges_sse42(p, end, url_stop_ranges, 8);
+  }
+#endif
+
+  while (p != end && IS_URL_CHAR(*p))
+    p++;
+
+  return p;
+}
+
+
+/* Returns the first CR or LF, or end if there is none. */
+static const char *
+scan_crlf(const char *p, const char *end)
+{
+#ifdef HTTP_PARSER_SSE2
+  const __m128i cr = _mm_set1_epi8(CR);
+  const __m128i lf = _mm_set1_epi8(LF);
+
+  for (; end - p >= 16; p += 16) {
+    const __m128i b = _mm_loadu_si128((const __m128i *) p);
+    int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(b, cr),
+                                              _mm_cmpeq_epi8(b, lf)));
+    if (mask != 0)
+      return p + __builtin_ctz(mask);
+  }
+
+  for (; p != end; p++) {
+    if (*p == CR || *p == LF)
+      break;
+  }
+
+  return p;
+#else
+  const char *p_cr = (const char *) memchr(p, CR, end - p);
+  const char *p_lf;
+
+  /* A LF after the first CR does not matter. */
+  if (p_cr != NULL)
+    end = p_cr;
+
+  p_lf = (const char *) memchr(p, LF, end - p);
+  return p_lf != NULL ? p_lf : end;
+#endif
+}
+
+
 /* Our URL parser.
  *
  * This is designed to be shared by http_parser_execute() for URL validation,
@@ -1137,6 +1288,24 @@ reexecute:
               SET_ERRNO(HPE_INVALID_URL);
               goto error;
             }
+
+            /* Skip ahead over the rest of the path, query string or
+             * fragment, every URL character keeps us in the same state.
+             */
+            switch (CURRENT_STATE()) {
+              case s_req_path:
+              case s_req_query_string:
+              case s_req_fragment:
+              {
+                const char* start = p + 1;
+                p = scan_url(start, data + len) - 1;
+                COUNT_HEADER_SIZE(p + 1 - start);
+                break;
+              }
+
+              default:
+                break;
+            }
         }
         break;
       }
@@ -1325,6 +1494,7 @@ reexecute:
 
           switch (parser->header_state) {
             case h_general:
+              p = scan_token(p + 1, data + len) - 1;
               break;
 
             case h_C:
@@ -1541,24 +1711,15 @@ reexecute:
           switch (h_state) {
             case h_general:
             {
-              const char* p_cr;
-              const char* p_lf;
-              size_t limit = data + len - p;
-
-              limit = MIN(limit, HTTP_MAX_HEADER_SIZE);
-
-              p_cr = (const char*) memchr(p, CR, limit);
-              p_lf = (const char*) memchr(p, LF, limit);
-              if (p_cr != NULL) {
-                if (p_lf != NULL && p_cr >= p_lf)
-                  p = p_lf;
-                else
-                  p = p_cr;
-              } else if (UNLIKELY(p_lf != NULL)) {
-                p = p_lf;
-              } else {
+              const char* limit;
+              size_t n = data + len - p;
+
+              n = MIN(n, HTTP_MAX_HEADER_SIZE);
+              limit = p + n;
+
+              p = scan_crlf(p, limit);
+              if (p == limit)
                 p = data + len;
-              }
               --p;
 
               break;
@@ -106,6 +106,13 @@
       'type': 'executable',
       'dependencies': [ 'http_parser_strict' ],
       'sources': [ 'test.c' ]
+    },
+
+    {
+      'target_name': 'bench',
+      'type': 'executable',
+      'dependencies': [ 'http_parser' ],
+      'sources': [ 'bench.c' ]
     }
   ]
 }
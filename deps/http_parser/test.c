@@ -3788,6 +3788,45 @@ main (void)
     "\r\n";
   test_simple(corrupted_header_name, HPE_INVALID_HEADER_TOKEN);
 
+  // header names and URLs longer than the 16 bytes the scanners look at
+  // at once, with the interesting byte past the first block
+  test_simple("GET / HTTP/1.1\r\n"
+              "X-A-Rather-Long-Header-Name|With~Odd-Chars: value\r\n"
+              "\r\n",
+              HPE_OK);
+
+  test_simple("GET / HTTP/1.1\r\n"
+              "X-A-Rather-Long-Header\033Name: value\r\n"
+              "\r\n",
+              HPE_INVALID_HEADER_TOKEN);
+
+  test_simple("GET /a/rather/long/path/to/a/resource?with=a&long=query"
+              "#and-a-fragment HTTP/1.1\r\n"
+              "\r\n",
+              HPE_OK);
+
+  test_simple("GET /a/rather/long/path/to/a\033resource HTTP/1.1\r\n"
+              "\r\n",
+              HPE_INVALID_URL);
+
+  test_simple("GET /a/rather/long/path/to/a\tresource HTTP/1.1\r\n"
+              "\r\n",
+#if HTTP_PARSER_STRICT
+              HPE_INVALID_URL
+#else
+              HPE_OK
+#endif
+              );
+
+  test_simple("GET /a/rather/long/path/to/a/r\303\251sum\303\251 HTTP/1.1\r\n"
+              "\r\n",
+#if HTTP_PARSER_STRICT
+              HPE_INVALID_URL
+#else
+              HPE_OK
+#endif
+              );
+
 #if 0
   // NOTE(Wed Nov 18 11:57:27 CET 2009) this seems okay. we just read body
   // until EOF.
@@ -6,6 +6,7 @@
 /* @(#) $Id$ */
 
 #include "zutil.h"
+#include "x86.h"
 
 #define local static
 
@@ -89,6 +90,14 @@ uLong ZEXPORT adler32(adler, buf, len)
     if (buf == Z_NULL)
         return 1L;
 
+#ifdef X86_SIMD
+    if (len >= Z_ADLER32_SIMD_MIN_LEN) {
+        x86_check_features();
+        if (x86_cpu_enable_ssse3)
+            return adler32_simd_(adler | (sum2 << 16), buf, len);
+    }
+#endif /* X86_SIMD */
+
     /* in case short lengths are provided, keep it somewhat fast */
     if (len < 16) {
         while (len--) {
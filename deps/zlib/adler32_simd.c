@@ -0,0 +1,109 @@
+/* adler32_simd.c -- Adler-32 using SSSE3
+ * For conditions of distribution and use, see copyright notice in zlib.h
+ *
+ * Per 32 byte block, s1 grows by the sum of the bytes and s2 by 32 times the
+ * previous s1 plus the bytes weighted 32, 31, ..., 1.  PSADBW does the first
+ * sum and PMADDUBSW the weighted one, 16 bytes per instruction.  Blocks are
+ * taken NMAX bytes at a time like in adler32.c, so the 32-bit sums cannot
+ * overflow before they are reduced.
+ */
+
+#include "x86.h"
+
+#ifdef X86_SIMD
+
+#include <tmmintrin.h>
+
+#define BASE 65521      /* largest prime smaller than 65536 */
+#define NMAX 5552
+/* NMAX is the largest n such that 255n(n+1)/2 + (n+1)(BASE-1) <= 2^32-1 */
+
+#define BLOCK_SIZE 32
+
+/* ========================================================================= */
+__attribute__((target("ssse3")))
+unsigned long ZLIB_INTERNAL adler32_simd_(adler, buf, len)
+    unsigned long adler;
+    const unsigned char *buf;
+    unsigned len;
+{
+    unsigned s1 = adler & 0xffff;
+    unsigned s2 = (adler >> 16) & 0xffff;
+    unsigned blocks = len / BLOCK_SIZE;
+
+    const __m128i tap1 =
+        _mm_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25,
+                      24, 23, 22, 21, 20, 19, 18, 17);
+    const __m128i tap2 =
+        _mm_setr_epi8(16, 15, 14, 13, 12, 11, 10, 9,
+                      8, 7, 6, 5, 4, 3, 2, 1);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(1);
+
+    len -= blocks * BLOCK_SIZE;
+
+    while (blocks) {
+        unsigned n = NMAX / BLOCK_SIZE;
+        __m128i v_ps, v_s1, v_s2;
+
+        if (n > blocks)
+            n = blocks;
+        blocks -= n;
+
+        /* v_ps collects s1 as it was before each block, it is multiplied
+         * by the block size at the end */
+        v_ps = _mm_set_epi32(0, 0, 0, (int)(s1 * n));
+        v_s2 = _mm_set_epi32(0, 0, 0, (int)s2);
+        v_s1 = _mm_setzero_si128();
+
+        do {
+            const __m128i bytes1 = _mm_loadu_si128((const __m128i *)buf);
+            const __m128i bytes2 =
+                _mm_loadu_si128((const __m128i *)(buf + 16));
+            __m128i mad;
+
+            v_ps = _mm_add_epi32(v_ps, v_s1);
+
+            v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(bytes1, zero));
+            mad = _mm_maddubs_epi16(bytes1, tap1);
+            v_s2 = _mm_add_epi32(v_s2, _mm_madd_epi16(mad, ones));
+
+            v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(bytes2, zero));
+            mad = _mm_maddubs_epi16(bytes2, tap2);
+            v_s2 = _mm_add_epi32(v_s2, _mm_madd_epi16(mad, ones));
+
+            buf += BLOCK_SIZE;
+        } while (--n);
+
+        v_s2 = _mm_add_epi32(v_s2, _mm_slli_epi32(v_ps, 5));
+
+        /* add up the lanes */
+        v_s1 = _mm_add_epi32(v_s1,
+                             _mm_shuffle_epi32(v_s1, _MM_SHUFFLE(1, 0, 3, 2)));
+        s1 += (unsigned)_mm_cvtsi128_si32(v_s1);
+
+        v_s2 = _mm_add_epi32(v_s2,
+                             _mm_shuffle_epi32(v_s2, _MM_SHUFFLE(2, 3, 0, 1)));
+        v_s2 = _mm_add_epi32(v_s2,
+                             _mm_shuffle_epi32(v_s2, _MM_SHUFFLE(1, 0, 3, 2)));
+        s2 = (unsigned)_mm_cvtsi128_si32(v_s2);
+
+        s1 %= BASE;
+        s2 %= BASE;
+    }
+
+    /* less than a block left */
+    if (len) {
+        while (len--) {
+            s1 += *buf++;
+            s2 += s1;
+        }
+        if (s1 >= BASE)
+            s1 -= BASE;
+        s2 %= BASE;
+    }
+
+    return s1 | ((unsigned long)s2 << 16);
+}
+
+#endif /* X86_SIMD */
@@ -29,6 +29,7 @@
 #endif /* MAKECRCH */
 
 #include "zutil.h"      /* for STDC and FAR definitions */
+#include "x86.h"
 
 #define local static
 
@@ -213,6 +214,21 @@ unsigned long ZEXPORT crc32(crc, buf, len)
         make_crc_table();
 #endif /* DYNAMIC_CRC_TABLE */
 
+#ifdef X86_SIMD
+    /* fold the bulk of the buffer with PCLMULQDQ, the tail goes below */
+    if (len >= Z_CRC32_SIMD_MIN_LEN) {
+        x86_check_features();
+        if (x86_cpu_enable_crc32_simd) {
+            uInt chunk = len & ~Z_CRC32_SIMD_CHUNK_MASK;
+            crc = ~crc32_simd_(buf, chunk, ~(unsigned)crc);
+            buf += chunk;
+            len -= chunk;
+            if (len == 0)
+                return crc;
+        }
+    }
+#endif /* X86_SIMD */
+
 #ifdef BYFOUR
     if (sizeof(void *) == sizeof(ptrdiff_t)) {
         z_crc_t endian;
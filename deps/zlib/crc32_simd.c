@@ -0,0 +1,139 @@
+/* crc32_simd.c -- CRC-32 using PCLMULQDQ
+ * For conditions of distribution and use, see copyright notice in zlib.h
+ *
+ * Folds the input 64 bytes at a time with carry-less multiplication and
+ * reduces the result with Barrett reduction, following "Fast CRC Computation
+ * for Generic Polynomials Using PCLMULQDQ Instruction", V. Gopal et al.,
+ * Intel, 2009.  The constants are for the bit-reflected gzip polynomial.
+ */
+
+#include "x86.h"
+
+#ifdef X86_SIMD
+
+#include <smmintrin.h>
+#include <wmmintrin.h>
+
+#define zalign(x) __attribute__((aligned((x))))
+
+/* ========================================================================= */
+__attribute__((target("sse4.1,pclmul")))
+unsigned ZLIB_INTERNAL crc32_simd_(buf, len, crc)
+    const unsigned char *buf;
+    unsigned len;
+    unsigned crc;
+{
+    /* x^(4*128+32) mod P, x^(4*128-32) mod P and so on, bit-reflected and
+     * shifted left by one */
+    static const unsigned long long zalign(16) k1k2[] =
+        { 0x0154442bd4ULL, 0x01c6e41596ULL };
+    static const unsigned long long zalign(16) k3k4[] =
+        { 0x01751997d0ULL, 0x00ccaa009eULL };
+    static const unsigned long long zalign(16) k5k0[] =
+        { 0x0163cd6124ULL, 0x0000000000ULL };
+    /* P(x) and mu = x^64 / P(x) */
+    static const unsigned long long zalign(16) poly[] =
+        { 0x01db710641ULL, 0x01f7011641ULL };
+
+    __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+
+    x1 = _mm_loadu_si128((const __m128i *)(buf + 0x00));
+    x2 = _mm_loadu_si128((const __m128i *)(buf + 0x10));
+    x3 = _mm_loadu_si128((const __m128i *)(buf + 0x20));
+    x4 = _mm_loadu_si128((const __m128i *)(buf + 0x30));
+
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)crc));
+
+    x0 = _mm_load_si128((const __m128i *)k1k2);
+
+    buf += 64;
+    len -= 64;
+
+    /* fold four 128-bit lanes in parallel, 64 bytes at a time */
+    while (len >= 64) {
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+        x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+        x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+
+        y5 = _mm_loadu_si128((const __m128i *)(buf + 0x00));
+        y6 = _mm_loadu_si128((const __m128i *)(buf + 0x10));
+        y7 = _mm_loadu_si128((const __m128i *)(buf + 0x20));
+        y8 = _mm_loadu_si128((const __m128i *)(buf + 0x30));
+
+        x1 = _mm_xor_si128(x1, x5);
+        x2 = _mm_xor_si128(x2, x6);
+        x3 = _mm_xor_si128(x3, x7);
+        x4 = _mm_xor_si128(x4, x8);
+
+        x1 = _mm_xor_si128(x1, y5);
+        x2 = _mm_xor_si128(x2, y6);
+        x3 = _mm_xor_si128(x3, y7);
+        x4 = _mm_xor_si128(x4, y8);
+
+        buf += 64;
+        len -= 64;
+    }
+
+    /* fold the four lanes into one */
+    x0 = _mm_load_si128((const __m128i *)k3k4);
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(x1, x2);
+    x1 = _mm_xor_si128(x1, x5);
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(x1, x3);
+    x1 = _mm_xor_si128(x1, x5);
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(x1, x4);
+    x1 = _mm_xor_si128(x1, x5);
+
+    /* fold in what is left, 16 bytes at a time */
+    while (len >= 16) {
+        x2 = _mm_loadu_si128((const __m128i *)buf);
+
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(x1, x2);
+        x1 = _mm_xor_si128(x1, x5);
+
+        buf += 16;
+        len -= 16;
+    }
+
+    /* fold 128 bits down to 64 */
+    x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+    x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+    x1 = _mm_srli_si128(x1, 8);
+    x1 = _mm_xor_si128(x1, x2);
+
+    x0 = _mm_loadl_epi64((const __m128i *)k5k0);
+
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, x3);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    /* Barrett reduction to 32 bits */
+    x0 = _mm_load_si128((const __m128i *)poly);
+
+    x2 = _mm_and_si128(x1, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+    x2 = _mm_and_si128(x2, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    return (unsigned)_mm_extract_epi32(x1, 1);
+}
+
+#endif /* X86_SIMD */
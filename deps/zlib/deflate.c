@@ -50,6 +50,11 @@
 /* @(#) $Id$ */
 
 #include "deflate.h"
+#include "x86.h"
+
+#ifdef X86_SSE2
+#  include <emmintrin.h>
+#endif
 
 const char deflate_copyright[] =
    " deflate 1.2.8 Copyright 1995-2013 Jean-loup Gailly and Mark Adler ";
@@ -1253,6 +1258,30 @@ local uInt longest_match(s, cur_match)
         scan += 2, match++;
         Assert(*scan == *match, "match[2]?");
 
+#ifdef X86_SSE2
+        /* Compare 16 bytes at a time from strstart+3 up to strend.  The last
+         * block is moved back to end at strend and overlaps bytes that are
+         * known to match.  This finds the same length as the loop below, so
+         * the output does not depend on the CPU.
+         */
+        scan++, match++;
+        for (;;) {
+            int mask;
+            if (strend - scan < 16) {
+                match -= 16 - (strend - scan);
+                scan = strend - 16;
+            }
+            mask = _mm_movemask_epi8(_mm_cmpeq_epi8(
+                       _mm_loadu_si128((const __m128i *)scan),
+                       _mm_loadu_si128((const __m128i *)match))) ^ 0xffff;
+            if (mask != 0) {
+                scan += __builtin_ctz(mask);
+                break;
+            }
+            scan += 16, match += 16;
+            if (scan == strend) break;
+        }
+#else
         /* We check for insufficient lookahead only every 8th comparison;
          * the 256th check will be made at strstart+258.
          */
@@ -1262,6 +1291,7 @@ local uInt longest_match(s, cur_match)
                  *++scan == *++match && *++scan == *++match &&
                  *++scan == *++match && *++scan == *++match &&
                  scan < strend);
+#endif /* X86_SSE2 */
 
         Assert(scan <= s->window+(unsigned)(s->window_size-1), "wild scan");
 
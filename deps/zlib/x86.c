@@ -0,0 +1,37 @@
+/* x86.c -- x86 CPU feature detection for the SIMD code paths
+ * For conditions of distribution and use, see copyright notice in zlib.h
+ */
+
+#include "x86.h"
+
+#ifdef X86_SIMD
+
+#include <cpuid.h>
+
+int ZLIB_INTERNAL x86_cpu_enable_ssse3 = 0;
+int ZLIB_INTERNAL x86_cpu_enable_crc32_simd = 0;
+
+local int x86_features_checked = 0;
+
+/* ========================================================================= */
+/* Called from crc32() and adler32() before they look at the flags.  Threads
+ * that race here all store the same values, and one that sees the flags
+ * before they are set just takes the portable path, so there is no lock. */
+void ZLIB_INTERNAL x86_check_features()
+{
+    unsigned eax, ebx, ecx, edx;
+
+    if (x86_features_checked)
+        return;
+
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        x86_cpu_enable_ssse3 = (ecx & bit_SSSE3) != 0;
+        /* pclmulqdq for the folding, pextrd from SSE4.1 for the result */
+        x86_cpu_enable_crc32_simd = (ecx & bit_PCLMUL) != 0 &&
+                                    (ecx & bit_SSE4_1) != 0;
+    }
+
+    x86_features_checked = 1;
+}
+
+#endif /* X86_SIMD */
@@ -0,0 +1,51 @@
+/* x86.h -- x86 CPU feature detection for the SIMD code paths
+ * For conditions of distribution and use, see copyright notice in zlib.h
+ */
+
+#ifndef X86_H
+#define X86_H
+
+#include "zutil.h"
+
+/* The SIMD functions are compiled with per-function target attributes, so
+ * the rest of zlib keeps building for the baseline CPU and the faster code
+ * is only called once x86_check_features() has found the instructions it
+ * needs.  That takes GCC 4.9 or clang; other compilers use the portable C
+ * code only.
+ */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  if defined(__clang__) ? __clang_major__ >= 4 : \
+      __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)
+#    define X86_SIMD
+#  endif
+#endif
+
+/* SSE2 is part of x86-64, longest_match() uses it without a run time
+ * check when the compiler targets it. */
+#if defined(__GNUC__) && defined(__SSE2__)
+#  define X86_SSE2
+#endif
+
+#ifdef X86_SIMD
+
+extern int ZLIB_INTERNAL x86_cpu_enable_ssse3;
+extern int ZLIB_INTERNAL x86_cpu_enable_crc32_simd;
+
+void ZLIB_INTERNAL x86_check_features OF((void));
+
+/* crc32_simd.c: len must be a multiple of 16 and at least 64.  crc is
+ * neither pre- nor post-conditioned, crc32() does that. */
+#define Z_CRC32_SIMD_MIN_LEN 64
+#define Z_CRC32_SIMD_CHUNK_MASK 15
+unsigned ZLIB_INTERNAL crc32_simd_ OF((const unsigned char *buf,
+                                      unsigned len, unsigned crc));
+
+/* adler32_simd.c */
+#define Z_ADLER32_SIMD_MIN_LEN 64
+unsigned long ZLIB_INTERNAL adler32_simd_ OF((unsigned long adler,
+                                             const unsigned char *buf,
+                                             unsigned len));
+
+#endif /* X86_SIMD */
+
+#endif /* X86_H */
@@ -14,9 +14,11 @@
           'type': 'static_library',
           'sources': [
             'adler32.c',
+            'adler32_simd.c',
             'compress.c',
             'crc32.c',
             'crc32.h',
+            'crc32_simd.c',
             'deflate.c',
             'deflate.h',
             'gzclose.c',
@@ -35,6 +37,8 @@
             'trees.c',
             'trees.h',
             'uncompr.c',
+            'x86.c',
+            'x86.h',
             'zconf.h',
             'zlib.h',
             'zutil.c',
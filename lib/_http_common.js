@@ -26,27 +26,31 @@ const kOnMessageComplete = HTTPParser.kOnMessageComplete | 0;
 // across multiple TCP packets or too large to be
 // processed in a single run. This method is also
 // called to process trailing HTTP headers.
-function parserOnHeaders(headers, url) {
+function parserOnHeaders(headers, url, headerNames) {
   // Once we exceeded headers limit - stop collecting them
   if (this.maxHeaderPairs <= 0 ||
       this._headers.length < this.maxHeaderPairs) {
     this._headers = this._headers.concat(headers);
+    this._headerNames = this._headerNames.concat(headerNames);
   }
   this._url += url;
 }
 
-// `headers` and `url` are set only if .onHeaders() has not been called for
-// this request.
+// `headers`, `headerNames` and `url` are set only if .onHeaders() has not
+// been called for this request.
 // `url` is not set for response parsers but that's not applicable here since
 // all our parsers are request parsers.
+// `headerNames` holds the lower-cased field names of `headers`.
 function parserOnHeadersComplete(versionMajor, versionMinor, headers, method,
                                  url, statusCode, statusMessage, upgrade,
-                                 shouldKeepAlive) {
+                                 shouldKeepAlive, headerNames) {
   var parser = this;
 
   if (!headers) {
     headers = parser._headers;
+    headerNames = parser._headerNames;
     parser._headers = [];
+    parser._headerNames = [];
   }
 
   if (!url) {
@@ -66,7 +70,7 @@ function parserOnHeadersComplete(versionMajor, versionMinor, headers, method,
   if (parser.maxHeaderPairs > 0)
     n = Math.min(n, parser.maxHeaderPairs);
 
-  parser.incoming._addHeaderLines(headers, n);
+  parser.incoming._addHeaderLines(headers, n, headerNames);
 
   if (typeof method === 'number') {
     // server only
@@ -121,8 +125,11 @@ function parserOnMessageComplete() {
     // Emit any trailing headers.
     var headers = parser._headers;
     if (headers) {
-      parser.incoming._addHeaderLines(headers, headers.length);
+      parser.incoming._addHeaderLines(headers,
+                                      headers.length,
+                                      parser._headerNames);
       parser._headers = [];
+      parser._headerNames = [];
       parser._url = '';
     }
 
@@ -139,6 +146,7 @@ var parsers = new FreeList('parsers', 1000, function() {
   var parser = new HTTPParser(HTTPParser.REQUEST);
 
   parser._headers = [];
+  parser._headerNames = [];
   parser._url = '';
 
   // Only called in the slow case where slow means
@@ -166,6 +174,7 @@ exports.parsers = parsers;
 function freeParser(parser, req, socket) {
   if (parser) {
     parser._headers = [];
+    parser._headerNames = [];
     parser.onIncoming = null;
     if (parser.socket)
       parser.socket.parser = null;
@@ -95,7 +95,9 @@ IncomingMessage.prototype.destroy = function(error) {
 };
 
 
-IncomingMessage.prototype._addHeaderLines = function(headers, n) {
+// `names`, when given, holds the already lower-cased field names of
+// `headers`, one per [field, value] pair.
+IncomingMessage.prototype._addHeaderLines = function(headers, n, names) {
   if (headers && headers.length) {
     var raw, dest;
     if (this.complete) {
@@ -111,7 +113,10 @@ IncomingMessage.prototype._addHeaderLines = function(headers, n) {
       var v = headers[i + 1];
       raw.push(k);
       raw.push(v);
-      this._addHeaderLine(k, v, dest);
+      if (names)
+        addHeaderLine(names[i >> 1], v, dest);
+      else
+        this._addHeaderLine(k, v, dest);
     }
   }
 };
@@ -125,7 +130,12 @@ IncomingMessage.prototype._addHeaderLines = function(headers, n) {
 // and drop the second. Extended header fields (those beginning with 'x-') are
 // always joined.
 IncomingMessage.prototype._addHeaderLine = function(field, value, dest) {
-  field = field.toLowerCase();
+  addHeaderLine(field.toLowerCase(), value, dest);
+};
+
+
+// Same as _addHeaderLine() but `field` must be lower case already.
+function addHeaderLine(field, value, dest) {
   switch (field) {
     // Array headers:
     case 'set-cookie':
@@ -165,7 +175,7 @@ IncomingMessage.prototype._addHeaderLine = function(field, value, dest) {
         dest[field] = value;
       }
   }
-};
+}
 
 
 // Call this instead of resume() if we want to just
@@ -5,18 +5,25 @@ const Stream = require('stream');
 const timers = require('timers');
 const util = require('util');
 const common = require('_http_common');
+const smalloc = require('internal/smalloc');
+const binding = process.binding('http_parser');
 
 const CRLF = common.CRLF;
-const chunkExpression = common.chunkExpression;
 const debug = common.debug;
 
-const connectionExpression = /^Connection$/i;
-const transferEncodingExpression = /^Transfer-Encoding$/i;
-const closeExpression = /close/i;
-const contentLengthExpression = /^Content-Length$/i;
-const dateExpression = /^Date$/i;
-const expectExpression = /^Expect$/i;
-const trailerExpression = /^Trailer$/i;
+const serializeHeaders = binding.serializeHeaders;
+const kSentConnectionHeader = binding.kSentConnectionHeader;
+const kSentContentLengthHeader = binding.kSentContentLengthHeader;
+const kSentTransferEncodingHeader = binding.kSentTransferEncodingHeader;
+const kSentDateHeader = binding.kSentDateHeader;
+const kSentExpect = binding.kSentExpect;
+const kSentTrailer = binding.kSentTrailer;
+const kConnectionClose = binding.kConnectionClose;
+const kConnectionKeepAlive = binding.kConnectionKeepAlive;
+const kChunkedEncoding = binding.kChunkedEncoding;
+
+// Scratch space that serializeHeaders() reports its kSent* flags in.
+const headerFlags = smalloc.alloc(1, smalloc.Types.Uint32);
 
 const automaticHeaders = {
   connection: true,
@@ -148,6 +155,10 @@ OutgoingMessage.prototype._writeRaw = function(data, encoding, callback) {
       var output = this.output;
       var outputEncodings = this.outputEncodings;
       var outputCallbacks = this.outputCallbacks;
+
+      // Hand the pending chunks (usually the header block) and the new data
+      // to the socket as a single writev.
+      connection.cork();
       for (var i = 0; i < outputLength; i++) {
         connection.write(output[i], outputEncodings[i],
                          outputCallbacks[i]);
@@ -156,6 +167,10 @@ OutgoingMessage.prototype._writeRaw = function(data, encoding, callback) {
       this.output = [];
       this.outputEncodings = [];
       this.outputCallbacks = [];
+
+      var ret = connection.write(data, encoding, callback);
+      connection.uncork();
+      return ret;
     }
 
     // Directly write to socket.
@@ -182,44 +197,29 @@ OutgoingMessage.prototype._buffer = function(data, encoding, callback) {
 OutgoingMessage.prototype._storeHeader = function(firstLine, headers) {
   // firstLine in the case of request is: 'GET /index.html HTTP/1.1\r\n'
   // in the case of response it is: 'HTTP/1.1 200 OK\r\n'
-  var state = {
-    sentConnectionHeader: false,
-    sentContentLengthHeader: false,
-    sentTransferEncodingHeader: false,
-    sentDateHeader: false,
-    sentExpect: false,
-    sentTrailer: false,
-    messageHeader: firstLine
-  };
+  var messageHeader = firstLine;
+  var flags = 0;
 
   if (headers) {
-    var keys = Object.keys(headers);
-    var isArray = Array.isArray(headers);
-    var field, value;
-
-    for (var i = 0, l = keys.length; i < l; i++) {
-      var key = keys[i];
-      if (isArray) {
-        field = headers[key][0];
-        value = headers[key][1];
-      } else {
-        field = key;
-        value = headers[key];
-      }
-
-      if (Array.isArray(value)) {
-        for (var j = 0; j < value.length; j++) {
-          storeHeader(this, state, field, value[j]);
-        }
-      } else {
-        storeHeader(this, state, field, value);
-      }
-    }
+    // Validates the field names, strips CR/LF from the values and builds
+    // the block in one go.
+    messageHeader = serializeHeaders(firstLine,
+                                     headers,
+                                     Array.isArray(headers),
+                                     headerFlags);
+    flags = headerFlags[0];
+
+    if (flags & kConnectionClose)
+      this._last = true;
+    if (flags & kConnectionKeepAlive)
+      this.shouldKeepAlive = true;
+    if (flags & kChunkedEncoding)
+      this.chunkedEncoding = true;
   }
 
   // Date header
-  if (this.sendDate === true && state.sentDateHeader === false) {
-    state.messageHeader += 'Date: ' + utcDate() + CRLF;
+  if (this.sendDate === true && (flags & kSentDateHeader) === 0) {
+    messageHeader += 'Date: ' + utcDate() + CRLF;
   }
 
   // Force the connection to close when the response is a 204 No Content or
@@ -246,34 +246,33 @@ OutgoingMessage.prototype._storeHeader = function(firstLine, headers) {
   if (this._removedHeader.connection) {
     this._last = true;
     this.shouldKeepAlive = false;
-  } else if (state.sentConnectionHeader === false) {
+  } else if ((flags & kSentConnectionHeader) === 0) {
     var shouldSendKeepAlive = this.shouldKeepAlive &&
-        (state.sentContentLengthHeader ||
+        ((flags & kSentContentLengthHeader) !== 0 ||
          this.useChunkedEncodingByDefault ||
          this.agent);
     if (shouldSendKeepAlive) {
-      state.messageHeader += 'Connection: keep-alive\r\n';
+      messageHeader += 'Connection: keep-alive\r\n';
     } else {
       this._last = true;
-      state.messageHeader += 'Connection: close\r\n';
+      messageHeader += 'Connection: close\r\n';
     }
   }
 
-  if (state.sentContentLengthHeader === false &&
-      state.sentTransferEncodingHeader === false) {
+  var sentLengthHeader = kSentContentLengthHeader | kSentTransferEncodingHeader;
+  if ((flags & sentLengthHeader) === 0) {
     if (!this._hasBody) {
       // Make sure we don't end the 0\r\n\r\n at the end of the message.
       this.chunkedEncoding = false;
     } else if (!this.useChunkedEncodingByDefault) {
       this._last = true;
     } else {
-      if (!state.sentTrailer &&
+      if ((flags & kSentTrailer) === 0 &&
           !this._removedHeader['content-length'] &&
           typeof this._contentLength === 'number') {
-        state.messageHeader += 'Content-Length: ' + this._contentLength +
-                               '\r\n';
+        messageHeader += 'Content-Length: ' + this._contentLength + '\r\n';
       } else if (!this._removedHeader['transfer-encoding']) {
-        state.messageHeader += 'Transfer-Encoding: chunked\r\n';
+        messageHeader += 'Transfer-Encoding: chunked\r\n';
         this.chunkedEncoding = true;
       } else {
         // We should only be able to get here if both Content-Length and
@@ -284,45 +283,14 @@ OutgoingMessage.prototype._storeHeader = function(firstLine, headers) {
     }
   }
 
-  this._header = state.messageHeader + CRLF;
+  this._header = messageHeader + CRLF;
   this._headerSent = false;
 
   // wait until the first body chunk, or close(), is sent to flush,
   // UNLESS we're sending Expect: 100-continue.
-  if (state.sentExpect) this._send('');
+  if (flags & kSentExpect) this._send('');
 };
 
-function storeHeader(self, state, field, value) {
-  // Protect against response splitting. The if statement is there to
-  // minimize the performance impact in the common case.
-  if (/[\r\n]/.test(value))
-    value = value.replace(/[\r\n]+[ \t]*/g, '');
-
-  state.messageHeader += field + ': ' + value + CRLF;
-
-  if (connectionExpression.test(field)) {
-    state.sentConnectionHeader = true;
-    if (closeExpression.test(value)) {
-      self._last = true;
-    } else {
-      self.shouldKeepAlive = true;
-    }
-
-  } else if (transferEncodingExpression.test(field)) {
-    state.sentTransferEncodingHeader = true;
-    if (chunkExpression.test(value)) self.chunkedEncoding = true;
-
-  } else if (contentLengthExpression.test(field)) {
-    state.sentContentLengthHeader = true;
-  } else if (dateExpression.test(field)) {
-    state.sentDateHeader = true;
-  } else if (expectExpression.test(field)) {
-    state.sentExpect = true;
-  } else if (trailerExpression.test(field)) {
-    state.sentTrailer = true;
-  }
-}
-
 
 OutgoingMessage.prototype.setHeader = function(name, value) {
   if (typeof name !== 'string')
@@ -142,6 +142,96 @@ exports.createSecureContext = function createSecureContext(options, context) {
   return c;
 };
 
+// Feeds an option into the hash of the options, see getSecureContext().
+// Returns false for values createSecureContext() would not accept as they
+// are, such options are not cached.
+function hashOption(hash, name, value) {
+  if (value === undefined || value === null)
+    return true;
+
+  if (Array.isArray(value)) {
+    hash.update(name + '[' + value.length + ']\n');
+    for (var i = 0; i < value.length; i++) {
+      if (!hashOption(hash, name, value[i]))
+        return false;
+    }
+    return true;
+  }
+
+  var type = typeof value;
+  if (type === 'number' || type === 'boolean') {
+    value = new Buffer(String(value));
+  } else if (type === 'string') {
+    value = new Buffer(value);
+  } else if (value instanceof Buffer) {
+    type = 'buffer';
+  } else if (type === 'object' && name === 'key') {
+    return hashOption(hash, 'key.pem', value.pem) &&
+           hashOption(hash, 'key.passphrase', value.passphrase);
+  } else {
+    return false;
+  }
+
+  hash.update(name + ' ' + type + ' ' + value.length + '\n');
+  hash.update(value);
+  return true;
+}
+
+
+function secureContextCacheKey(options) {
+  if (!crypto)
+    crypto = require('crypto');
+
+  var hash = crypto.createHash('sha256');
+  var ciphers = options.ciphers || tls.DEFAULT_CIPHERS;
+  var ecdhCurve = options.ecdhCurve === undefined ? tls.DEFAULT_ECDH_CURVE :
+                                                    options.ecdhCurve;
+  var ok = hashOption(hash, 'secureProtocol', options.secureProtocol) &&
+           hashOption(hash, 'secureOptions', options.secureOptions) &&
+           hashOption(hash, 'honorCipherOrder', !!options.honorCipherOrder) &&
+           hashOption(hash, 'ca', options.ca) &&
+           hashOption(hash, 'cert', options.cert) &&
+           hashOption(hash, 'key', options.key) &&
+           hashOption(hash, 'passphrase', options.passphrase) &&
+           hashOption(hash, 'ciphers', ciphers) &&
+           hashOption(hash, 'ecdhCurve', ecdhCurve) &&
+           hashOption(hash, 'dhparam', options.dhparam) &&
+           hashOption(hash, 'crl', options.crl) &&
+           hashOption(hash, 'sessionIdContext', options.sessionIdContext) &&
+           hashOption(hash, 'pfx', options.pfx) &&
+           hashOption(hash, 'singleUse', !!options.singleUse);
+  return ok ? hash.digest() : null;
+}
+
+
+// Same as createSecureContext() but contexts created from the same options
+// share one native SSL_CTX, see SecureContext::InitFromCache() in
+// src/node_crypto.cc.  The context must not be modified afterwards, it's
+// for the client side of tls.connect().  A tls.createSecureContext() that
+// has been replaced is always called.
+exports.getSecureContext = function getSecureContext(options) {
+  if (tls.createSecureContext !== exports.createSecureContext)
+    return tls.createSecureContext(options);
+
+  if (!options) options = {};
+
+  var key = secureContextCacheKey(options);
+  if (key === null)
+    return exports.createSecureContext(options);
+
+  var c;
+  var context = new NativeSecureContext();
+  if (context.initFromCache(key)) {
+    c = new SecureContext(null, null, context);
+    if (options.singleUse)
+      c.singleUse = true;
+  } else {
+    c = exports.createSecureContext(options);
+    c.context.addToCache(key);
+  }
+  return c;
+};
+
 exports.translatePeerCertificate = function translatePeerCertificate(c) {
   if (!c)
     return null;
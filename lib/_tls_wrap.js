@@ -7,6 +7,7 @@ const tls = require('tls');
 const util = require('util');
 const listenerCount = require('events').listenerCount;
 const common = require('_tls_common');
+const OCSPStapler = require('internal/ocsp_stapler');
 const StreamWrap = require('_stream_wrap').StreamWrap;
 const Duplex = require('stream').Duplex;
 const debug = util.debuglog('tls');
@@ -691,6 +692,17 @@ function Server(/* [options], listener */) {
     sharedCreds.context.setTicketKeys(self.ticketKeys);
   }
 
+  this._ocspStaplers = [];
+  if (self.ocspStapling) {
+    this._ocspStaplers.push(
+        new OCSPStapler(this, sharedCreds.context, self.ocspStapling));
+    this.on('close', function() {
+      self._ocspStaplers.forEach(function(stapler) {
+        stapler.stop();
+      });
+    });
+  }
+
   // constructor call
   net.Server.call(this, function(raw_socket) {
     var socket = new TLSSocket(raw_socket, {
@@ -794,6 +806,7 @@ Server.prototype.setOptions = function(options) {
   if (options.dhparam) this.dhparam = options.dhparam;
   if (options.sessionTimeout) this.sessionTimeout = options.sessionTimeout;
   if (options.ticketKeys) this.ticketKeys = options.ticketKeys;
+  if (options.ocspStapling) this.ocspStapling = options.ocspStapling;
   var secureOptions = options.secureOptions || 0;
   if (options.honorCipherOrder !== undefined)
     this.honorCipherOrder = !!options.honorCipherOrder;
@@ -820,7 +833,11 @@ Server.prototype.addContext = function(servername, context) {
                       servername.replace(/([\.^$+?\-\\[\]{}])/g, '\\$1')
                                 .replace(/\*/g, '[^\.]*') +
                       '$');
-  this._contexts.push([re, tls.createSecureContext(context).context]);
+  var ctx = tls.createSecureContext(context).context;
+  this._contexts.push([re, ctx]);
+
+  if (this.ocspStapling)
+    this._ocspStaplers.push(new OCSPStapler(this, ctx, this.ocspStapling));
 };
 
 function SNICallback(servername, callback) {
@@ -887,7 +904,7 @@ exports.connect = function(/* [port, host], options, cb */) {
                  (options.socket && options.socket._host) ||
                  'localhost',
       NPN = {},
-      context = tls.createSecureContext(options);
+      context = common.getSecureContext(options);
   tls.convertNPNProtocols(options.NPNProtocols, NPN);
 
   var socket = new TLSSocket(options.socket, {
@@ -7,7 +7,6 @@ exports.DEFAULT_ENCODING = 'buffer';
 
 try {
   var binding = process.binding('crypto');
-  var randomBytes = binding.randomBytes;
   var getCiphers = binding.getCiphers;
   var getHashes = binding.getHashes;
 } catch (e) {
@@ -298,15 +297,32 @@ Sign.prototype._write = function(chunk, encoding, callback) {
 
 Sign.prototype.update = Hash.prototype.update;
 
-Sign.prototype.sign = function(options, encoding) {
+Sign.prototype.sign = function(options, encoding, callback) {
   if (!options)
     throw new Error('No key provided to sign');
 
+  if (typeof encoding === 'function') {
+    callback = encoding;
+    encoding = undefined;
+  }
+
   var key = options.key || options;
   var passphrase = options.passphrase || null;
+  encoding = encoding || exports.DEFAULT_ENCODING;
+
+  if (typeof callback === 'function') {
+    this._handle.sign(toBuf(key), null, passphrase, function(err, ret) {
+      if (err)
+        return callback(err);
+      if (encoding && encoding !== 'buffer')
+        ret = ret.toString(encoding);
+      callback(null, ret);
+    });
+    return;
+  }
+
   var ret = this._handle.sign(toBuf(key), null, passphrase);
 
-  encoding = encoding || exports.DEFAULT_ENCODING;
   if (encoding && encoding !== 'buffer')
     ret = ret.toString(encoding);
 
@@ -331,25 +347,40 @@ util.inherits(Verify, stream.Writable);
 Verify.prototype._write = Sign.prototype._write;
 Verify.prototype.update = Sign.prototype.update;
 
-Verify.prototype.verify = function(object, signature, sigEncoding) {
+Verify.prototype.verify = function(object, signature, sigEncoding, callback) {
+  if (typeof sigEncoding === 'function') {
+    callback = sigEncoding;
+    sigEncoding = undefined;
+  }
   sigEncoding = sigEncoding || exports.DEFAULT_ENCODING;
+  if (typeof callback === 'function') {
+    this._handle.verify(toBuf(object),
+                        toBuf(signature, sigEncoding),
+                        null,
+                        callback);
+    return;
+  }
   return this._handle.verify(toBuf(object), toBuf(signature, sigEncoding));
 };
 
 function rsaPublic(method, defaultPadding) {
-  return function(options, buffer) {
+  return function(options, buffer, callback) {
     var key = options.key || options;
     var padding = options.padding || defaultPadding;
     var passphrase = options.passphrase || null;
+    if (typeof callback === 'function')
+      return method(toBuf(key), buffer, padding, passphrase, callback);
     return method(toBuf(key), buffer, padding, passphrase);
   };
 }
 
 function rsaPrivate(method, defaultPadding) {
-  return function(options, buffer) {
+  return function(options, buffer, callback) {
     var key = options.key || options;
     var passphrase = options.passphrase || null;
     var padding = options.padding || defaultPadding;
+    if (typeof callback === 'function')
+      return method(toBuf(key), buffer, padding, passphrase, callback);
     return method(toBuf(key), buffer, padding, passphrase);
   };
 }
@@ -404,6 +435,45 @@ function DiffieHellman(sizeOrKey, keyEncoding, generator, genEncoding) {
 }
 
 
+// Like createDiffieHellman(primeLength[, generator]) but the prime is
+// generated in the thread pool.
+exports.generateDiffieHellman = function(primeLength, generator, callback) {
+  if (typeof generator === 'function') {
+    callback = generator;
+    generator = undefined;
+  }
+
+  // The binding takes 32-bit integers.
+  if (typeof primeLength !== 'number' ||
+      primeLength !== (primeLength | 0) ||
+      primeLength <= 0) {
+    throw new TypeError('primeLength must be a positive 32-bit integer');
+  }
+  if (typeof callback !== 'function')
+    throw new TypeError('callback must be a function');
+
+  if (!generator)
+    generator = DH_GENERATOR;
+  else if (typeof generator !== 'number' || generator !== (generator | 0))
+    throw new TypeError('generator must be a 32-bit integer');
+
+  var handle = new binding.DiffieHellman();
+  handle.generateParameters(primeLength, generator, function(err) {
+    if (err)
+      return callback(err);
+
+    var dh = Object.create(DiffieHellman.prototype);
+    dh._handle = handle;
+    Object.defineProperty(dh, 'verifyError', {
+      enumerable: true,
+      value: handle.verifyError,
+      writable: false
+    });
+    callback(null, dh);
+  });
+};
+
+
 exports.DiffieHellmanGroup =
     exports.createDiffieHellmanGroup =
     exports.getDiffieHellman = DiffieHellmanGroup;
@@ -424,12 +494,32 @@ DiffieHellmanGroup.prototype.generateKeys =
     DiffieHellman.prototype.generateKeys =
     dhGenerateKeys;
 
-function dhGenerateKeys(encoding) {
-  var keys = this._handle.generateKeys();
+function dhGenerateKeys(encoding, callback) {
+  if (typeof encoding === 'function') {
+    callback = encoding;
+    encoding = undefined;
+  }
+
   encoding = encoding || exports.DEFAULT_ENCODING;
-  if (encoding && encoding !== 'buffer')
-    keys = keys.toString(encoding);
-  return keys;
+
+  function encode(keys) {
+    if (encoding && encoding !== 'buffer')
+      keys = keys.toString(encoding);
+    return keys;
+  }
+
+  if (typeof callback === 'function') {
+    var pooled = this._handle.generateKeys(function(err, keys) {
+      if (err)
+        return callback(err);
+      callback(null, encode(keys));
+    });
+    if (pooled !== undefined)
+      process.nextTick(callback, null, encode(pooled));
+    return;
+  }
+
+  return encode(this._handle.generateKeys());
 }
 
 
@@ -529,12 +619,53 @@ ECDH.prototype.setPrivateKey = DiffieHellman.prototype.setPrivateKey;
 ECDH.prototype.setPublicKey = DiffieHellman.prototype.setPublicKey;
 ECDH.prototype.getPrivateKey = DiffieHellman.prototype.getPrivateKey;
 
-ECDH.prototype.generateKeys = function generateKeys(encoding, format) {
+ECDH.prototype.generateKeys = function generateKeys(encoding,
+                                                   format,
+                                                   callback) {
+  if (typeof encoding === 'function') {
+    callback = encoding;
+    encoding = undefined;
+  } else if (typeof format === 'function') {
+    callback = format;
+    format = undefined;
+  }
+
+  if (typeof callback === 'function') {
+    var self = this;
+    var done = function(err) {
+      if (err)
+        return callback(err);
+      var key;
+      try {
+        key = self.getPublicKey(encoding, format);
+      } catch (e) {
+        return callback(e);
+      }
+      callback(null, key);
+    };
+    if (this._handle.generateKeys(done) === true)
+      process.nextTick(done, null);
+    return;
+  }
+
   this._handle.generateKeys();
 
   return this.getPublicKey(encoding, format);
 };
 
+
+// Keeps `size` keys for the curve or modp group `name` ready for
+// ECDH#generateKeys() and DiffieHellmanGroup#generateKeys().
+exports.warmKeyPool = function warmKeyPool(name, size, callback) {
+  if (typeof name !== 'string')
+    throw new TypeError('name must be a string');
+  if (typeof size !== 'number' || size < 0 || size % 1 !== 0)
+    throw new TypeError('size must be a non-negative integer');
+  if (callback !== undefined && typeof callback !== 'function')
+    throw new TypeError('callback must be a function');
+  binding.warmKeyPool(name, size, callback);
+};
+
 ECDH.prototype.getPublicKey = function getPublicKey(encoding, format) {
   var f;
   if (format) {
@@ -647,6 +778,17 @@ exports.setEngine = function setEngine(id, flags) {
   return binding.setEngine(id, flags);
 };
 
+function randomBytes(size, callback) {
+  if (typeof callback !== 'function')
+    return binding.randomBytes(size);
+
+  var result = binding.randomBytes(size, callback);
+  // Served from the pool.
+  if (result instanceof Buffer)
+    return process.nextTick(callback, null, result);
+  return result;
+}
+
 exports.randomBytes = exports.pseudoRandomBytes = randomBytes;
 
 exports.rng = exports.prng = randomBytes;
@@ -20,6 +20,7 @@ const Writable = Stream.Writable;
 
 const kMinPoolSpace = 128;
 const kMaxLength = require('smalloc').kMaxLength;
+const smalloc = require('internal/smalloc');
 
 const O_APPEND = constants.O_APPEND || 0;
 const O_CREAT = constants.O_CREAT || 0;
@@ -127,14 +128,80 @@ fs.Stats = function(
   this.ino = ino;
   this.size = size;
   this.blocks = blocks;
-  this.atime = new Date(atim_msec);
-  this.mtime = new Date(mtim_msec);
-  this.ctime = new Date(ctim_msec);
-  this.birthtime = new Date(birthtim_msec);
+  Object.defineProperty(this, '_statTimes', {
+    value: [atim_msec, mtim_msec, ctim_msec, birthtim_msec]
+  });
+  Object.defineProperties(this, statsTimeDescriptors);
+};
+
+// The dates are own enumerable properties, like the other fields, but the
+// Date objects are only created when somebody reads them: most callers
+// just want the size or the mode.  The first read or an assignment turns
+// the accessor into a plain data property.
+function setStatsTime(stats, name, value) {
+  Object.defineProperty(stats, name, {
+    value: value,
+    enumerable: true,
+    configurable: true,
+    writable: true
+  });
+}
+
+function statsTimeDescriptor(name, index) {
+  return {
+    enumerable: true,
+    configurable: true,
+    get: function() {
+      var date = new Date(this._statTimes[index]);
+      setStatsTime(this, name, date);
+      return date;
+    },
+    set: function(value) {
+      setStatsTime(this, name, value);
+    }
+  };
+}
+
+const statsTimeDescriptors = {
+  atime: statsTimeDescriptor('atime', 0),
+  mtime: statsTimeDescriptor('mtime', 1),
+  ctime: statsTimeDescriptor('ctime', 2),
+  birthtime: statsTimeDescriptor('birthtime', 3)
 };
 
+// util.inspect() would show the dates that haven't been read yet as
+// [Getter/Setter].
+fs.Stats.prototype.inspect = function() {
+  var copy = {};
+  var keys = Object.keys(this);
+  for (var i = 0; i < keys.length; i++)
+    copy[keys[i]] = this[keys[i]];
+  return copy;
+};
+
+// stat(), lstat() and fstat() store their result here, in fs.Stats
+// constructor order, rather than creating an object on every call.
+const statValues = smalloc.alloc(binding.kStatFieldCount,
+                                 smalloc.Types.Double);
+
 // Create a C++ binding to the function which creates a Stats object.
-binding.FSInitialize(fs.Stats);
+binding.FSInitialize(fs.Stats, statValues);
+
+function statsFromValues() {
+  var s = statValues;
+  return new fs.Stats(s[0], s[1], s[2], s[3], s[4], s[5],
+                      isWindows ? undefined : s[6],
+                      s[7], s[8],
+                      isWindows ? undefined : s[9],
+                      s[10], s[11], s[12], s[13]);
+}
+
+function makeStatsCallback(callback) {
+  return function(err) {
+    if (err) return callback(err);
+    callback(null, statsFromValues());
+  };
+}
 
 fs.Stats.prototype._checkModeProperty = function(property) {
   return ((this.mode & constants.S_IFMT) === property);
@@ -314,12 +381,14 @@ function readFileAfterOpen(err, fd) {
   binding.fstat(fd, req);
 }
 
-function readFileAfterStat(err, st) {
+function readFileAfterStat(err) {
   var context = this.context;
 
   if (err)
     return context.close(err);
 
+  var st = statsFromValues();
+
   var size = context.size = st.isFile() ? st.size : 0;
 
   if (size === 0) {
@@ -810,9 +879,77 @@ fs.readdirSync = function(path) {
   return binding.readdir(pathModule._makeLong(path));
 };
 
+// Result of fs.scandir().  `types` holds a dirent type per name and
+// `stats`, when requested, binding.kStatFieldCount numbers per name in
+// fs.Stats constructor order.  Both are external arrays so that large
+// listings don't cost an object per entry.
+function DirEntries(names, types, stats) {
+  this.names = names;
+  this.types = types;
+  this.stats = stats;
+}
+fs.DirEntries = DirEntries;
+
+DirEntries.prototype.isFile = function(i) {
+  return this.types[i] === binding.UV_DIRENT_FILE;
+};
+
+DirEntries.prototype.isDirectory = function(i) {
+  return this.types[i] === binding.UV_DIRENT_DIR;
+};
+
+DirEntries.prototype.isSymbolicLink = function(i) {
+  return this.types[i] === binding.UV_DIRENT_LINK;
+};
+
+DirEntries.prototype.getStats = function(i) {
+  if (this.stats === undefined)
+    throw new Error('scandir was called without the stats option');
+  var s = this.stats;
+  var o = i * binding.kStatFieldCount;
+  return new fs.Stats(s[o], s[o + 1], s[o + 2], s[o + 3], s[o + 4],
+                      s[o + 5],
+                      isWindows ? undefined : s[o + 6],
+                      s[o + 7], s[o + 8],
+                      isWindows ? undefined : s[o + 9],
+                      s[o + 10], s[o + 11], s[o + 12], s[o + 13]);
+};
+
+function makeDirEntries(result) {
+  return new DirEntries(result[0], result[1], result[2]);
+}
+
+fs.scandir = function(path, options, callback_) {
+  var callback = maybeCallback(arguments[arguments.length - 1]);
+  if (!options || typeof options === 'function')
+    options = {};
+  if (!nullCheck(path, callback)) return;
+  var req = new FSReqWrap();
+  req.oncomplete = function(err, result) {
+    if (err) return callback(err);
+    callback(null, makeDirEntries(result));
+  };
+  var err = binding.walkdir(pathModule._makeLong(path),
+                            !!options.stats,
+                            !!options.recursive,
+                            req);
+  // The walk could not even be started, don't call back synchronously.
+  if (err !== undefined)
+    process.nextTick(callback, err);
+};
+
+fs.scandirSync = function(path, options) {
+  if (!options)
+    options = {};
+  nullCheck(path);
+  return makeDirEntries(binding.walkdir(pathModule._makeLong(path),
+                                        !!options.stats,
+                                        !!options.recursive));
+};
+
 fs.fstat = function(fd, callback) {
   var req = new FSReqWrap();
-  req.oncomplete = makeCallback(callback);
+  req.oncomplete = makeStatsCallback(makeCallback(callback));
   binding.fstat(fd, req);
 };
 
@@ -820,7 +957,7 @@ fs.lstat = function(path, callback) {
   callback = makeCallback(callback);
   if (!nullCheck(path, callback)) return;
   var req = new FSReqWrap();
-  req.oncomplete = callback;
+  req.oncomplete = makeStatsCallback(callback);
   binding.lstat(pathModule._makeLong(path), req);
 };
 
@@ -828,22 +965,25 @@ fs.stat = function(path, callback) {
   callback = makeCallback(callback);
   if (!nullCheck(path, callback)) return;
   var req = new FSReqWrap();
-  req.oncomplete = callback;
+  req.oncomplete = makeStatsCallback(callback);
   binding.stat(pathModule._makeLong(path), req);
 };
 
 fs.fstatSync = function(fd) {
-  return binding.fstat(fd);
+  binding.fstat(fd);
+  return statsFromValues();
 };
 
 fs.lstatSync = function(path) {
   nullCheck(path);
-  return binding.lstat(pathModule._makeLong(path));
+  binding.lstat(pathModule._makeLong(path));
+  return statsFromValues();
 };
 
 fs.statSync = function(path) {
   nullCheck(path);
-  return binding.stat(pathModule._makeLong(path));
+  binding.stat(pathModule._makeLong(path));
+  return statsFromValues();
 };
 
 fs.readlink = function(path, callback) {
@@ -0,0 +1,46 @@
+'use strict';
+
+// Native resources by provider type, see Environment::AsyncWrapStats in
+// src/env.h.  The binding keeps the counts in `fields` up to date, reading
+// them is free.
+
+const binding = process.binding('async_wrap');
+
+const fields = {};
+binding.setupStats(fields);
+
+const kLive = binding.kLive;
+const kCreated = binding.kCreated;
+const kDestroyed = binding.kDestroyed;
+const kNativeBytes = binding.kNativeBytes;
+const kFieldsCount = binding.kFieldsCount;
+
+const names = new Array(binding.kProvidersLength);
+Object.keys(binding.Providers).forEach(function(name) {
+  names[binding.Providers[name]] = name;
+});
+
+
+// Returns the counts of every provider type that has been used so far.
+// With `nativeBytes` set the native memory held by the live objects is
+// added; that walks all of them.
+exports.get = function(nativeBytes) {
+  if (nativeBytes)
+    binding.updateNativeBytes();
+
+  var result = {};
+  for (var i = 0; i < names.length; i++) {
+    var o = i * kFieldsCount;
+    if (fields[o + kCreated] === 0)
+      continue;
+    var stats = {
+      live: fields[o + kLive],
+      created: fields[o + kCreated],
+      destroyed: fields[o + kDestroyed]
+    };
+    if (nativeBytes)
+      stats.nativeBytes = fields[o + kNativeBytes];
+    result[names[i]] = stats;
+  }
+  return result;
+};
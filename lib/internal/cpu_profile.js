@@ -0,0 +1,329 @@
+'use strict';
+
+// A CPU profile as returned by v8.stopCpuProfiling().  src/node_v8.cc hands
+// over the call tree flattened in pre-order; this turns it into the
+// .cpuprofile format Chrome DevTools loads, or into a compact binary format,
+// and writes either to a stream in chunks so a large profile does not block
+// the event loop.
+//
+// The binary format is little endian:
+//
+//   char     magic[8]       "NODECPUP"
+//   uint32   version        1
+//   uint32   nodeCount
+//   uint32   sampleCount
+//   double   startTime      microseconds
+//   double   endTime        microseconds
+//   node     nodes[nodeCount]       pre-order
+//   uint32   samples[sampleCount]   node ids
+//   double   timestamps[sampleCount]
+//
+// where every node is
+//
+//   uint32   id
+//   int32    scriptId
+//   int32    lineNumber
+//   int32    columnNumber
+//   uint32   hitCount
+//   uint32   callUID
+//   uint32   childCount
+//   string   functionName, url, deoptReason
+//
+// and strings are a uint32 byte length followed by UTF-8 data.
+
+const binding = process.binding('v8');
+
+const kFields = binding.kCpuProfileNodeFieldsCount;
+const kId = binding.kCpuProfileNodeIdIndex;
+const kScriptId = binding.kCpuProfileNodeScriptIdIndex;
+const kLine = binding.kCpuProfileNodeLineIndex;
+const kColumn = binding.kCpuProfileNodeColumnIndex;
+const kHitCount = binding.kCpuProfileNodeHitCountIndex;
+const kCallUid = binding.kCpuProfileNodeCallUidIndex;
+const kChildCount = binding.kCpuProfileNodeChildCountIndex;
+
+const kMagic = 'NODECPUP';
+const kVersion = 1;
+const kHeaderSize = 36;
+const kNodeSize = 28;
+
+// Roughly how much output to produce before yielding to the event loop.
+const kChunkSize = 64 * 1024;
+
+
+function CpuProfile(raw) {
+  this.title = raw.title;
+  this.startTime = raw.startTime;
+  this.endTime = raw.endTime;
+  this.nodeCount = raw.names.length;
+  this.sampleCount = raw.sampleCount;
+  this._raw = raw;
+}
+
+
+function nodeJSON(raw, i) {
+  var f = raw.nodes;
+  var o = i * kFields;
+  return {
+    functionName: raw.names[i],
+    scriptId: f[o + kScriptId],
+    url: raw.urls[i],
+    lineNumber: f[o + kLine],
+    columnNumber: f[o + kColumn],
+    hitCount: f[o + kHitCount],
+    callUID: f[o + kCallUid],
+    children: [],
+    deoptReason: raw.bailouts[i],
+    id: f[o + kId]
+  };
+}
+
+
+function copyArray(array, length) {
+  var result = new Array(length);
+  for (var i = 0; i < length; i++)
+    result[i] = array[i];
+  return result;
+}
+
+
+// Returns the profile in the .cpuprofile format.
+CpuProfile.prototype.toJSON = function() {
+  var raw = this._raw;
+  var head = null;
+  var parents = [];
+  var remaining = [];
+
+  for (var i = 0; i < this.nodeCount; i++) {
+    var node = nodeJSON(raw, i);
+    if (head === null) {
+      head = node;
+    } else {
+      var top = parents.length - 1;
+      parents[top].children.push(node);
+      if (--remaining[top] === 0) {
+        parents.pop();
+        remaining.pop();
+      }
+    }
+
+    var childCount = raw.nodes[i * kFields + kChildCount];
+    if (childCount > 0) {
+      parents.push(node);
+      remaining.push(childCount);
+    }
+  }
+
+  return {
+    typeId: 'CPU',
+    uid: 1,
+    title: this.title,
+    head: head,
+    startTime: this.startTime / 1e6,
+    endTime: this.endTime / 1e6,
+    samples: copyArray(raw.samples, this.sampleCount),
+    timestamps: copyArray(raw.timestamps, this.sampleCount)
+  };
+};
+
+
+function JSONWriter(profile) {
+  this.profile = profile;
+  this.index = 0;
+  this.remaining = [];
+  this.state = 0;
+}
+
+// Produces the next piece of the .cpuprofile JSON or null when done.  The
+// tree is written node by node; children arrays are closed as the child
+// counts run out.
+JSONWriter.prototype.next = function() {
+  var profile = this.profile;
+  var raw = profile._raw;
+  var out = '';
+
+  if (this.state === 0) {
+    out = '{"typeId":"CPU","uid":1,"title":' + JSON.stringify(profile.title) +
+          ',"head":';
+    this.state = 1;
+    if (profile.nodeCount === 0)
+      out += 'null';
+  }
+
+  if (this.state === 1) {
+    while (this.index < profile.nodeCount && out.length < kChunkSize) {
+      var i = this.index++;
+      var node = nodeJSON(raw, i);
+      var childCount = raw.nodes[i * kFields + kChildCount];
+      var json = JSON.stringify(node);
+      // Leave "children":[ open, it is closed after the last descendant.
+      var children = json.indexOf('"children":[]');
+      out += json.slice(0, children + 12);
+      if (childCount > 0) {
+        this.remaining.push({
+          count: childCount,
+          tail: json.slice(children + 12)
+        });
+        continue;
+      }
+      out += json.slice(children + 12);
+      // Close every parent whose last child this was.
+      while (this.remaining.length > 0) {
+        var top = this.remaining[this.remaining.length - 1];
+        if (--top.count > 0) {
+          out += ',';
+          break;
+        }
+        out += top.tail;
+        this.remaining.pop();
+      }
+    }
+    if (this.index < profile.nodeCount)
+      return out;
+    this.state = 2;
+    this.index = 0;
+    out += ',"startTime":' + profile.startTime / 1e6 +
+           ',"endTime":' + profile.endTime / 1e6 + ',"samples":[';
+  }
+
+  if (this.state === 2 || this.state === 3) {
+    var array = this.state === 2 ? raw.samples : raw.timestamps;
+    while (this.index < profile.sampleCount && out.length < kChunkSize) {
+      if (this.index > 0) out += ',';
+      out += array[this.index++];
+    }
+    if (this.index < profile.sampleCount)
+      return out;
+    this.index = 0;
+    if (this.state++ === 2)
+      return out + '],"timestamps":[';
+    return out + ']}';
+  }
+
+  return null;
+};
+
+
+function BinaryWriter(profile) {
+  this.profile = profile;
+  this.index = 0;
+  this.state = 0;
+}
+
+BinaryWriter.prototype.next = function() {
+  var profile = this.profile;
+  var raw = profile._raw;
+
+  if (this.state === 0) {
+    this.state = 1;
+    var header = new Buffer(kHeaderSize);
+    header.write(kMagic, 0, 'binary');
+    header.writeUInt32LE(kVersion, 8);
+    header.writeUInt32LE(profile.nodeCount, 12);
+    header.writeUInt32LE(profile.sampleCount, 16);
+    header.writeDoubleLE(profile.startTime, 20);
+    header.writeDoubleLE(profile.endTime, 28);
+    return header;
+  }
+
+  if (this.state === 1) {
+    var chunks = [];
+    var size = 0;
+    while (this.index < profile.nodeCount && size < kChunkSize) {
+      var i = this.index++;
+      var o = i * kFields;
+      var name = new Buffer(raw.names[i], 'utf8');
+      var url = new Buffer(raw.urls[i], 'utf8');
+      var bailout = new Buffer(raw.bailouts[i], 'utf8');
+      var b = new Buffer(kNodeSize + 12 + name.length + url.length +
+                         bailout.length);
+      b.writeUInt32LE(raw.nodes[o + kId], 0);
+      b.writeInt32LE(raw.nodes[o + kScriptId], 4);
+      b.writeInt32LE(raw.nodes[o + kLine], 8);
+      b.writeInt32LE(raw.nodes[o + kColumn], 12);
+      b.writeUInt32LE(raw.nodes[o + kHitCount], 16);
+      b.writeUInt32LE(raw.nodes[o + kCallUid], 20);
+      b.writeUInt32LE(raw.nodes[o + kChildCount], 24);
+      var offset = kNodeSize;
+      [name, url, bailout].forEach(function(s) {
+        b.writeUInt32LE(s.length, offset);
+        s.copy(b, offset + 4);
+        offset += 4 + s.length;
+      });
+      chunks.push(b);
+      size += b.length;
+    }
+    if (this.index === profile.nodeCount) {
+      this.state = 2;
+      this.index = 0;
+    }
+    return Buffer.concat(chunks, size);
+  }
+
+  if (this.state === 2) {
+    this.state = 3;
+    var n = profile.sampleCount;
+    var samples = new Buffer(n * 12);
+    for (var k = 0; k < n; k++) {
+      samples.writeUInt32LE(raw.samples[k], k * 4);
+      samples.writeDoubleLE(raw.timestamps[k], n * 4 + k * 8);
+    }
+    return samples;
+  }
+
+  return null;
+};
+
+
+// Writes the profile to `stream` as 'json' (the default) or 'binary'.  The
+// output is produced in chunks; the next one is only produced once the
+// stream has room for it and the event loop had a chance to run.
+CpuProfile.prototype.write = function(stream, format, callback) {
+  if (typeof format === 'function') {
+    callback = format;
+    format = 'json';
+  }
+  if (format === undefined)
+    format = 'json';
+  if (format !== 'json' && format !== 'binary')
+    throw new TypeError('format must be "json" or "binary"');
+
+  var writer = format === 'json' ? new JSONWriter(this) :
+                                   new BinaryWriter(this);
+  var done = false;
+
+  function finish(err) {
+    if (done) return;
+    done = true;
+    stream.removeListener('error', finish);
+    if (callback) callback(err || null);
+  }
+
+  function nextChunk() {
+    var chunk;
+    do {
+      chunk = writer.next();
+    } while (chunk !== null && chunk.length === 0);
+    return chunk;
+  }
+
+  // Stay one chunk ahead so the last write can carry the callback.
+  var pending = nextChunk();
+
+  function pump() {
+    if (done) return;
+    var chunk = pending;
+    pending = nextChunk();
+    if (pending === null)
+      return stream.write(chunk, function() { finish(); });
+    if (!stream.write(chunk))
+      return stream.once('drain', pump);
+    setImmediate(pump);
+  }
+
+  stream.on('error', finish);
+  pump();
+};
+
+
+module.exports = CpuProfile;
@@ -0,0 +1,100 @@
+'use strict';
+
+// Event loop instrumentation, see src/node_loop_metrics.cc.  The binding
+// writes straight into `fields` and `histogram`, reading them is free.
+
+const binding = process.binding('loop_metrics');
+
+const fields = {};
+const histogram = {};
+binding.setup(fields, histogram);
+
+const kLinearBuckets = binding.kHistogramLinearBuckets;
+const kSubBucketBits = binding.kHistogramSubBucketBits;
+const kSubBuckets = 1 << kSubBucketBits;
+const kBuckets = binding.kHistogramBuckets;
+
+var enabled = false;
+
+
+// Largest value in microseconds that is counted in the given bucket.
+function bucketLimit(index) {
+  if (index < kLinearBuckets)
+    return index;
+  var exponent = 4 + ((index - kLinearBuckets) >> kSubBucketBits);
+  var subBucket = (index - kLinearBuckets) & (kSubBuckets - 1);
+  var shift = exponent - kSubBucketBits;
+  return (kSubBuckets + subBucket + 1) * Math.pow(2, shift) - 1;
+}
+
+
+function percentile(total, p) {
+  var rank = Math.ceil(total * p);
+  var seen = 0;
+  for (var i = 0; i < kBuckets; i++) {
+    seen += histogram[i];
+    if (seen >= rank && seen > 0)
+      return bucketLimit(i) / 1e3;
+  }
+  return 0;
+}
+
+
+exports.start = function() {
+  enabled = true;
+  binding.start();
+};
+
+
+exports.stop = function() {
+  enabled = false;
+  binding.stop();
+};
+
+
+exports.reset = binding.reset;
+
+
+// Times are in milliseconds.  `latency` is the distribution of the time the
+// loop was busy per iteration.
+exports.get = function() {
+  var iterations = fields[binding.kIterations];
+  var loopTime = fields[binding.kLoopTime] / 1e6;
+  var idleTime = fields[binding.kIdleTime] / 1e6;
+  var ioTime = fields[binding.kIOTime] / 1e6;
+  var immediateTime = fields[binding.kImmediateTime] / 1e6;
+
+  return {
+    enabled: enabled,
+    iterations: iterations,
+    loopTime: loopTime,
+    idleTime: idleTime,
+    ioTime: ioTime,
+    immediateTime: immediateTime,
+    otherTime: Math.max(0, loopTime - idleTime - ioTime - immediateTime),
+    utilization: loopTime > 0 ? 1 - idleTime / loopTime : 0,
+    latency: {
+      mean: iterations > 0 ? (loopTime - idleTime) / iterations : 0,
+      p50: percentile(iterations, 0.5),
+      p90: percentile(iterations, 0.9),
+      p99: percentile(iterations, 0.99),
+      p999: percentile(iterations, 0.999),
+      max: percentile(iterations, 1)
+    },
+    histogram: copyHistogram()
+  };
+};
+
+
+// Iteration counts of the non-empty buckets, along with the upper limit of
+// each bucket in microseconds.
+function copyHistogram() {
+  var counts = [];
+  var limits = [];
+  for (var i = 0; i < kBuckets; i++) {
+    if (histogram[i] === 0) continue;
+    counts.push(histogram[i]);
+    limits.push(bucketLimit(i));
+  }
+  return { counts: counts, limits: limits };
+}
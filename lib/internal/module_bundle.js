@@ -0,0 +1,112 @@
+'use strict';
+
+// Module bundles: one file holding the sources of many modules, see
+// src/node_bundle.cc for the format.  The file is mapped into memory and
+// ASCII sources are served without copying them.
+
+const binding = process.binding('bundle');
+const fs = require('fs');
+const path = require('path');
+
+const kMagic = 'NODEBNDL';
+const kHeaderSize = 16;
+const kEntrySize = 20;
+
+
+function Bundle(filename) {
+  this._native = new binding.ModuleBundle(filename);
+  this._files = {};
+  this._dirs = {};
+
+  var paths = this._native.paths();
+  for (var i = 0; i < paths.length; i++) {
+    var p = paths[i];
+    this._files[p] = i;
+    for (var dir = path.dirname(p); !(dir in this._dirs); ) {
+      this._dirs[dir] = true;
+      var parent = path.dirname(dir);
+      if (parent === dir) break;
+      dir = parent;
+    }
+  }
+}
+
+
+Bundle.prototype.has = function(filename) {
+  return filename in this._files;
+};
+
+
+// Same return values as internalModuleStat(): 0 for a file, 1 for a
+// directory, negative if the bundle has nothing at that path.
+Bundle.prototype.stat = function(filename) {
+  if (filename in this._files) return 0;
+  if (filename in this._dirs) return 1;
+  return -1;
+};
+
+
+// Returns the source of a bundled file or undefined.
+Bundle.prototype.read = function(filename) {
+  var index = this._files[filename];
+  if (index === undefined) return undefined;
+  return this._native.source(index);
+};
+
+
+exports.load = function(filename) {
+  return new Bundle(path.resolve(filename));
+};
+
+
+function isAscii(buf) {
+  for (var i = 0; i < buf.length; i++) {
+    if (buf[i] > 127) return false;
+  }
+  return true;
+}
+
+
+// Writes the files at the given paths into a new bundle.  They are stored
+// under their absolute paths.  The bundle is written to a temporary file
+// that is renamed over `filename`, processes that have the old one mapped
+// keep seeing its contents.
+exports.write = function(filename, files) {
+  var count = files.length;
+  var paths = new Array(count);
+  var sources = new Array(count);
+  var offset = kHeaderSize + count * kEntrySize;
+
+  var header = new Buffer(offset);
+  header.write(kMagic, 0, 'binary');
+  header.writeUInt32LE(binding.kVersion, 8);
+  header.writeUInt32LE(count, 12);
+
+  for (var i = 0; i < count; i++) {
+    paths[i] = new Buffer(path.resolve(files[i]), 'utf8');
+    sources[i] = fs.readFileSync(files[i]);
+
+    var entry = kHeaderSize + i * kEntrySize;
+    header.writeUInt32LE(offset, entry);
+    header.writeUInt32LE(paths[i].length, entry + 4);
+    offset += paths[i].length;
+    header.writeUInt32LE(offset, entry + 8);
+    header.writeUInt32LE(sources[i].length, entry + 12);
+    offset += sources[i].length;
+    header.writeUInt32LE(isAscii(sources[i]) ? binding.kSourceIsAscii : 0,
+                         entry + 16);
+  }
+
+  var chunks = [header];
+  for (i = 0; i < count; i++) {
+    chunks.push(paths[i], sources[i]);
+  }
+  var tmpname = filename + '.' + process.pid + '.tmp';
+  try {
+    fs.writeFileSync(tmpname, Buffer.concat(chunks, offset));
+    fs.renameSync(tmpname, filename);
+  } catch (err) {
+    try { fs.unlinkSync(tmpname); } catch (e) {}
+    throw err;
+  }
+};
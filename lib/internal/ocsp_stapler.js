@@ -0,0 +1,136 @@
+'use strict';
+
+// Keeps an OCSP response stapled to a server's SecureContext, see the
+// ocspStapling option of tls.createServer().  The response is stored in the
+// native context, handshakes staple it without calling into JS.  It is
+// fetched again halfway to its nextUpdate and, after a failed fetch, every
+// minute until a fetch succeeds.  The old response is served until it
+// expires.
+
+const url = require('url');
+
+const kRetryDelay = 60 * 1000;
+// For responses without a nextUpdate.
+const kDefaultRefreshDelay = 60 * 60 * 1000;
+const kMinRefreshDelay = 1000;
+// Longest delay setTimeout() supports.
+const kMaxDelay = 0x7fffffff;
+
+
+function OCSPStapler(server, context, fetcher) {
+  this.server = server;
+  this.context = context;
+  this.fetcher = typeof fetcher === 'function' ? fetcher : null;
+  this.stopped = false;
+  // Give the caller a chance to listen for the first response.
+  this.timer = setTimeout(this.refresh.bind(this), 0);
+  this.timer.unref();
+}
+
+
+OCSPStapler.prototype.refresh = function() {
+  var self = this;
+  var context = this.context;
+  var once = false;
+
+  this.timer = null;
+
+  if (this.fetcher)
+    this.fetcher(context.getCertificate(), context.getIssuer(), done);
+  else
+    fetchOCSPResponse(context, done);
+
+  function done(err, response) {
+    if (once || self.stopped)
+      return;
+    once = true;
+
+    var nextUpdate;
+    if (!err && !(response instanceof Buffer))
+      err = new TypeError('OCSP response must be a Buffer');
+    if (!err) {
+      try {
+        nextUpdate = context.setOCSPStaple(response);
+      } catch (e) {
+        err = e;
+      }
+    }
+
+    if (err) {
+      self.schedule(kRetryDelay);
+      self.server.emit('OCSPStapleError', err);
+      return;
+    }
+
+    if (nextUpdate > 0)
+      self.schedule((nextUpdate - Date.now()) / 2);
+    else
+      self.schedule(kDefaultRefreshDelay);
+    self.server.emit('OCSPStaple',
+                     response,
+                     nextUpdate > 0 ? new Date(nextUpdate) : null);
+  }
+};
+
+
+OCSPStapler.prototype.schedule = function(delay) {
+  if (this.stopped)
+    return;
+  delay = Math.min(Math.max(delay, kMinRefreshDelay), kMaxDelay);
+  this.timer = setTimeout(this.refresh.bind(this), delay);
+  this.timer.unref();
+};
+
+
+OCSPStapler.prototype.stop = function() {
+  this.stopped = true;
+  if (this.timer !== null)
+    clearTimeout(this.timer);
+  this.timer = null;
+};
+
+
+// The default fetcher: posts an OCSP request to the responder named in the
+// certificate.
+function fetchOCSPResponse(context, callback) {
+  var request = context.getOCSPRequest();
+  if (request === null) {
+    return process.nextTick(callback,
+                            new Error('Certificate has no OCSP responder'));
+  }
+
+  var options = url.parse(request[0]);
+  if (options.protocol !== 'http:') {
+    return process.nextTick(callback,
+                            new Error('Unsupported OCSP responder URL: ' +
+                                      request[0]));
+  }
+  options.method = 'POST';
+  options.headers = {
+    'Content-Type': 'application/ocsp-request',
+    'Content-Length': request[1].length
+  };
+
+  var req = require('http').request(options, function(res) {
+    if (res.statusCode !== 200) {
+      res.resume();
+      return callback(new Error('OCSP responder replied with status ' +
+                                res.statusCode));
+    }
+    var chunks = [];
+    var length = 0;
+    res.on('data', function(chunk) {
+      chunks.push(chunk);
+      length += chunk.length;
+    });
+    res.on('end', function() {
+      callback(null, Buffer.concat(chunks, length));
+    });
+    res.on('error', callback);
+  });
+  req.on('error', callback);
+  req.end(request[1]);
+}
+
+
+module.exports = OCSPStapler;
@@ -8,6 +8,8 @@ const fs = require('fs');
 const path = require('path');
 const internalModuleReadFile = process.binding('fs').internalModuleReadFile;
 const internalModuleStat = process.binding('fs').internalModuleStat;
+const ModuleResolver = process.binding('fs').ModuleResolver;
+const moduleBundle = require('internal/module_bundle');
 
 
 // If obj.hasOwnProperty has been overridden, then calling
@@ -34,6 +36,11 @@ module.exports = Module;
 
 Module._cache = {};
 Module._pathCache = {};
+// Does the file system probing for _findPath() and caches package.json
+// lookups.  Assign a new instance to reset it.
+Module._resolver = new ModuleResolver();
+// Set by Module._loadBundle(), files in it take precedence over the disk.
+var bundle = null;
 Module._extensions = {};
 var modulePaths = [];
 Module.globalPaths = [];
@@ -67,7 +74,7 @@ function readPackage(requestPath) {
   }
 
   var jsonPath = path.resolve(requestPath, 'package.json');
-  var json = internalModuleReadFile(jsonPath);
+  var json = readModuleFile(jsonPath);
 
   if (json === undefined) {
     return false;
@@ -100,14 +107,39 @@ Module._realpathCache = {};
 
 // check if the file exists and is not a directory
 function tryFile(requestPath) {
-  const rc = internalModuleStat(requestPath);
+  const rc = moduleStat(requestPath);
   return rc === 0 && toRealPath(requestPath);
 }
 
 function toRealPath(requestPath) {
+  // Bundles store real paths.
+  if (bundle !== null && bundle.has(requestPath))
+    return requestPath;
   return fs.realpathSync(requestPath, Module._realpathCache);
 }
 
+function moduleStat(filename) {
+  if (bundle !== null) {
+    var rc = bundle.stat(filename);
+    if (rc >= 0) return rc;
+  }
+  return internalModuleStat(filename);
+}
+
+// Returns the contents of a file, or undefined when it cannot be read.
+function readModuleFile(filename) {
+  if (bundle !== null) {
+    var source = bundle.read(filename);
+    if (source !== undefined) return stripBOM(source);
+  }
+  return internalModuleReadFile(filename);
+}
+
+function readModuleSource(filename) {
+  var source = bundle !== null ? bundle.read(filename) : undefined;
+  return source !== undefined ? source : fs.readFileSync(filename, 'utf8');
+}
+
 // given a path check a the file exists with any of the set extensions
 function tryExtensions(p, exts) {
   for (var i = 0, EL = exts.length; i < EL; i++) {
@@ -126,27 +158,16 @@ const noopDeprecateRequireDot = util.deprecate(function() {},
     'This functionality is deprecated and will be removed soon.');
 
 
-Module._findPath = function(request, paths) {
-  var exts = Object.keys(Module._extensions);
-
-  if (request.charAt(0) === '/') {
-    paths = [''];
-  }
-
-  var trailingSlash = (request.slice(-1) === '/');
-
-  var cacheKey = JSON.stringify({request: request, paths: paths});
-  if (Module._pathCache[cacheKey]) {
-    return Module._pathCache[cacheKey];
-  }
-
-  // For each path
-  for (var i = 0, PL = paths.length; i < PL; i++) {
-    var basePath = path.resolve(paths[i], request);
+// Slow path of Module._findPath(), used when a bundle is loaded or when the
+// native resolver runs into a package.json it doesn't understand.  Returns
+// the index of the search path that matched and the real path of the file.
+function findPathInJS(basePaths, exts, trailingSlash) {
+  for (var i = 0, PL = basePaths.length; i < PL; i++) {
+    var basePath = basePaths[i];
     var filename;
 
     if (!trailingSlash) {
-      const rc = internalModuleStat(basePath);
+      const rc = moduleStat(basePath);
       if (rc === 0) {  // File.
         filename = toRealPath(basePath);
       } else if (rc === 1) {  // Directory.
@@ -169,13 +190,55 @@ Module._findPath = function(request, paths) {
     }
 
     if (filename) {
-      // Warn once if '.' resolved outside the module dir
-      if (request === '.' && i > 0) noopDeprecateRequireDot();
-      Module._pathCache[cacheKey] = filename;
-      return filename;
+      return [i, filename];
     }
   }
   return false;
+}
+
+Module._findPath = function(request, paths) {
+  var exts = Object.keys(Module._extensions);
+
+  if (request.charAt(0) === '/') {
+    paths = [''];
+  }
+
+  var trailingSlash = (request.slice(-1) === '/');
+
+  var cacheKey = JSON.stringify({request: request, paths: paths});
+  if (Module._pathCache[cacheKey]) {
+    return Module._pathCache[cacheKey];
+  }
+
+  var basePaths = new Array(paths.length);
+  for (var i = 0, PL = paths.length; i < PL; i++) {
+    basePaths[i] = path.resolve(paths[i], request);
+  }
+
+  var found;
+  if (bundle !== null) {
+    // The native resolver only knows about the file system.
+    found = findPathInJS(basePaths, exts, trailingSlash);
+  } else {
+    found = Module._resolver.resolve(basePaths, exts, trailingSlash);
+    if (typeof found === 'string') {
+      // A package.json or path the native resolver can't handle.  Let
+      // readPackage() throw if it's malformed, otherwise repeat the search
+      // in JS.
+      readPackage(found);
+      found = findPathInJS(basePaths, exts, trailingSlash);
+    } else if (found) {
+      found[1] = toRealPath(found[1]);
+    }
+  }
+
+  if (found) {
+    // Warn once if '.' resolved outside the module dir
+    if (request === '.' && found[0] > 0) noopDeprecateRequireDot();
+    Module._pathCache[cacheKey] = found[1];
+    return found[1];
+  }
+  return false;
 };
 
 // 'from' is the __dirname of the module.
@@ -440,14 +503,14 @@ function stripBOM(content) {
 
 // Native extension for .js
 Module._extensions['.js'] = function(module, filename) {
-  var content = fs.readFileSync(filename, 'utf8');
+  var content = readModuleSource(filename);
   module._compile(stripBOM(content), filename);
 };
 
 
 // Native extension for .json
 Module._extensions['.json'] = function(module, filename) {
-  var content = fs.readFileSync(filename, 'utf8');
+  var content = readModuleSource(filename);
   try {
     module.exports = JSON.parse(stripBOM(content));
   } catch (err) {
@@ -519,5 +582,20 @@ Module._preloadModules = function(requests) {
 
 Module._initPaths();
 
+// Module sources from a bundle file are used in place of the files on
+// disk, see lib/internal/module_bundle.js.
+Module._loadBundle = function(filename) {
+  bundle = moduleBundle.load(filename);
+  Module._pathCache = {};
+};
+
+Module._writeBundle = function(filename, files) {
+  moduleBundle.write(filename, files);
+};
+
+if (process.env.NODE_BUNDLE) {
+  Module._loadBundle(process.env.NODE_BUNDLE);
+}
+
 // backwards compatibility
 Module.Module = Module;
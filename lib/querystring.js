@@ -3,6 +3,7 @@
 'use strict';
 
 const QueryString = exports;
+const binding = process.binding('querystring');
 
 
 function charCode(c) {
@@ -77,73 +78,20 @@ QueryString.unescapeBuffer = function(s, decodeSpaces) {
 };
 
 
-QueryString.unescape = function(s, decodeSpaces) {
+function unescape(s, decodeSpaces) {
   try {
     return decodeURIComponent(s);
   } catch (e) {
     return QueryString.unescapeBuffer(s, decodeSpaces).toString();
   }
-};
+}
+QueryString.unescape = unescape;
 
 
-var hexTable = new Array(256);
-for (var i = 0; i < 256; ++i)
-  hexTable[i] = '%' + ((i < 16 ? '0' : '') + i.toString(16)).toUpperCase();
 QueryString.escape = function(str) {
   // replaces encodeURIComponent
   // http://www.ecma-international.org/ecma-262/5.1/#sec-15.1.3.4
-  str = '' + str;
-  var len = str.length;
-  var out = '';
-  var i, c;
-
-  if (len === 0)
-    return str;
-
-  for (i = 0; i < len; ++i) {
-    c = str.charCodeAt(i);
-
-    // These characters do not need escaping (in order):
-    // ! - . _ ~
-    // ' ( ) *
-    // digits
-    // alpha (uppercase)
-    // alpha (lowercase)
-    if (c === 0x21 || c === 0x2D || c === 0x2E || c === 0x5F || c === 0x7E ||
-        (c >= 0x27 && c <= 0x2A) ||
-        (c >= 0x30 && c <= 0x39) ||
-        (c >= 0x41 && c <= 0x5A) ||
-        (c >= 0x61 && c <= 0x7A)) {
-      out += str[i];
-      continue;
-    }
-
-    // Other ASCII characters
-    if (c < 0x80) {
-      out += hexTable[c];
-      continue;
-    }
-
-    // Multi-byte characters ...
-    if (c < 0x800) {
-      out += hexTable[0xC0 | (c >> 6)] + hexTable[0x80 | (c & 0x3F)];
-      continue;
-    }
-    if (c < 0xD800 || c >= 0xE000) {
-      out += hexTable[0xE0 | (c >> 12)] +
-             hexTable[0x80 | ((c >> 6) & 0x3F)] +
-             hexTable[0x80 | (c & 0x3F)];
-      continue;
-    }
-    // Surrogate pair
-    ++i;
-    c = 0x10000 + (((c & 0x3FF) << 10) | (str.charCodeAt(i) & 0x3FF));
-    out += hexTable[0xF0 | (c >> 18)] +
-           hexTable[0x80 | ((c >> 12) & 0x3F)] +
-           hexTable[0x80 | ((c >> 6) & 0x3F)] +
-           hexTable[0x80 | (c & 0x3F)];
-  }
-  return out;
+  return binding.escape('' + str);
 };
 
 var stringifyPrimitive = function(v) {
@@ -207,26 +155,38 @@ QueryString.parse = QueryString.decode = function(qs, sep, eq, options) {
     return obj;
   }
 
-  var regexp = /\+/g;
-  qs = qs.split(sep);
-
   var maxKeys = 1000;
   if (options && typeof options.maxKeys === 'number') {
     maxKeys = options.maxKeys;
   }
 
-  var len = qs.length;
-  // maxKeys <= 0 means that we should not limit keys count
-  if (maxKeys > 0 && len > maxKeys) {
-    len = maxKeys;
-  }
-
   var decode = QueryString.unescape;
   if (options && typeof options.decodeURIComponent === 'function') {
     decode = options.decodeURIComponent;
   }
 
   var keys = [];
+
+  // The native parser implements the default decoding in one pass over the
+  // input.  Custom decoders and non-string separators take the slow path.
+  if (decode === unescape &&
+      typeof sep === 'string' && sep.length > 0 &&
+      typeof eq === 'string' && eq.length > 0) {
+    var pairs = binding.parse(qs, sep, eq, maxKeys);
+    for (var p = 0; p < pairs.length; p += 2)
+      addPair(obj, keys, pairs[p], pairs[p + 1]);
+    return obj;
+  }
+
+  var regexp = /\+/g;
+  qs = qs.split(sep);
+
+  var len = qs.length;
+  // maxKeys <= 0 means that we should not limit keys count
+  if (maxKeys > 0 && len > maxKeys) {
+    len = maxKeys;
+  }
+
   for (var i = 0; i < len; ++i) {
     var x = qs[i].replace(regexp, '%20'),
         idx = x.indexOf(eq),
@@ -240,20 +200,25 @@ QueryString.parse = QueryString.decode = function(qs, sep, eq, options) {
       v = '';
     }
 
-    if (keys.indexOf(k) === -1) {
-      obj[k] = v;
-      keys.push(k);
-    } else if (Array.isArray(obj[k])) {
-      obj[k].push(v);
-    } else {
-      obj[k] = [obj[k], v];
-    }
+    addPair(obj, keys, k, v);
   }
 
   return obj;
 };
 
 
+function addPair(obj, keys, k, v) {
+  if (keys.indexOf(k) === -1) {
+    obj[k] = v;
+    keys.push(k);
+  } else if (Array.isArray(obj[k])) {
+    obj[k].push(v);
+  } else {
+    obj[k] = [obj[k], v];
+  }
+}
+
+
 function decodeStr(s, decoder) {
   try {
     return decoder(s);
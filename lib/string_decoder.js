@@ -1,5 +1,7 @@
 'use strict';
 
+const binding = process.binding('string_decoder');
+
 function assertEncoding(encoding) {
   // Do not cache `Buffer.isEncoding`, some modules monkey-patch it to support
   // additional encodings
@@ -12,8 +14,10 @@ function assertEncoding(encoding) {
 // buffers into a series of JS strings without breaking apart multi-byte
 // characters. CESU-8 is handled as part of the UTF-8 encoding.
 //
-// @TODO Handling all encodings inside a single object makes it very difficult
-// to reason about this code, so it should be split up in the future.
+// The encodings that need to carry state from one buffer to the next are
+// decoded by src/string_decoder.cc, every chunk with a single call into
+// the binding.  All other encodings are passed straight to Buffer#toString().
+//
 // @TODO There should be a utf8-strict encoding that rejects invalid UTF-8 code
 // points as used by CESU-8.
 const StringDecoder = exports.StringDecoder = function(encoding) {
@@ -21,32 +25,15 @@ const StringDecoder = exports.StringDecoder = function(encoding) {
   assertEncoding(encoding);
   switch (this.encoding) {
     case 'utf8':
-      // CESU-8 represents each of Surrogate Pair by 3-bytes
-      this.surrogateSize = 3;
-      break;
     case 'ucs2':
     case 'utf16le':
-      // UTF-16 represents each of Surrogate Pair by 2-bytes
-      this.surrogateSize = 2;
-      this.detectIncompleteChar = utf16DetectIncompleteChar;
-      break;
     case 'base64':
-      // Base-64 stores 3 bytes in 4 chars, and pads the remainder.
-      this.surrogateSize = 3;
-      this.detectIncompleteChar = base64DetectIncompleteChar;
+      this._decoder = new binding.StringDecoder(this.encoding);
       break;
     default:
       this.write = passThroughWrite;
-      return;
+      this.end = passThroughEnd;
   }
-
-  // Enough space to store all bytes of a single character. UTF-8 needs 4
-  // bytes, but CESU-8 may require up to 6 (3 bytes per surrogate).
-  this.charBuffer = new Buffer(6);
-  // Number of bytes received for the current incomplete multi-byte character.
-  this.charReceived = 0;
-  // Number of bytes expected for the current incomplete multi-byte character.
-  this.charLength = 0;
 };
 
 
@@ -60,163 +47,53 @@ const StringDecoder = exports.StringDecoder = function(encoding) {
 // Buffer#write) will replace incomplete surrogates with the unicode
 // replacement character. See https://codereview.chromium.org/121173009/ .
 StringDecoder.prototype.write = function(buffer) {
-  var charStr = '';
-  var buflen = buffer.length;
-  var charBuffer = this.charBuffer;
-  var charLength = this.charLength;
-  var charReceived = this.charReceived;
-  var surrogateSize = this.surrogateSize;
-  var encoding = this.encoding;
-  // if our last write ended with an incomplete multibyte character
-  while (charLength) {
-    // determine how many remaining bytes this buffer has to offer for this char
-    var diff = charLength - charReceived;
-    var available = (buflen >= diff) ? diff : buflen;
-
-    // add the new bytes to the char buffer
-    buffer.copy(charBuffer, charReceived, 0, available);
-    charReceived += available;
-
-    if (charReceived < charLength) {
-      // still not enough chars in this buffer? wait for more ...
-
-      this.charLength = charLength;
-      this.charReceived = charReceived;
-
-      return '';
-    }
-
-    // remove bytes belonging to the current character from the buffer
-    buffer = buffer.slice(available, buflen);
-    buflen = buffer.length;
-
-    // get the character that was split
-    charStr = charBuffer.toString(encoding, 0, charLength);
-
-    // CESU-8: lead surrogate (D800-DBFF) is also the incomplete character
-    var charCode = charStr.charCodeAt(charStr.length - 1);
-    if (charCode >= 0xD800 && charCode <= 0xDBFF) {
-      charLength += surrogateSize;
-      charStr = '';
-      continue;
-    }
-    charReceived = charLength = 0;
-
-    // if there are no more bytes in this buffer, just emit our char
-    if (buflen === 0) {
-      this.charLength = charLength;
-      this.charReceived = charReceived;
-
-      return charStr;
-    }
-  }
-
-  // determine and set charLength / charReceived
-  if (this.detectIncompleteChar(buffer))
-    charLength = this.charLength;
-  charReceived = this.charReceived;
-
-  var end = buflen;
-  if (charLength) {
-    // buffer the incomplete character bytes we got
-    buffer.copy(charBuffer, 0, buflen - charReceived, end);
-    end -= charReceived;
-  }
-
-  this.charLength = charLength;
-  charStr += buffer.toString(encoding, 0, end);
-
-  var end = charStr.length - 1;
-  var charCode = charStr.charCodeAt(end);
-  // CESU-8: lead surrogate (D800-DBFF) is also the incomplete character
-  if (charCode >= 0xD800 && charCode <= 0xDBFF) {
-    charLength += surrogateSize;
-    charReceived += surrogateSize;
-    charBuffer.copy(charBuffer, surrogateSize, 0, surrogateSize);
-    buffer.copy(charBuffer, 0, 0, surrogateSize);
-
-    this.charLength = charLength;
-    this.charReceived = charReceived;
-
-    return charStr.substring(0, end);
-  }
-
-  // or just emit the charStr
-  return charStr;
-};
-
-// detectIncompleteChar determines if there is an incomplete UTF-8 character at
-// the end of the given buffer. If so, it sets this.charLength to the byte
-// length that character, and sets this.charReceived to the number of bytes
-// that are available for this character.
-StringDecoder.prototype.detectIncompleteChar = function(buffer) {
-  var buflen = buffer.length;
-  // determine how many bytes we have to check at the end of this buffer
-  var i = (buflen >= 3) ? 3 : buflen;
-  var newlen = false;
-
-  // Figure out if one of the last i bytes of our buffer announces an
-  // incomplete char.
-  for (; i > 0; i--) {
-    var c = buffer[buflen - i];
-
-    // See http://en.wikipedia.org/wiki/UTF-8#Description
-
-    // 110XXXXX
-    if (i === 1 && c >> 5 === 0x06) {
-      this.charLength = 2;
-      newlen = true;
-      break;
-    }
-
-    // 1110XXXX
-    if (i <= 2 && c >> 4 === 0x0E) {
-      this.charLength = 3;
-      newlen = true;
-      break;
-    }
-
-    // 11110XXX
-    if (i <= 3 && c >> 3 === 0x1E) {
-      this.charLength = 4;
-      newlen = true;
-      break;
-    }
-  }
-
-  this.charReceived = i;
-
-  return newlen;
+  // Strings are passed through, readline writes them when the input stream
+  // has an encoding set.
+  if (typeof buffer === 'string')
+    return buffer;
+  return this._decoder.write(buffer);
 };
 
+// end returns what is left of an incomplete character, decoded as is, and
+// resets the decoder so it can be used for another series of buffers.
 StringDecoder.prototype.end = function(buffer) {
-  var res = '';
+  if (typeof buffer === 'string')
+    return buffer + this._decoder.end();
   if (buffer && buffer.length)
-    res = this.write(buffer);
+    return this._decoder.end(buffer);
+  return this._decoder.end();
+};
 
-  var charReceived = this.charReceived;
-  if (charReceived) {
-    var cr = charReceived;
-    var buf = this.charBuffer;
-    var enc = this.encoding;
-    res += buf.toString(enc, 0, cr);
-  }
+// The state the old JS implementation kept on the decoder, read-only and
+// copied out of the binding on every access.  Undefined for the encodings
+// that don't need state, like before.
+function stateGetter(index) {
+  return function() {
+    if (this._decoder === undefined)
+      return undefined;
+    return this._decoder.state()[index];
+  };
+}
 
-  return res;
-};
+Object.defineProperties(StringDecoder.prototype, {
+  charBuffer: { get: stateGetter(0) },
+  charReceived: { get: stateGetter(1) },
+  charLength: { get: stateGetter(2) },
+  surrogateSize: {
+    get: function() {
+      if (this._decoder === undefined)
+        return undefined;
+      return this.encoding === 'base64' || this.encoding === 'utf8' ? 3 : 2;
+    }
+  }
+});
 
 function passThroughWrite(buffer) {
   return buffer.toString(this.encoding);
 }
 
-function utf16DetectIncompleteChar(buffer) {
-  var charReceived = this.charReceived = buffer.length % 2;
-  this.charLength = charReceived ? 2 : 0;
-  return true;
-}
-
-function base64DetectIncompleteChar(buffer) {
-  var charReceived = this.charReceived = buffer.length % 3;
-  this.charLength = charReceived ? 3 : 0;
-  return true;
+function passThroughEnd(buffer) {
+  if (buffer && buffer.length)
+    return this.write(buffer);
+  return '';
 }
@@ -16,6 +16,9 @@
 
 const v8binding = process.binding('v8');
 const smalloc = require('internal/smalloc');
+const CpuProfile = require('internal/cpu_profile');
+const fs = require('fs');
+const util = require('util');
 
 const heapStatisticsBuffer =
     smalloc.alloc(v8binding.kHeapStatisticsBufferLength,
@@ -41,4 +44,145 @@ exports.getHeapStatistics = function() {
   };
 };
 
+const idleGCStatisticsBuffer =
+    smalloc.alloc(v8binding.kIdleGCFieldsCount, smalloc.Types.Double);
+
+exports.getIdleGCStatistics = function() {
+  var buffer = idleGCStatisticsBuffer;
+
+  v8binding.getIdleGCStatistics(buffer);
+
+  return {
+    'enabled': process.idleGC === true,
+    'notifications': buffer[v8binding.kIdleGCNotifications],
+    'completed': buffer[v8binding.kIdleGCCompleted],
+    'budget_ms': buffer[v8binding.kIdleGCBudget],
+    'time_ms': buffer[v8binding.kIdleGCTime]
+  };
+};
+
 exports.setFlagsFromString = v8binding.setFlagsFromString;
+
+const kGCEventFieldsCount = v8binding.kGCEventFieldsCount;
+
+var gcEvents = null;
+var gcEventsCapacity = 0;
+var gcEventsRead = 0;
+
+exports.startGCTracking = function(capacity) {
+  if (capacity === undefined)
+    capacity = 1024;
+  if (typeof capacity !== 'number' || capacity < 1 || capacity > 0xffffffff ||
+      capacity % 1 !== 0) {
+    throw new RangeError('capacity must be a positive integer');
+  }
+
+  gcEvents = smalloc.alloc(1 + capacity * kGCEventFieldsCount,
+                           smalloc.Types.Double);
+  gcEventsCapacity = capacity;
+  gcEventsRead = 0;
+  v8binding.startGCTracking(gcEvents, capacity);
+};
+
+exports.stopGCTracking = function() {
+  v8binding.stopGCTracking();
+};
+
+// Returns the garbage collections recorded since the last call.  When more
+// than `capacity` happened in between, the oldest are lost and counted in
+// `dropped`.
+exports.drainGCEvents = function() {
+  var result = { events: [], dropped: 0 };
+  if (gcEvents === null)
+    return result;
+
+  var count = gcEvents[0];
+  if (count - gcEventsRead > gcEventsCapacity) {
+    result.dropped = count - gcEventsRead - gcEventsCapacity;
+    gcEventsRead = count - gcEventsCapacity;
+  }
+
+  for (; gcEventsRead < count; gcEventsRead++) {
+    var i = 1 + (gcEventsRead % gcEventsCapacity) * kGCEventFieldsCount;
+    var type = gcEvents[i + v8binding.kGCEventTypeIndex];
+    var flags = gcEvents[i + v8binding.kGCEventFlagsIndex];
+    result.events.push({
+      'type': type === v8binding.kGCTypeScavenge ? 'scavenge' :
+                                                   'mark-sweep-compact',
+      'forced': (flags & v8binding.kGCCallbackFlagForced) !== 0,
+      'start': gcEvents[i + v8binding.kGCEventStartIndex],
+      'duration': gcEvents[i + v8binding.kGCEventDurationIndex],
+      'used_heap_size_before': gcEvents[i + v8binding.kGCEventUsedBeforeIndex],
+      'used_heap_size_after': gcEvents[i + v8binding.kGCEventUsedAfterIndex],
+      'total_heap_size_before':
+          gcEvents[i + v8binding.kGCEventTotalBeforeIndex],
+      'total_heap_size_after': gcEvents[i + v8binding.kGCEventTotalAfterIndex]
+    });
+  }
+
+  return result;
+};
+
+var cpuProfileTitle = null;
+var cpuProfileCount = 0;
+
+// Whether V8 was started with --prof, which keeps the idle notifier running.
+function startedWithProf() {
+  return process.execArgv.some(function(arg) {
+    return arg.slice(0, 6) === '--prof';
+  });
+}
+
+exports.startCpuProfiling = function(options) {
+  if (cpuProfileTitle !== null)
+    throw new Error('A CPU profile is already being recorded');
+
+  options = options || {};
+  var interval = options.interval === undefined ? 1000 : options.interval;
+  if (typeof interval !== 'number' || interval < 1 ||
+      interval > 0xffffffff || interval % 1 !== 0) {
+    throw new RangeError('interval must be a positive integer');
+  }
+
+  cpuProfileTitle = 'io.js-cpu-profile-' + ++cpuProfileCount;
+  // Lets the profiler attribute time spent waiting for I/O to (idle).
+  process._startProfilerIdleNotifier();
+  v8binding.startCpuProfiling(cpuProfileTitle,
+                              interval,
+                              options.samples !== false);
+};
+
+exports.stopCpuProfiling = function() {
+  if (cpuProfileTitle === null)
+    return null;
+
+  var raw = v8binding.stopCpuProfiling(cpuProfileTitle);
+  cpuProfileTitle = null;
+  if (!startedWithProf())
+    process._stopProfilerIdleNotifier();
+
+  return raw === undefined ? null : new CpuProfile(raw);
+};
+
+// Takes a heap snapshot and writes it to `filename`.  The snapshot is
+// serialized straight into the file, it is never held in memory as a whole.
+exports.writeHeapSnapshot = function(filename) {
+  if (filename === undefined) {
+    filename = 'heapsnapshot-' + process.pid + '-' + Date.now() +
+               '.heapsnapshot';
+  }
+  if (typeof filename !== 'string')
+    throw new TypeError('filename must be a string');
+
+  var fd = fs.openSync(filename, 'w');
+  var err;
+  try {
+    err = v8binding.writeHeapSnapshot(fd);
+  } finally {
+    fs.closeSync(fd);
+  }
+  if (err !== 0)
+    throw util._errnoException(err, 'write', filename);
+
+  return filename;
+};
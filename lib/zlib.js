@@ -4,6 +4,12 @@ const Transform = require('_stream_transform');
 const binding = process.binding('zlib');
 const util = require('util');
 const assert = require('assert').ok;
+const kMaxLength = require('smalloc').kMaxLength;
+
+// Defaults for zlib.gzip() with `parallel: true`.  The concurrency matches
+// the default size of the threadpool.
+const kDefaultGzipBlockSize = 128 * 1024;
+const kDefaultGzipConcurrency = 4;
 
 // zlib doesn't provide these, so kludge them in following the same
 // const naming scheme zlib uses.
@@ -116,6 +122,8 @@ exports.gzip = function(buffer, opts, callback) {
     callback = opts;
     opts = {};
   }
+  if (opts && opts.parallel)
+    return gzipParallel(buffer, opts, callback);
   return zlibBuffer(new Gzip(opts), buffer, callback);
 };
 
@@ -216,6 +224,57 @@ function zlibBuffer(engine, buffer, callback) {
   }
 }
 
+// The input is compressed in blocks of `blockSize` bytes, up to
+// `concurrency` of them at a time, see GzipJob in src/node_zlib.cc.  This
+// needs all of the input up front so there is no streaming equivalent.
+function gzipParallel(buffer, opts, callback) {
+  if (typeof buffer === 'string')
+    buffer = new Buffer(buffer);
+  if (!(buffer instanceof Buffer))
+    throw new TypeError('Not a string or buffer');
+
+  checkDeflateOptions(opts);
+
+  var blockSize = kDefaultGzipBlockSize;
+  if (opts.blockSize !== undefined) {
+    blockSize = opts.blockSize;
+    if (blockSize !== (blockSize >>> 0) ||
+        blockSize < exports.Z_MIN_CHUNK ||
+        blockSize > kMaxLength) {
+      throw new Error('Invalid block size: ' + opts.blockSize);
+    }
+  }
+
+  var concurrency = kDefaultGzipConcurrency;
+  if (opts.concurrency !== undefined) {
+    concurrency = opts.concurrency;
+    if (concurrency !== (concurrency >>> 0) || concurrency < 1)
+      throw new Error('Invalid concurrency: ' + opts.concurrency);
+  }
+
+  var level = exports.Z_DEFAULT_COMPRESSION;
+  if (typeof opts.level === 'number') level = opts.level;
+
+  var strategy = exports.Z_DEFAULT_STRATEGY;
+  if (typeof opts.strategy === 'number') strategy = opts.strategy;
+
+  binding.gzip(buffer,
+               level,
+               opts.memLevel || exports.Z_DEFAULT_MEMLEVEL,
+               strategy,
+               blockSize,
+               concurrency,
+               function(result) {
+                 callback(null, result);
+               },
+               function(message, errno) {
+                 var error = new Error(message);
+                 error.errno = errno;
+                 error.code = exports.codes[errno];
+                 callback(error);
+               });
+}
+
 function zlibBufferSync(engine, buffer) {
   if (typeof buffer === 'string')
     buffer = new Buffer(buffer);
@@ -278,6 +337,33 @@ function Unzip(opts) {
 // true or false if there is anything in the queue when
 // you call the .write() method.
 
+// level, memLevel and strategy as accepted by deflateInit2().
+function checkDeflateOptions(opts) {
+  if (opts.level) {
+    if (opts.level < exports.Z_MIN_LEVEL ||
+        opts.level > exports.Z_MAX_LEVEL) {
+      throw new Error('Invalid compression level: ' + opts.level);
+    }
+  }
+
+  if (opts.memLevel) {
+    if (opts.memLevel < exports.Z_MIN_MEMLEVEL ||
+        opts.memLevel > exports.Z_MAX_MEMLEVEL) {
+      throw new Error('Invalid memLevel: ' + opts.memLevel);
+    }
+  }
+
+  if (opts.strategy) {
+    if (opts.strategy != exports.Z_FILTERED &&
+        opts.strategy != exports.Z_HUFFMAN_ONLY &&
+        opts.strategy != exports.Z_RLE &&
+        opts.strategy != exports.Z_FIXED &&
+        opts.strategy != exports.Z_DEFAULT_STRATEGY) {
+      throw new Error('Invalid strategy: ' + opts.strategy);
+    }
+  }
+}
+
 function Zlib(opts, mode) {
   this._opts = opts = opts || {};
   this._chunkSize = opts.chunkSize || exports.Z_DEFAULT_CHUNK;
@@ -310,29 +396,7 @@ function Zlib(opts, mode) {
     }
   }
 
-  if (opts.level) {
-    if (opts.level < exports.Z_MIN_LEVEL ||
-        opts.level > exports.Z_MAX_LEVEL) {
-      throw new Error('Invalid compression level: ' + opts.level);
-    }
-  }
-
-  if (opts.memLevel) {
-    if (opts.memLevel < exports.Z_MIN_MEMLEVEL ||
-        opts.memLevel > exports.Z_MAX_MEMLEVEL) {
-      throw new Error('Invalid memLevel: ' + opts.memLevel);
-    }
-  }
-
-  if (opts.strategy) {
-    if (opts.strategy != exports.Z_FILTERED &&
-        opts.strategy != exports.Z_HUFFMAN_ONLY &&
-        opts.strategy != exports.Z_RLE &&
-        opts.strategy != exports.Z_FIXED &&
-        opts.strategy != exports.Z_DEFAULT_STRATEGY) {
-      throw new Error('Invalid strategy: ' + opts.strategy);
-    }
-  }
+  checkDeflateOptions(opts);
 
   if (opts.dictionary) {
     if (!(opts.dictionary instanceof Buffer)) {
@@ -71,7 +71,12 @@
       'lib/zlib.js',
 
       'lib/internal/child_process.js',
+      'lib/internal/cpu_profile.js',
       'lib/internal/freelist.js',
+      'lib/internal/loop_metrics.js',
+      'lib/internal/async_stats.js',
+      'lib/internal/module_bundle.js',
+      'lib/internal/ocsp_stapler.js',
       'lib/internal/smalloc.js',
       'lib/internal/socket_list.js',
       'lib/internal/repl.js',
@@ -108,13 +113,16 @@
         'src/js_stream.cc',
         'src/node.cc',
         'src/node_buffer.cc',
+        'src/node_bundle.cc',
         'src/node_constants.cc',
         'src/node_contextify.cc',
         'src/node_file.cc',
         'src/node_http_parser.cc',
         'src/node_javascript.cc',
+        'src/node_loop_metrics.cc',
         'src/node_main.cc',
         'src/node_os.cc',
+        'src/node_querystring.cc',
         'src/node_v8.cc',
         'src/node_stat_watcher.cc',
         'src/node_watchdog.cc',
@@ -125,6 +133,7 @@
         'src/smalloc.cc',
         'src/spawn_sync.cc',
         'src/string_bytes.cc',
+        'src/string_decoder.cc',
         'src/stream_base.cc',
         'src/stream_wrap.cc',
         'src/tcp_wrap.cc',
@@ -208,6 +217,7 @@
         }],
         [ 'node_use_openssl=="true"', {
           'defines': [ 'HAVE_OPENSSL=1' ],
+          'dependencies': [ 'node_root_certs#host' ],
           'sources': [
             'src/node_crypto.cc',
             'src/node_crypto_bio.cc',
@@ -490,6 +500,29 @@
         },
       ],
     }, # end node_js2c
+    {
+      'target_name': 'node_root_certs',
+      'type': 'none',
+      'toolsets': ['host'],
+      'actions': [
+        {
+          'action_name': 'node_root_certs',
+          'inputs': [
+            'tools/genrootcerts.py',
+            'src/node_root_certs.h',
+          ],
+          'outputs': [
+            '<(SHARED_INTERMEDIATE_DIR)/node_root_certs_der.h',
+          ],
+          'action': [
+            '<(python)',
+            'tools/genrootcerts.py',
+            '<@(_outputs)',
+            'src/node_root_certs.h',
+          ],
+        },
+      ],
+    }, # end node_root_certs
     {
       'target_name': 'node_dtrace_header',
       'type': 'none',
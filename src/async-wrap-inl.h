@@ -18,6 +18,17 @@ inline AsyncWrap::AsyncWrap(Environment* env,
                             ProviderType provider,
                             AsyncWrap* parent)
     : BaseObject(env, object), bits_(static_cast<uint32_t>(provider) << 1) {
+  env->async_wrap_stats()->OnCreate(provider);
+  env->async_wrap_queue()->PushBack(this);
+
+  // Lets heap snapshots find the native object, see WrapperInfo() in
+  // async-wrap.cc.  Subclasses that wrap the object themselves store the
+  // same pointer, AsyncWrap is always their first base class.
+  if (object->InternalFieldCount() > 0) {
+    Wrap(object, this);
+    persistent().SetWrapperClassId(NODE_ASYNC_ID_OFFSET + provider);
+  }
+
   // Check user controlled flag to see if the init callback should run.
   if (!env->using_asyncwrap())
     return;
@@ -43,6 +54,11 @@ inline AsyncWrap::AsyncWrap(Environment* env,
 }
 
 
+inline AsyncWrap::~AsyncWrap() {
+  env()->async_wrap_stats()->OnDestroy(provider_type());
+}
+
+
 inline bool AsyncWrap::has_async_queue() const {
   return static_cast<bool>(bits_ & 1);
 }
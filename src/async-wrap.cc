@@ -6,6 +6,7 @@
 #include "util-inl.h"
 
 #include "v8.h"
+#include "v8-profiler.h"
 
 using v8::Array;
 using v8::Context;
@@ -13,16 +14,99 @@ using v8::Function;
 using v8::FunctionCallbackInfo;
 using v8::Handle;
 using v8::HandleScope;
+using v8::HeapProfiler;
 using v8::Integer;
 using v8::Isolate;
 using v8::Local;
 using v8::Object;
+using v8::RetainedObjectInfo;
 using v8::TryCatch;
 using v8::Value;
+using v8::kExternalFloat64Array;
 using v8::kExternalUint32Array;
 
 namespace node {
 
+static const char* const provider_names[] = {
+#define V(PROVIDER)                                                           \
+  #PROVIDER,
+  NODE_ASYNC_PROVIDER_TYPES(V)
+#undef V
+};
+
+
+class RetainedAsyncInfo: public RetainedObjectInfo {
+ public:
+  RetainedAsyncInfo(uint16_t class_id, AsyncWrap* wrap);
+
+  virtual void Dispose() override;
+  virtual bool IsEquivalent(RetainedObjectInfo* other) override;
+  virtual intptr_t GetHash() override;
+  virtual const char* GetLabel() override;
+  virtual intptr_t GetSizeInBytes() override;
+
+ private:
+  const char* label_;
+  const AsyncWrap* wrap_;
+  const size_t length_;
+};
+
+
+RetainedAsyncInfo::RetainedAsyncInfo(uint16_t class_id, AsyncWrap* wrap)
+    : label_(provider_names[class_id - NODE_ASYNC_ID_OFFSET]),
+      wrap_(wrap),
+      length_(wrap->self_size()) {
+}
+
+
+void RetainedAsyncInfo::Dispose() {
+  delete this;
+}
+
+
+bool RetainedAsyncInfo::IsEquivalent(RetainedObjectInfo* other) {
+  return label_ == other->GetLabel() &&
+         wrap_ == static_cast<RetainedAsyncInfo*>(other)->wrap_;
+}
+
+
+intptr_t RetainedAsyncInfo::GetHash() {
+  return reinterpret_cast<intptr_t>(wrap_);
+}
+
+
+const char* RetainedAsyncInfo::GetLabel() {
+  return label_;
+}
+
+
+intptr_t RetainedAsyncInfo::GetSizeInBytes() {
+  return length_;
+}
+
+
+static RetainedObjectInfo* WrapperInfo(uint16_t class_id,
+                                       Handle<Value> wrapper) {
+  CHECK(wrapper->IsObject());
+  Local<Object> object = wrapper.As<Object>();
+  // Closed handles have already been unwrapped.
+  AsyncWrap* wrap = Unwrap<AsyncWrap>(object);
+  if (wrap == nullptr)
+    return nullptr;
+  return new RetainedAsyncInfo(class_id, wrap);
+}
+
+
+void LoadAsyncWrapperInfo(Environment* env) {
+  HeapProfiler* heap_profiler = env->isolate()->GetHeapProfiler();
+#define V(PROVIDER)                                                           \
+  heap_profiler->SetWrapperClassInfoProvider(                                 \
+      NODE_ASYNC_ID_OFFSET + AsyncWrap::PROVIDER_ ## PROVIDER, WrapperInfo);
+  NODE_ASYNC_PROVIDER_TYPES(V)
+#undef V
+}
+
+
 static void EnableHooksJS(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
   env->async_hooks()->set_enable_callbacks(1);
@@ -50,6 +134,36 @@ static void SetupHooks(const FunctionCallbackInfo<Value>& args) {
 }
 
 
+// Walks all live objects, so unlike the counts this costs time proportional
+// to the number of objects.
+void Environment::AsyncWrapStats::UpdateNativeBytes(Environment* env) {
+  for (int i = 0; i < kProvidersLength; ++i)
+    fields_[i * kFieldsCount + kNativeBytes] = 0;
+  for (AsyncWrap* wrap : *env->async_wrap_queue()) {
+    const int provider = wrap->provider_type();
+    fields_[provider * kFieldsCount + kNativeBytes] += wrap->self_size();
+  }
+}
+
+
+static void SetupStats(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  Environment::AsyncWrapStats* stats = env->async_wrap_stats();
+
+  CHECK(args[0]->IsObject());
+  args[0].As<Object>()->SetIndexedPropertiesToExternalArrayData(
+      stats->fields(),
+      kExternalFloat64Array,
+      stats->fields_count());
+}
+
+
+static void UpdateNativeBytes(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  env->async_wrap_stats()->UpdateNativeBytes(env);
+}
+
+
 static void Initialize(Handle<Object> target,
                 Handle<Value> unused,
                 Handle<Context> context) {
@@ -60,6 +174,8 @@ static void Initialize(Handle<Object> target,
   env->SetMethod(target, "setupHooks", SetupHooks);
   env->SetMethod(target, "disable", DisableHooksJS);
   env->SetMethod(target, "enable", EnableHooksJS);
+  env->SetMethod(target, "setupStats", SetupStats);
+  env->SetMethod(target, "updateNativeBytes", UpdateNativeBytes);
 
   Local<Object> async_providers = Object::New(isolate);
 #define V(PROVIDER)                                                           \
@@ -68,6 +184,17 @@ static void Initialize(Handle<Object> target,
   NODE_ASYNC_PROVIDER_TYPES(V)
 #undef V
   target->Set(FIXED_ONE_BYTE_STRING(isolate, "Providers"), async_providers);
+
+#define V(name)                                                               \
+  target->Set(FIXED_ONE_BYTE_STRING(isolate, #name),                          \
+              Integer::New(isolate, Environment::AsyncWrapStats::name));
+  V(kLive)
+  V(kCreated)
+  V(kDestroyed)
+  V(kNativeBytes)
+  V(kFieldsCount)
+  V(kProvidersLength)
+#undef V
 }
 
 
@@ -76,6 +203,9 @@ Handle<Value> AsyncWrap::MakeCallback(const Handle<Function> cb,
                                       Handle<Value>* argv) {
   CHECK(env()->context() == env()->isolate()->GetCurrentContext());
 
+  env()->loop_metrics()->OnCallback();
+  env()->set_idle_gc_done(false);
+
   Local<Object> context = object();
   Local<Object> process = env()->process_object();
   Local<Object> domain;
@@ -2,12 +2,18 @@
 #define SRC_ASYNC_WRAP_H_
 
 #include "base-object.h"
+#include "util.h"
 #include "v8.h"
 
+#include <stddef.h>
 #include <stdint.h>
 
 namespace node {
 
+// Wrapper class ids of AsyncWrap objects are NODE_ASYNC_ID_OFFSET plus the
+// provider type.
+#define NODE_ASYNC_ID_OFFSET 0xA1C0
+
 #define NODE_ASYNC_PROVIDER_TYPES(V)                                          \
   V(NONE)                                                                     \
   V(CARES)                                                                    \
@@ -42,6 +48,7 @@ class AsyncWrap : public BaseObject {
     PROVIDER_ ## PROVIDER,
     NODE_ASYNC_PROVIDER_TYPES(V)
 #undef V
+    PROVIDERS_LENGTH
   };
 
   inline AsyncWrap(Environment* env,
@@ -49,10 +56,14 @@ class AsyncWrap : public BaseObject {
                    ProviderType provider,
                    AsyncWrap* parent = nullptr);
 
-  inline virtual ~AsyncWrap() override = default;
+  inline virtual ~AsyncWrap() override;
 
   inline ProviderType provider_type() const;
 
+  // Size of the native object, reported in heap snapshots.  Implementations
+  // add whatever memory the object owns exclusively.
+  virtual size_t self_size() const = 0;
+
   // Only call these within a valid HandleScope.
   v8::Handle<v8::Value> MakeCallback(const v8::Handle<v8::Function> cb,
                                      int argc,
@@ -65,15 +76,21 @@ class AsyncWrap : public BaseObject {
                                             v8::Handle<v8::Value>* argv);
 
  private:
+  friend class Environment;
+
   inline AsyncWrap();
   inline bool has_async_queue() const;
 
+  ListNode<AsyncWrap> async_wrap_queue_;
+
   // When the async hooks init JS function is called from the constructor it is
   // expected the context object will receive a _asyncQueue object property
   // that will be used to call pre/post in MakeCallback.
   uint32_t bits_;
 };
 
+void LoadAsyncWrapperInfo(Environment* env);
+
 }  // namespace node
 
 
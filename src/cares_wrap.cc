@@ -51,6 +51,8 @@ using v8::Value;
 class GetAddrInfoReqWrap : public ReqWrap<uv_getaddrinfo_t> {
  public:
   GetAddrInfoReqWrap(Environment* env, Local<Object> req_wrap_obj);
+
+  size_t self_size() const override { return sizeof(*this); }
 };
 
 GetAddrInfoReqWrap::GetAddrInfoReqWrap(Environment* env,
@@ -68,6 +70,8 @@ static void NewGetAddrInfoReqWrap(const FunctionCallbackInfo<Value>& args) {
 class GetNameInfoReqWrap : public ReqWrap<uv_getnameinfo_t> {
   public:
     GetNameInfoReqWrap(Environment* env, Local<Object> req_wrap_obj);
+
+    size_t self_size() const override { return sizeof(*this); }
 };
 
 GetNameInfoReqWrap::GetNameInfoReqWrap(Environment* env,
@@ -375,6 +379,8 @@ class QueryAWrap: public QueryWrap {
       : QueryWrap(env, req_wrap_obj) {
   }
 
+  size_t self_size() const override { return sizeof(*this); }
+
   int Send(const char* name) override {
     ares_query(env()->cares_channel(),
                name,
@@ -412,6 +418,8 @@ class QueryAaaaWrap: public QueryWrap {
       : QueryWrap(env, req_wrap_obj) {
   }
 
+  size_t self_size() const override { return sizeof(*this); }
+
   int Send(const char* name) override {
     ares_query(env()->cares_channel(),
                name,
@@ -449,6 +457,8 @@ class QueryCnameWrap: public QueryWrap {
       : QueryWrap(env, req_wrap_obj) {
   }
 
+  size_t self_size() const override { return sizeof(*this); }
+
   int Send(const char* name) override {
     ares_query(env()->cares_channel(),
                name,
@@ -488,6 +498,8 @@ class QueryMxWrap: public QueryWrap {
       : QueryWrap(env, req_wrap_obj) {
   }
 
+  size_t self_size() const override { return sizeof(*this); }
+
   int Send(const char* name) override {
     ares_query(env()->cares_channel(),
                name,
@@ -537,6 +549,8 @@ class QueryNsWrap: public QueryWrap {
       : QueryWrap(env, req_wrap_obj) {
   }
 
+  size_t self_size() const override { return sizeof(*this); }
+
   int Send(const char* name) override {
     ares_query(env()->cares_channel(),
                name,
@@ -573,6 +587,8 @@ class QueryTxtWrap: public QueryWrap {
       : QueryWrap(env, req_wrap_obj) {
   }
 
+  size_t self_size() const override { return sizeof(*this); }
+
   int Send(const char* name) override {
     ares_query(env()->cares_channel(),
                name,
@@ -628,6 +644,8 @@ class QuerySrvWrap: public QueryWrap {
       : QueryWrap(env, req_wrap_obj) {
   }
 
+  size_t self_size() const override { return sizeof(*this); }
+
   int Send(const char* name) override {
     ares_query(env()->cares_channel(),
                name,
@@ -682,6 +700,8 @@ class QueryNaptrWrap: public QueryWrap {
       : QueryWrap(env, req_wrap_obj) {
   }
 
+  size_t self_size() const override { return sizeof(*this); }
+
   int Send(const char* name) override {
     ares_query(env()->cares_channel(),
                name,
@@ -744,6 +764,8 @@ class QuerySoaWrap: public QueryWrap {
       : QueryWrap(env, req_wrap_obj) {
   }
 
+  size_t self_size() const override { return sizeof(*this); }
+
   int Send(const char* name) override {
     ares_query(env()->cares_channel(),
                name,
@@ -797,6 +819,8 @@ class GetHostByAddrWrap: public QueryWrap {
       : QueryWrap(env, req_wrap_obj) {
   }
 
+  size_t self_size() const override { return sizeof(*this); }
+
   int Send(const char* name) override {
     int length, family;
     char address_buffer[sizeof(struct in6_addr)];
@@ -835,6 +859,8 @@ class GetHostByNameWrap: public QueryWrap {
       : QueryWrap(env, req_wrap_obj) {
   }
 
+  size_t self_size() const override { return sizeof(*this); }
+
   int Send(const char* name, int family) override {
     ares_gethostbyname(env()->cares_channel(),
                        name,
@@ -131,6 +131,93 @@ inline void Environment::TickInfo::set_last_threw(bool value) {
   last_threw_ = value;
 }
 
+inline Environment::LoopMetrics::LoopMetrics()
+    : enabled_(false),
+      polling_(false),
+      prepare_time_(0),
+      wake_time_(0),
+      idle_time_(0),
+      io_time_(0),
+      immediate_time_(0) {
+  Reset();
+}
+
+inline double* Environment::LoopMetrics::fields() {
+  return fields_;
+}
+
+inline int Environment::LoopMetrics::fields_count() const {
+  return kFieldsCount;
+}
+
+inline double* Environment::LoopMetrics::histogram() {
+  return histogram_;
+}
+
+inline int Environment::LoopMetrics::histogram_count() const {
+  return kHistogramBuckets;
+}
+
+inline bool Environment::LoopMetrics::enabled() const {
+  return enabled_;
+}
+
+inline void Environment::LoopMetrics::set_enabled(bool value) {
+  enabled_ = value;
+  polling_ = false;
+  prepare_time_ = 0;
+}
+
+inline void Environment::LoopMetrics::Reset() {
+  for (int i = 0; i < kFieldsCount; ++i)
+    fields_[i] = 0;
+  for (int i = 0; i < kHistogramBuckets; ++i)
+    histogram_[i] = 0;
+}
+
+inline void Environment::LoopMetrics::OnCallback() {
+  if (polling_) {
+    polling_ = false;
+    wake_time_ = uv_hrtime();
+  }
+}
+
+#if HAVE_OPENSSL
+inline Environment::RandomPool::RandomPool()
+    : data_(nullptr),
+      offset_(kBlockSize),
+      next_(nullptr),
+      refill_(nullptr) {
+}
+#endif  // HAVE_OPENSSL
+
+inline Environment::AsyncWrapStats::AsyncWrapStats() {
+  for (int i = 0; i < kProvidersLength * kFieldsCount; ++i)
+    fields_[i] = 0;
+}
+
+inline double* Environment::AsyncWrapStats::fields() {
+  return fields_;
+}
+
+inline int Environment::AsyncWrapStats::fields_count() const {
+  return kProvidersLength * kFieldsCount;
+}
+
+inline void Environment::AsyncWrapStats::OnCreate(
+    AsyncWrap::ProviderType provider) {
+  double* fields = fields_ + provider * kFieldsCount;
+  fields[kLive] += 1;
+  fields[kCreated] += 1;
+}
+
+inline void Environment::AsyncWrapStats::OnDestroy(
+    AsyncWrap::ProviderType provider) {
+  double* fields = fields_ + provider * kFieldsCount;
+  fields[kLive] -= 1;
+  fields[kDestroyed] += 1;
+}
+
 inline Environment* Environment::New(v8::Local<v8::Context> context,
                                      uv_loop_t* loop) {
   Environment* env = new Environment(context, loop);
@@ -171,6 +258,7 @@ inline Environment::Environment(v8::Local<v8::Context> context,
                                 uv_loop_t* loop)
     : isolate_(context->GetIsolate()),
       isolate_data_(IsolateData::GetOrCreate(context->GetIsolate(), loop)),
+      idle_gc_done_(false),
       using_smalloc_alloc_cb_(false),
       using_domains_(false),
       using_abort_on_uncaught_exc_(false),
@@ -185,6 +273,11 @@ inline Environment::Environment(v8::Local<v8::Context> context,
   set_as_external(v8::External::New(isolate(), this));
   set_binding_cache_object(v8::Object::New(isolate()));
   set_module_load_list_array(v8::Array::New(isolate()));
+  set_smalloc_slabs_array(v8::Array::New(isolate(), kSmallocSlabClasses));
+  for (int i = 0; i < kSmallocSlabClasses; i++)
+    smalloc_slab_offsets_[i] = 0;
+  for (int i = 0; i < kIdleGCFieldsCount; i++)
+    idle_gc_fields_[i] = 0;
   RB_INIT(&cares_task_list_);
   handle_cleanup_waiting_ = 0;
 }
@@ -192,6 +285,9 @@ inline Environment::Environment(v8::Local<v8::Context> context,
 inline Environment::~Environment() {
   v8::HandleScope handle_scope(isolate());
 
+  while (CleanupHook* hook = cleanup_hook_queue_.PopFront())
+    hook->cb_(hook->arg_);
+
   context()->SetAlignedPointerInEmbedderData(kContextEmbedderDataIndex,
                                              nullptr);
 #define V(PropertyName, TypeName) PropertyName ## _.Reset();
@@ -260,6 +356,27 @@ inline uv_check_t* Environment::idle_check_handle() {
   return &idle_check_handle_;
 }
 
+inline Environment* Environment::from_idle_gc_prepare_handle(
+    uv_prepare_t* handle) {
+  return ContainerOf(&Environment::idle_gc_prepare_handle_, handle);
+}
+
+inline uv_prepare_t* Environment::idle_gc_prepare_handle() {
+  return &idle_gc_prepare_handle_;
+}
+
+inline double* Environment::idle_gc_fields() {
+  return idle_gc_fields_;
+}
+
+inline bool Environment::idle_gc_done() const {
+  return idle_gc_done_;
+}
+
+inline void Environment::set_idle_gc_done(bool value) {
+  idle_gc_done_ = value;
+}
+
 inline void Environment::RegisterHandleCleanup(uv_handle_t* handle,
                                                HandleCleanupCb cb,
                                                void *arg) {
@@ -270,6 +387,10 @@ inline void Environment::FinishHandleCleanup(uv_handle_t* handle) {
   handle_cleanup_waiting_--;
 }
 
+inline void Environment::AddCleanupHook(CleanupHook* hook) {
+  cleanup_hook_queue_.PushBack(hook);
+}
+
 inline uv_loop_t* Environment::event_loop() const {
   return isolate_data()->event_loop();
 }
@@ -286,6 +407,38 @@ inline Environment::TickInfo* Environment::tick_info() {
   return &tick_info_;
 }
 
+inline Environment::LoopMetrics* Environment::loop_metrics() {
+  return &loop_metrics_;
+}
+
+#if HAVE_OPENSSL
+inline Environment::RandomPool* Environment::random_pool() {
+  return &random_pool_;
+}
+#endif  // HAVE_OPENSSL
+
+inline Environment::AsyncWrapStats* Environment::async_wrap_stats() {
+  return &async_wrap_stats_;
+}
+
+inline Environment* Environment::from_loop_metrics_prepare_handle(
+    uv_prepare_t* handle) {
+  return ContainerOf(&Environment::loop_metrics_prepare_handle_, handle);
+}
+
+inline uv_prepare_t* Environment::loop_metrics_prepare_handle() {
+  return &loop_metrics_prepare_handle_;
+}
+
+inline Environment* Environment::from_loop_metrics_check_handle(
+    uv_check_t* handle) {
+  return ContainerOf(&Environment::loop_metrics_check_handle_, handle);
+}
+
+inline uv_check_t* Environment::loop_metrics_check_handle() {
+  return &loop_metrics_check_handle_;
+}
+
 inline bool Environment::using_smalloc_alloc_cb() const {
   return using_smalloc_alloc_cb_;
 }
@@ -294,6 +447,10 @@ inline void Environment::set_using_smalloc_alloc_cb(bool value) {
   using_smalloc_alloc_cb_ = value;
 }
 
+inline uint32_t* Environment::smalloc_slab_offsets() {
+  return smalloc_slab_offsets_;
+}
+
 inline bool Environment::using_abort_on_uncaught_exc() const {
   return using_abort_on_uncaught_exc_;
 }
@@ -1,7 +1,11 @@
 #include "env.h"
 #include "env-inl.h"
 #include "v8.h"
+#if HAVE_OPENSSL
+#include "node_crypto.h"  // CheckEntropy(), OpenSSL headers
+#endif
 #include <stdio.h>
+#include <string.h>
 
 namespace node {
 
@@ -55,4 +59,88 @@ void Environment::PrintSyncTrace() const {
   fflush(stderr);
 }
 
+#if HAVE_OPENSSL
+// A refill that is still running is detached and frees its block when it
+// is done.
+Environment::RandomPool::~RandomPool() {
+  if (refill_ != nullptr)
+    refill_->pool = nullptr;
+  if (data_ != nullptr) {
+    OPENSSL_cleanse(data_, kBlockSize);
+    delete[] data_;
+  }
+  if (next_ != nullptr) {
+    OPENSSL_cleanse(next_, kBlockSize);
+    delete[] next_;
+  }
+}
+
+
+bool Environment::RandomPool::Take(Environment* env, char* data, size_t size) {
+  CHECK_LE(size, kMaxRequestSize);
+
+  if ((data_ == nullptr || kBlockSize - offset_ < size) && next_ != nullptr) {
+    if (data_ != nullptr) {
+      OPENSSL_cleanse(data_, kBlockSize);
+      delete[] data_;
+    }
+    data_ = next_;
+    next_ = nullptr;
+    offset_ = 0;
+  }
+
+  // Always keep the next block ready.
+  if (next_ == nullptr && refill_ == nullptr)
+    Refill(env);
+
+  if (data_ == nullptr || kBlockSize - offset_ < size)
+    return false;
+
+  memcpy(data, data_ + offset_, size);
+  OPENSSL_cleanse(data_ + offset_, size);
+  offset_ += size;
+  return true;
+}
+
+
+void Environment::RandomPool::Refill(Environment* env) {
+  RefillRequest* req = new RefillRequest;
+  req->pool = this;
+  req->data = new char[kBlockSize];
+  req->ok = false;
+  refill_ = req;
+  uv_queue_work(env->event_loop(), &req->work_req, RefillWork, RefillAfter);
+}
+
+
+void Environment::RandomPool::RefillWork(uv_work_t* work_req) {
+  RefillRequest* req = ContainerOf(&RefillRequest::work_req, work_req);
+
+  // Ensure that OpenSSL's PRNG is properly seeded.
+  crypto::CheckEntropy();
+
+  req->ok = RAND_bytes(reinterpret_cast<unsigned char*>(req->data),
+                       kBlockSize) == 1;
+  ERR_clear_error();
+}
+
+
+// If the PRNG failed, small requests go to RandomBytesWork() like large
+// ones until the next refill, which reports the error.
+void Environment::RandomPool::RefillAfter(uv_work_t* work_req, int status) {
+  RefillRequest* req = ContainerOf(&RefillRequest::work_req, work_req);
+  RandomPool* pool = req->pool;
+  if (pool != nullptr)
+    pool->refill_ = nullptr;
+  if (pool != nullptr && req->ok) {
+    CHECK_EQ(pool->next_, nullptr);
+    pool->next_ = req->data;
+  } else {
+    OPENSSL_cleanse(req->data, kBlockSize);
+    delete[] req->data;
+  }
+  delete req;
+}
+#endif  // HAVE_OPENSSL
+
 }  // namespace node
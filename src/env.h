@@ -38,6 +38,43 @@ namespace node {
 #define NODE_ISOLATE_SLOT 3
 #endif
 
+// Header names that the HTTP parser hands out as interned strings, in their
+// lower case and their canonical spelling.  Keep in sync with the perfect
+// hash in src/node_http_parser.cc, which CHECKs for collisions at startup.
+#define HTTP_KNOWN_HEADERS(X, V)                                              \
+  X(V, accept, "accept", "Accept")                                            \
+  X(V, accept_encoding, "accept-encoding", "Accept-Encoding")                 \
+  X(V, accept_language, "accept-language", "Accept-Language")                 \
+  X(V, authorization, "authorization", "Authorization")                       \
+  X(V, cache_control, "cache-control", "Cache-Control")                       \
+  X(V, connection, "connection", "Connection")                                \
+  X(V, content_encoding, "content-encoding", "Content-Encoding")              \
+  X(V, content_length, "content-length", "Content-Length")                    \
+  X(V, content_type, "content-type", "Content-Type")                          \
+  X(V, cookie, "cookie", "Cookie")                                            \
+  X(V, date, "date", "Date")                                                  \
+  X(V, etag, "etag", "ETag")                                                  \
+  X(V, expect, "expect", "Expect")                                            \
+  X(V, host, "host", "Host")                                                  \
+  X(V, if_modified_since, "if-modified-since", "If-Modified-Since")           \
+  X(V, if_none_match, "if-none-match", "If-None-Match")                       \
+  X(V, keep_alive, "keep-alive", "Keep-Alive")                                \
+  X(V, last_modified, "last-modified", "Last-Modified")                       \
+  X(V, location, "location", "Location")                                      \
+  X(V, origin, "origin", "Origin")                                            \
+  X(V, pragma, "pragma", "Pragma")                                            \
+  X(V, referer, "referer", "Referer")                                         \
+  X(V, server, "server", "Server")                                            \
+  X(V, set_cookie, "set-cookie", "Set-Cookie")                                \
+  X(V, transfer_encoding, "transfer-encoding", "Transfer-Encoding")           \
+  X(V, upgrade, "upgrade", "Upgrade")                                         \
+  X(V, user_agent, "user-agent", "User-Agent")                                \
+  X(V, x_forwarded_for, "x-forwarded-for", "X-Forwarded-For")                 \
+
+#define HTTP_KNOWN_HEADER_STRING_PROPERTIES(V, name, lower, canonical)        \
+  V(name ## _header_string, lower)                                            \
+  V(name ## _raw_header_string, canonical)
+
 // Strings are per-isolate primitives but Environment proxies them
 // for the sake of convenience.
 #define PER_ISOLATE_STRING_PROPERTIES(V)                                      \
@@ -155,6 +192,7 @@ namespace node {
   V(output_string, "output")                                                  \
   V(order_string, "order")                                                    \
   V(owner_string, "owner")                                                    \
+  V(parent_string, "parent")                                                  \
   V(parse_error_string, "Parse Error")                                        \
   V(path_string, "path")                                                      \
   V(pbkdf2_error_string, "PBKDF2 Error")                                      \
@@ -223,6 +261,7 @@ namespace node {
   V(write_queue_size_string, "writeQueueSize")                                \
   V(x_forwarded_string, "x-forwarded-for")                                    \
   V(zero_return_string, "ZERO_RETURN")                                        \
+  HTTP_KNOWN_HEADERS(HTTP_KNOWN_HEADER_STRING_PROPERTIES, V)                  \
 
 #define ENVIRONMENT_STRONG_PERSISTENT_PROPERTIES(V)                           \
   V(as_external, v8::External)                                                \
@@ -234,6 +273,7 @@ namespace node {
   V(context, v8::Context)                                                     \
   V(domain_array, v8::Array)                                                  \
   V(fs_stats_constructor_function, v8::Function)                              \
+  V(fs_stats_field_array, v8::Object)                                         \
   V(jsstream_constructor_template, v8::FunctionTemplate)                      \
   V(module_load_list_array, v8::Array)                                        \
   V(pipe_constructor_template, v8::FunctionTemplate)                          \
@@ -242,6 +282,7 @@ namespace node {
   V(script_context_constructor_template, v8::FunctionTemplate)                \
   V(script_data_constructor_function, v8::Function)                           \
   V(secure_context_constructor_template, v8::FunctionTemplate)                \
+  V(smalloc_slabs_array, v8::Array)                                           \
   V(tcp_constructor_template, v8::FunctionTemplate)                           \
   V(tick_callback_function, v8::Function)                                     \
   V(tls_wrap_constructor_function, v8::Function)                              \
@@ -336,6 +377,127 @@ class Environment {
     DISALLOW_COPY_AND_ASSIGN(TickInfo);
   };
 
+  // Event loop instrumentation, see src/node_loop_metrics.cc.  Times are in
+  // nanoseconds, the histogram counts iterations by the time the loop was
+  // busy, in microseconds.
+  class LoopMetrics {
+   public:
+    enum Fields {
+      kIterations,
+      kLoopTime,
+      kIdleTime,
+      kIOTime,
+      kImmediateTime,
+      kFieldsCount
+    };
+
+    static const int kHistogramBuckets = 272;
+
+    inline double* fields();
+    inline int fields_count() const;
+    inline double* histogram();
+    inline int histogram_count() const;
+    inline bool enabled() const;
+    inline void set_enabled(bool value);
+    inline void Reset();
+
+    // Called when JS is entered from the event loop; the first call after
+    // OnPrepare() marks the end of the wait for I/O.
+    inline void OnCallback();
+
+    void OnPrepare(uint64_t now);
+    void OnCheck(uint64_t now);
+    void OnImmediate(uint64_t start, uint64_t end);
+
+   private:
+    friend class Environment;  // So we can call the constructor.
+    inline LoopMetrics();
+
+    double fields_[kFieldsCount];
+    double histogram_[kHistogramBuckets];
+    bool enabled_;
+    bool polling_;
+    uint64_t prepare_time_;
+    uint64_t wake_time_;
+    uint64_t idle_time_;
+    uint64_t io_time_;
+    uint64_t immediate_time_;
+
+    DISALLOW_COPY_AND_ASSIGN(LoopMetrics);
+  };
+
+#if HAVE_OPENSSL
+  // Random bytes for small crypto.randomBytes() calls, see src/env.cc.
+  // Requests are served from the current block while the next one is
+  // generated on the threadpool.
+  class RandomPool {
+   public:
+    static const size_t kBlockSize = 16 * 1024;
+    static const size_t kMaxRequestSize = 256;
+
+    // Copies `size` bytes to `data` and wipes them from the pool.  Returns
+    // false if the pool doesn't have enough, a refill is under way then.
+    bool Take(Environment* env, char* data, size_t size);
+
+   private:
+    friend class Environment;  // So we can call the constructor.
+    inline RandomPool();
+    ~RandomPool();
+
+    struct RefillRequest {
+      uv_work_t work_req;
+      // nullptr once the pool is gone.
+      RandomPool* pool;
+      char* data;
+      bool ok;
+    };
+
+    void Refill(Environment* env);
+    static void RefillWork(uv_work_t* work_req);
+    static void RefillAfter(uv_work_t* work_req, int status);
+
+    char* data_;
+    size_t offset_;
+    // A block that is ready to be used, or nullptr.
+    char* next_;
+    // The refill that is running, or nullptr.
+    RefillRequest* refill_;
+
+    DISALLOW_COPY_AND_ASSIGN(RandomPool);
+  };
+#endif  // HAVE_OPENSSL
+
+  // Per provider type counts of AsyncWrap objects, kProvidersLength groups
+  // of kFieldsCount fields.  Everything but kNativeBytes is kept up to date
+  // as objects come and go.  kNativeBytes is only filled in by
+  // UpdateNativeBytes() because the size of most objects changes over time.
+  class AsyncWrapStats {
+   public:
+    enum Fields {
+      kLive,
+      kCreated,
+      kDestroyed,
+      kNativeBytes,
+      kFieldsCount
+    };
+
+    static const int kProvidersLength = AsyncWrap::PROVIDERS_LENGTH;
+
+    inline double* fields();
+    inline int fields_count() const;
+    inline void OnCreate(AsyncWrap::ProviderType provider);
+    inline void OnDestroy(AsyncWrap::ProviderType provider);
+    void UpdateNativeBytes(Environment* env);
+
+   private:
+    friend class Environment;  // So we can call the constructor.
+    inline AsyncWrapStats();
+
+    double fields_[kProvidersLength * kFieldsCount];
+
+    DISALLOW_COPY_AND_ASSIGN(AsyncWrapStats);
+  };
+
   typedef void (*HandleCleanupCb)(Environment* env,
                                   uv_handle_t* handle,
                                   void* arg);
@@ -356,6 +518,26 @@ class Environment {
     ListNode<HandleCleanup> handle_cleanup_queue_;
   };
 
+  // Lets an object that is owned by a binding, not by a JS object, be torn
+  // down together with the environment.  |cb| runs when the environment is
+  // destroyed, unless the hook was destroyed first.
+  class CleanupHook {
+   public:
+    typedef void (*Callback)(void* arg);
+
+    CleanupHook(Callback cb, void* arg)
+        : cb_(cb),
+          arg_(arg) {
+    }
+
+   private:
+    friend class Environment;
+
+    Callback cb_;
+    void* arg_;
+    ListNode<CleanupHook> cleanup_hook_queue_;
+  };
+
   static inline Environment* GetCurrent(v8::Isolate* isolate);
   static inline Environment* GetCurrent(v8::Local<v8::Context> context);
   static inline Environment* GetCurrent(
@@ -389,15 +571,44 @@ class Environment {
   static inline Environment* from_idle_check_handle(uv_check_t* handle);
   inline uv_check_t* idle_check_handle();
 
+  // Idle-time garbage collection, see StartIdleGC() in src/node.cc.
+  enum IdleGCField {
+    kIdleGCNotifications,
+    kIdleGCCompleted,
+    kIdleGCBudget,
+    kIdleGCTime,
+    kIdleGCFieldsCount
+  };
+
+  static inline Environment* from_idle_gc_prepare_handle(
+      uv_prepare_t* handle);
+  inline uv_prepare_t* idle_gc_prepare_handle();
+  inline double* idle_gc_fields();
+  inline bool idle_gc_done() const;
+  inline void set_idle_gc_done(bool value);
+
   // Register clean-up cb to be called on env->Dispose()
   inline void RegisterHandleCleanup(uv_handle_t* handle,
                                     HandleCleanupCb cb,
                                     void *arg);
   inline void FinishHandleCleanup(uv_handle_t* handle);
+  inline void AddCleanupHook(CleanupHook* hook);
 
   inline AsyncHooks* async_hooks();
   inline DomainFlag* domain_flag();
   inline TickInfo* tick_info();
+  inline LoopMetrics* loop_metrics();
+#if HAVE_OPENSSL
+  inline RandomPool* random_pool();
+#endif
+  inline AsyncWrapStats* async_wrap_stats();
+
+  static inline Environment* from_loop_metrics_prepare_handle(
+      uv_prepare_t* handle);
+  inline uv_prepare_t* loop_metrics_prepare_handle();
+  static inline Environment* from_loop_metrics_check_handle(
+      uv_check_t* handle);
+  inline uv_check_t* loop_metrics_check_handle();
 
   static inline Environment* from_cares_timer_handle(uv_timer_t* handle);
   inline uv_timer_t* cares_timer_handle();
@@ -408,6 +619,11 @@ class Environment {
   inline bool using_smalloc_alloc_cb() const;
   inline void set_using_smalloc_alloc_cb(bool value);
 
+  // Fill level of the current slab of each smalloc size class, the slabs
+  // themselves live in smalloc_slabs_array().
+  static const int kSmallocSlabClasses = 3;
+  inline uint32_t* smalloc_slab_offsets();
+
   inline bool using_abort_on_uncaught_exc() const;
   inline void set_using_abort_on_uncaught_exc(bool value);
 
@@ -475,10 +691,12 @@ class Environment {
     return &debugger_agent_;
   }
 
+  typedef ListHead<AsyncWrap, &AsyncWrap::async_wrap_queue_> AsyncWrapQueue;
   typedef ListHead<HandleWrap, &HandleWrap::handle_wrap_queue_> HandleWrapQueue;
   typedef ListHead<ReqWrap<uv_req_t>, &ReqWrap<uv_req_t>::req_wrap_queue_>
           ReqWrapQueue;
 
+  inline AsyncWrapQueue* async_wrap_queue() { return &async_wrap_queue_; }
   inline HandleWrapQueue* handle_wrap_queue() { return &handle_wrap_queue_; }
   inline ReqWrapQueue* req_wrap_queue() { return &req_wrap_queue_; }
 
@@ -498,13 +716,24 @@ class Environment {
   uv_idle_t immediate_idle_handle_;
   uv_prepare_t idle_prepare_handle_;
   uv_check_t idle_check_handle_;
+  uv_prepare_t idle_gc_prepare_handle_;
+  double idle_gc_fields_[kIdleGCFieldsCount];
+  bool idle_gc_done_;
   AsyncHooks async_hooks_;
   DomainFlag domain_flag_;
   TickInfo tick_info_;
+  LoopMetrics loop_metrics_;
+  uv_prepare_t loop_metrics_prepare_handle_;
+  uv_check_t loop_metrics_check_handle_;
+#if HAVE_OPENSSL
+  RandomPool random_pool_;
+#endif
+  AsyncWrapStats async_wrap_stats_;
   uv_timer_t cares_timer_handle_;
   ares_channel cares_channel_;
   ares_task_list cares_task_list_;
   bool using_smalloc_alloc_cb_;
+  uint32_t smalloc_slab_offsets_[kSmallocSlabClasses];
   bool using_domains_;
   bool using_abort_on_uncaught_exc_;
   bool using_asyncwrap_;
@@ -512,11 +741,14 @@ class Environment {
   bool trace_sync_io_;
   debugger::Agent debugger_agent_;
 
+  AsyncWrapQueue async_wrap_queue_;
   HandleWrapQueue handle_wrap_queue_;
   ReqWrapQueue req_wrap_queue_;
   ListHead<HandleCleanup,
            &HandleCleanup::handle_cleanup_queue_> handle_cleanup_queue_;
   int handle_cleanup_waiting_;
+  ListHead<CleanupHook,
+           &CleanupHook::cleanup_hook_queue_> cleanup_hook_queue_;
 
 #define V(PropertyName, TypeName)                                             \
   v8::Persistent<TypeName> PropertyName ## _;
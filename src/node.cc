@@ -117,6 +117,7 @@ static bool trace_deprecation = false;
 static bool throw_deprecation = false;
 static bool abort_on_uncaught_exception = false;
 static bool trace_sync_io = false;
+static bool idle_gc = false;
 static const char* eval_string = nullptr;
 static unsigned int preload_module_count = 0;
 static const char** preload_modules = nullptr;
@@ -189,6 +190,13 @@ static void CheckImmediate(uv_check_t* handle) {
   Environment* env = Environment::from_immediate_check_handle(handle);
   HandleScope scope(env->isolate());
   Context::Scope context_scope(env->context());
+  Environment::LoopMetrics* loop_metrics = env->loop_metrics();
+  if (loop_metrics->enabled()) {
+    const uint64_t start = uv_hrtime();
+    MakeCallback(env, env->process_object(), env->immediate_callback_string());
+    loop_metrics->OnImmediate(start, uv_hrtime());
+    return;
+  }
   MakeCallback(env, env->process_object(), env->immediate_callback_string());
 }
 
@@ -1030,6 +1038,9 @@ Handle<Value> MakeCallback(Environment* env,
   // If you hit this assertion, you forgot to enter the v8::Context first.
   CHECK_EQ(env->context(), env->isolate()->GetCurrentContext());
 
+  env->loop_metrics()->OnCallback();
+  env->set_idle_gc_done(false);
+
   Local<Object> process = env->process_object();
   Local<Object> object, domain;
   bool has_async_queue = false;
@@ -2624,6 +2635,50 @@ void StopProfilerIdleNotifier(Environment* env) {
 }
 
 
+// Upper bound for the time handed to the garbage collector per loop
+// iteration.  When nothing is scheduled the loop may sleep indefinitely but
+// an incoming request should not have to wait for a long collection.
+static const int kIdleGCMaxBudget = 10;
+
+
+// Runs right before the event loop blocks for I/O.  The poll timeout is the
+// time until the next timer expires, which is how long we can be sure the
+// process has nothing else to do.  Once V8 reports that there is nothing
+// left to collect, it is not notified again until MakeCallback() has run
+// JS, which is the only way new garbage comes about.
+void IdleGC(uv_prepare_t* handle) {
+  Environment* env = Environment::from_idle_gc_prepare_handle(handle);
+  if (env->idle_gc_done())
+    return;
+
+  uv_loop_t* loop = env->event_loop();
+  int budget = uv_backend_timeout(loop);
+  if (budget == 0)
+    return;
+  if (budget < 0 || budget > kIdleGCMaxBudget)
+    budget = kIdleGCMaxBudget;
+
+  const uint64_t start = uv_hrtime();
+  env->set_idle_gc_done(env->isolate()->IdleNotification(budget));
+  const uint64_t elapsed = uv_hrtime() - start;
+
+  double* fields = env->idle_gc_fields();
+  fields[Environment::kIdleGCNotifications] += 1;
+  fields[Environment::kIdleGCCompleted] += env->idle_gc_done();
+  fields[Environment::kIdleGCBudget] += budget;
+  fields[Environment::kIdleGCTime] += elapsed / 1e6;
+
+  // The poll timeout is computed from the cached loop time, refresh it so
+  // the time spent collecting does not delay the next timer.
+  uv_update_time(loop);
+}
+
+
+void StartIdleGC(Environment* env) {
+  uv_prepare_start(env->idle_gc_prepare_handle(), IdleGC);
+}
+
+
 void StartProfilerIdleNotifier(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
   StartProfilerIdleNotifier(env);
@@ -2844,6 +2899,11 @@ void SetupProcessObject(Environment* env,
     // after LoadEnvironment() has run.
   }
 
+  // --idle-gc
+  if (idle_gc) {
+    READONLY_PROPERTY(process, "idleGC", True(env->isolate()));
+  }
+
   size_t exec_path_len = 2 * PATH_MAX;
   char* exec_path = new char[exec_path_len];
   Local<String> exec_path_value;
@@ -3072,6 +3132,8 @@ static void PrintHelp() {
          "  --trace-deprecation  show stack traces on deprecations\n"
          "  --trace-sync-io      show stack trace when use of sync IO\n"
          "                       is detected after the first tick\n"
+         "  --idle-gc            collect garbage while the event loop\n"
+         "                       is waiting for I/O\n"
          "  --v8-options         print v8 command line options\n"
 #if defined(NODE_HAVE_I18N_SUPPORT)
          "  --icu-data-dir=dir   set ICU data load path to dir\n"
@@ -3090,6 +3152,9 @@ static void PrintHelp() {
 #endif
          "                       prefixed to the module search path.\n"
          "NODE_DISABLE_COLORS    Set to 1 to disable colors in the REPL\n"
+         "NODE_CRYPTO_THREADPOOL_SIZE\n"
+         "                       Number of threads for crypto.pbkdf2(),\n"
+         "                       uses libuv's threadpool when unset\n"
 #if defined(NODE_HAVE_I18N_SUPPORT)
          "NODE_ICU_DATA          Data path for ICU (Intl object) data\n"
 #if !defined(NODE_HAVE_SMALL_ICU)
@@ -3194,6 +3259,8 @@ static void ParseArgs(int* argc,
       trace_deprecation = true;
     } else if (strcmp(arg, "--trace-sync-io") == 0) {
       trace_sync_io = true;
+    } else if (strcmp(arg, "--idle-gc") == 0) {
+      idle_gc = true;
     } else if (strcmp(arg, "--throw-deprecation") == 0) {
       throw_deprecation = true;
     } else if (strcmp(arg, "--abort-on-uncaught-exception") == 0 ||
@@ -3843,6 +3910,19 @@ Environment* CreateEnvironment(Isolate* isolate,
   uv_unref(reinterpret_cast<uv_handle_t*>(env->idle_prepare_handle()));
   uv_unref(reinterpret_cast<uv_handle_t*>(env->idle_check_handle()));
 
+  // Event loop instrumentation, see src/node_loop_metrics.cc.
+  uv_prepare_init(env->event_loop(), env->loop_metrics_prepare_handle());
+  uv_check_init(env->event_loop(), env->loop_metrics_check_handle());
+  uv_unref(reinterpret_cast<uv_handle_t*>(env->loop_metrics_prepare_handle()));
+  uv_unref(reinterpret_cast<uv_handle_t*>(env->loop_metrics_check_handle()));
+
+  // Give the garbage collector the time the loop would otherwise spend
+  // waiting for I/O, see IdleGC().
+  uv_prepare_init(env->event_loop(), env->idle_gc_prepare_handle());
+  uv_unref(reinterpret_cast<uv_handle_t*>(env->idle_gc_prepare_handle()));
+
+  LoadAsyncWrapperInfo(env);
+
   // Register handle cleanups
   env->RegisterHandleCleanup(
       reinterpret_cast<uv_handle_t*>(env->immediate_check_handle()),
@@ -3860,11 +3940,27 @@ Environment* CreateEnvironment(Isolate* isolate,
       reinterpret_cast<uv_handle_t*>(env->idle_check_handle()),
       HandleCleanup,
       nullptr);
+  env->RegisterHandleCleanup(
+      reinterpret_cast<uv_handle_t*>(env->idle_gc_prepare_handle()),
+      HandleCleanup,
+      nullptr);
+  env->RegisterHandleCleanup(
+      reinterpret_cast<uv_handle_t*>(env->loop_metrics_prepare_handle()),
+      HandleCleanup,
+      nullptr);
+  env->RegisterHandleCleanup(
+      reinterpret_cast<uv_handle_t*>(env->loop_metrics_check_handle()),
+      HandleCleanup,
+      nullptr);
 
   if (v8_is_profiling) {
     StartProfilerIdleNotifier(env);
   }
 
+  if (idle_gc) {
+    StartIdleGC(env);
+  }
+
   Local<FunctionTemplate> process_template = FunctionTemplate::New(isolate);
   process_template->SetClassName(FIXED_ONE_BYTE_STRING(isolate, "process"));
 
@@ -42,6 +42,8 @@
       startup.processChannel();
 
     startup.processRawDebug();
+    startup.processLoopMetrics();
+    startup.processAsyncResourceStats();
 
     process.argv[0] = process.execPath;
 
@@ -837,6 +839,42 @@
   };
 
   // Load preload modules
+  startup.processLoopMetrics = function() {
+    var loopMetrics;
+
+    function lazyLoopMetrics() {
+      if (!loopMetrics)
+        loopMetrics = NativeModule.require('internal/loop_metrics');
+      return loopMetrics;
+    }
+
+    process.startLoopMetrics = function() {
+      lazyLoopMetrics().start();
+    };
+
+    process.stopLoopMetrics = function() {
+      lazyLoopMetrics().stop();
+    };
+
+    process.resetLoopMetrics = function() {
+      lazyLoopMetrics().reset();
+    };
+
+    process.loopMetrics = function() {
+      return lazyLoopMetrics().get();
+    };
+  };
+
+  startup.processAsyncResourceStats = function() {
+    var asyncStats;
+
+    process.getAsyncResourceStats = function(options) {
+      if (!asyncStats)
+        asyncStats = NativeModule.require('internal/async_stats');
+      return asyncStats.get(!!(options && options.nativeBytes));
+    };
+  };
+
   startup.preloadModules = function() {
     if (process._preload_modules) {
       NativeModule.require('module')._preloadModules(process._preload_modules);
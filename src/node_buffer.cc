@@ -123,7 +123,8 @@ Local<Object> New(Environment* env, size_t length) {
   Local<Value> arg = Uint32::NewFromUnsigned(env->isolate(), length);
   Local<Object> obj = env->buffer_constructor_function()->NewInstance(1, &arg);
 
-  smalloc::Alloc(env, obj, length);
+  if (!smalloc::SlabAlloc(env, obj, length))
+    smalloc::Alloc(env, obj, length);
 
   return scope.Escape(obj);
 }
@@ -148,6 +149,11 @@ Local<Object> New(Environment* env, const char* data, size_t length) {
   Local<Value> arg = Uint32::NewFromUnsigned(env->isolate(), length);
   Local<Object> obj = env->buffer_constructor_function()->NewInstance(1, &arg);
 
+  if (smalloc::SlabAlloc(env, obj, length)) {
+    memcpy(Data(obj), data, length);
+    return scope.Escape(obj);
+  }
+
   // TODO(trevnorris): done like this to handle HasInstance since only checks
   // if external array data has been set, but would like to use a better
   // approach if v8 provided one.
@@ -0,0 +1,348 @@
+#include "node.h"
+#include "base-object.h"
+#include "base-object-inl.h"
+#include "env.h"
+#include "env-inl.h"
+#include "util.h"
+#include "util-inl.h"
+#include "v8.h"
+
+#include <fcntl.h>
+#include <string.h>
+
+#ifdef _WIN32
+# include <io.h>
+# include <windows.h>
+#else
+# include <sys/mman.h>
+#endif
+
+namespace node {
+namespace bundle {
+
+using v8::Array;
+using v8::Context;
+using v8::FunctionCallbackInfo;
+using v8::FunctionTemplate;
+using v8::Handle;
+using v8::Integer;
+using v8::Local;
+using v8::Object;
+using v8::String;
+using v8::Value;
+
+// A module bundle is a single file with the sources of many modules, read
+// by lib/internal/module_bundle.js.  All integers are 32 bits little
+// endian, offsets are relative to the start of the file:
+//
+//   char     magic[8]       "NODEBNDL"
+//   uint32   version        kVersion
+//   uint32   count
+//   entry    entries[count]
+//   ...      path and source data
+//
+// where every entry is
+//
+//   uint32   path_offset    UTF-8 absolute path of the module
+//   uint32   path_length
+//   uint32   source_offset  UTF-8 source
+//   uint32   source_length
+//   uint32   flags          kSourceIsAscii
+//
+// The file is mapped into memory once.  ASCII sources are handed to V8 as
+// external strings that point straight into the mapping, the others are
+// decoded into regular strings.  V8 expects external strings never to
+// change, so a bundle that is in use must be replaced by renaming a new
+// file over it, not rewritten in place.  Even with a private mapping,
+// changes to the file can show through, and truncating it makes reads fault
+// with SIGBUS.
+
+static const char kMagic[8] = { 'N', 'O', 'D', 'E', 'B', 'N', 'D', 'L' };
+static const uint32_t kVersion = 1;
+static const size_t kHeaderSize = sizeof(kMagic) + 2 * sizeof(uint32_t);
+static const size_t kEntrySize = 5 * sizeof(uint32_t);
+
+enum EntryFieldIndex {
+  kPathOffset,
+  kPathLength,
+  kSourceOffset,
+  kSourceLength,
+  kFlags
+};
+
+enum EntryFlags {
+  kSourceIsAscii = 1
+};
+
+
+// A read-only mapping of the bundle file.  It stays alive as long as the
+// ModuleBundle object or any string pointing into it does.
+class Mapping {
+ public:
+  static Mapping* Open(uv_loop_t* loop, const char* filename, int* err);
+
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+
+  void Ref() { refs_++; }
+  void Unref() {
+    if (--refs_ == 0)
+      delete this;
+  }
+
+ private:
+  Mapping(const char* data, size_t size)
+      : data_(data), size_(size), refs_(1) {}
+  ~Mapping();
+
+  const char* const data_;
+  const size_t size_;
+  unsigned refs_;
+};
+
+
+Mapping* Mapping::Open(uv_loop_t* loop, const char* filename, int* err) {
+  uv_fs_t req;
+  const int fd = uv_fs_open(loop, &req, filename, O_RDONLY, 0, nullptr);
+  uv_fs_req_cleanup(&req);
+  if (fd < 0) {
+    *err = fd;
+    return nullptr;
+  }
+
+  *err = uv_fs_fstat(loop, &req, fd, nullptr);
+  const uint64_t size =
+      *err == 0 ? static_cast<const uv_stat_t*>(req.ptr)->st_size : 0;
+  uv_fs_req_cleanup(&req);
+
+  void* data = nullptr;
+  if (*err == 0 && (size == 0 || size > 0xFFFFFFFFu)) {
+    *err = UV_EINVAL;
+  } else if (*err == 0) {
+#ifdef _WIN32
+    HANDLE file = reinterpret_cast<HANDLE>(_get_osfhandle(fd));
+    HANDLE mapping =
+        CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping != nullptr) {
+      data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+      CloseHandle(mapping);
+    }
+    if (data == nullptr)
+      *err = UV_ENOMEM;
+#else
+    data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      data = nullptr;
+      *err = -errno;
+    }
+#endif
+  }
+
+  uv_fs_close(loop, &req, fd, nullptr);
+  uv_fs_req_cleanup(&req);
+
+  if (data == nullptr)
+    return nullptr;
+  return new Mapping(static_cast<const char*>(data), size);
+}
+
+
+Mapping::~Mapping() {
+#ifdef _WIN32
+  UnmapViewOfFile(data_);
+#else
+  munmap(const_cast<char*>(data_), size_);
+#endif
+}
+
+
+// Source string that points into the mapping.
+class ExternalSource : public String::ExternalOneByteStringResource {
+ public:
+  ExternalSource(Mapping* mapping, const char* data, size_t length)
+      : mapping_(mapping), data_(data), length_(length) {
+    mapping_->Ref();
+  }
+
+  ~ExternalSource() override {
+    mapping_->Unref();
+  }
+
+  const char* data() const override { return data_; }
+  size_t length() const override { return length_; }
+
+ private:
+  Mapping* const mapping_;
+  const char* const data_;
+  const size_t length_;
+};
+
+
+static inline uint32_t ReadUint32(const char* p) {
+  const unsigned char* b = reinterpret_cast<const unsigned char*>(p);
+  return b[0] | (b[1] << 8) | (b[2] << 16) |
+         (static_cast<uint32_t>(b[3]) << 24);
+}
+
+
+class ModuleBundle : public BaseObject {
+ public:
+  static void Initialize(Environment* env, Local<Object> target);
+
+  ~ModuleBundle() override {
+    mapping_->Unref();
+  }
+
+ private:
+  ModuleBundle(Environment* env, Local<Object> object, Mapping* mapping)
+      : BaseObject(env, object),
+        mapping_(mapping),
+        count_(ReadUint32(mapping->data() + sizeof(kMagic) + 4)) {
+    MakeWeak<ModuleBundle>(this);
+  }
+
+  static bool Validate(const Mapping* mapping);
+
+  const char* Entry(uint32_t index) const {
+    return mapping_->data() + kHeaderSize + index * kEntrySize;
+  }
+
+  uint32_t Field(uint32_t index, EntryFieldIndex field) const {
+    return ReadUint32(Entry(index) + field * sizeof(uint32_t));
+  }
+
+  static void New(const FunctionCallbackInfo<Value>& args);
+  static void Paths(const FunctionCallbackInfo<Value>& args);
+  static void Source(const FunctionCallbackInfo<Value>& args);
+
+  Mapping* const mapping_;
+  const uint32_t count_;
+};
+
+
+bool ModuleBundle::Validate(const Mapping* mapping) {
+  const char* data = mapping->data();
+  const size_t size = mapping->size();
+
+  if (size < kHeaderSize ||
+      memcmp(data, kMagic, sizeof(kMagic)) != 0 ||
+      ReadUint32(data + sizeof(kMagic)) != kVersion) {
+    return false;
+  }
+
+  const uint64_t count = ReadUint32(data + sizeof(kMagic) + 4);
+  if (kHeaderSize + count * kEntrySize > size)
+    return false;
+
+  for (uint64_t i = 0; i < count; i++) {
+    const char* entry = data + kHeaderSize + i * kEntrySize;
+    const uint64_t path_end = static_cast<uint64_t>(ReadUint32(entry)) +
+                              ReadUint32(entry + 4);
+    const uint64_t source_end = static_cast<uint64_t>(ReadUint32(entry + 8)) +
+                                ReadUint32(entry + 12);
+    if (path_end > size || source_end > size)
+      return false;
+  }
+
+  return true;
+}
+
+
+void ModuleBundle::New(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  CHECK(args.IsConstructCall());
+
+  if (!args[0]->IsString())
+    return env->ThrowTypeError("filename must be a string");
+
+  node::Utf8Value filename(env->isolate(), args[0]);
+  int err;
+  Mapping* mapping = Mapping::Open(env->event_loop(), *filename, &err);
+  if (mapping == nullptr)
+    return env->ThrowUVException(err, "open", nullptr, *filename);
+
+  if (!Validate(mapping)) {
+    mapping->Unref();
+    return env->ThrowError("Invalid module bundle");
+  }
+
+  new ModuleBundle(env, args.This(), mapping);
+}
+
+
+// Returns the paths of all modules, in index order.
+void ModuleBundle::Paths(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  ModuleBundle* bundle = Unwrap<ModuleBundle>(args.Holder());
+
+  Local<Array> paths = Array::New(env->isolate(), bundle->count_);
+  for (uint32_t i = 0; i < bundle->count_; i++) {
+    const char* path =
+        bundle->mapping_->data() + bundle->Field(i, kPathOffset);
+    paths->Set(i, String::NewFromUtf8(env->isolate(),
+                                      path,
+                                      String::kNormalString,
+                                      bundle->Field(i, kPathLength)));
+  }
+
+  args.GetReturnValue().Set(paths);
+}
+
+
+void ModuleBundle::Source(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  ModuleBundle* bundle = Unwrap<ModuleBundle>(args.Holder());
+
+  CHECK(args[0]->IsUint32());
+  const uint32_t index = args[0]->Uint32Value();
+  CHECK_LT(index, bundle->count_);
+
+  const char* source =
+      bundle->mapping_->data() + bundle->Field(index, kSourceOffset);
+  const uint32_t length = bundle->Field(index, kSourceLength);
+
+  if (length == 0)
+    return args.GetReturnValue().SetEmptyString();
+
+  if (bundle->Field(index, kFlags) & kSourceIsAscii) {
+    ExternalSource* resource =
+        new ExternalSource(bundle->mapping_, source, length);
+    return args.GetReturnValue().Set(
+        String::NewExternal(env->isolate(), resource));
+  }
+
+  args.GetReturnValue().Set(String::NewFromUtf8(env->isolate(),
+                                                source,
+                                                String::kNormalString,
+                                                length));
+}
+
+
+void ModuleBundle::Initialize(Environment* env, Local<Object> target) {
+  Local<FunctionTemplate> t = env->NewFunctionTemplate(New);
+  t->InstanceTemplate()->SetInternalFieldCount(1);
+  t->SetClassName(FIXED_ONE_BYTE_STRING(env->isolate(), "ModuleBundle"));
+
+  env->SetProtoMethod(t, "paths", Paths);
+  env->SetProtoMethod(t, "source", Source);
+
+  target->Set(FIXED_ONE_BYTE_STRING(env->isolate(), "ModuleBundle"),
+              t->GetFunction());
+  target->Set(FIXED_ONE_BYTE_STRING(env->isolate(), "kVersion"),
+              Integer::NewFromUnsigned(env->isolate(), kVersion));
+  target->Set(FIXED_ONE_BYTE_STRING(env->isolate(), "kSourceIsAscii"),
+              Integer::New(env->isolate(), kSourceIsAscii));
+}
+
+
+void Initialize(Handle<Object> target,
+                Handle<Value> unused,
+                Handle<Context> context) {
+  Environment* env = Environment::GetCurrent(context);
+  ModuleBundle::Initialize(env, target);
+}
+
+}  // namespace bundle
+}  // namespace node
+
+NODE_MODULE_CONTEXT_AWARE_BUILTIN(bundle, node::bundle::Initialize)
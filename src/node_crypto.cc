@@ -17,6 +17,7 @@
 #include <errno.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #if defined(_MSC_VER)
 #define strcasecmp _stricmp
@@ -94,10 +95,23 @@ struct ClearErrorOnReturn {
 
 static uv_rwlock_t* locks;
 
-const char* const root_certs[] = {
-#include "node_root_certs.h"  // NOLINT(build/include_order)
+// The bundled root certificates, converted from src/node_root_certs.h to
+// DER at build time by tools/genrootcerts.py.  Offsets are into
+// root_certs_der.
+struct RootCertificate {
+  size_t offset;
+  size_t length;
+  size_t subject_offset;
+  size_t subject_length;
 };
 
+#include "node_root_certs_der.h"  // NOLINT(build/include_order)
+
+// Subject names of the root certificates, parsed on first use, and whether
+// the certificate has been added to root_cert_store yet.
+static X509_NAME* root_cert_subjects[ARRAY_SIZE(root_certs)];
+static bool root_cert_loaded[ARRAY_SIZE(root_certs)];
+
 X509_STORE* root_cert_store;
 
 // Just to generate static methods
@@ -186,17 +200,23 @@ static int CryptoPemCallback(char *buf, int size, int rwflag, void *u) {
 }
 
 
-void ThrowCryptoError(Environment* env,
-                      unsigned long err,
-                      const char* default_message = nullptr) {
-  HandleScope scope(env->isolate());
+Local<Value> CryptoError(Environment* env,
+                         unsigned long err,
+                         const char* default_message = nullptr) {
   if (err != 0 || default_message == nullptr) {
     char errmsg[128] = { 0 };
     ERR_error_string_n(err, errmsg, sizeof(errmsg));
-    env->ThrowError(errmsg);
-  } else {
-    env->ThrowError(default_message);
+    return Exception::Error(OneByteString(env->isolate(), errmsg));
   }
+  return Exception::Error(OneByteString(env->isolate(), default_message));
+}
+
+
+void ThrowCryptoError(Environment* env,
+                      unsigned long err,
+                      const char* default_message = nullptr) {
+  HandleScope scope(env->isolate());
+  env->isolate()->ThrowException(CryptoError(env, err, default_message));
 }
 
 
@@ -220,7 +240,7 @@ void ThrowCryptoError(Environment* env,
 // The only time when /dev/urandom may conceivably block is right after boot,
 // when the whole system is still low on entropy.  That's not something we can
 // do anything about.
-inline void CheckEntropy() {
+void CheckEntropy() {
   for (;;) {
     int status = RAND_status();
     CHECK_GE(status, 0);  // Cannot fail.
@@ -255,6 +275,8 @@ void SecureContext::Initialize(Environment* env, Handle<Object> target) {
   env->SetProtoMethod(t, "addCACert", SecureContext::AddCACert);
   env->SetProtoMethod(t, "addCRL", SecureContext::AddCRL);
   env->SetProtoMethod(t, "addRootCerts", SecureContext::AddRootCerts);
+  env->SetProtoMethod(t, "initFromCache", SecureContext::InitFromCache);
+  env->SetProtoMethod(t, "addToCache", SecureContext::AddToCache);
   env->SetProtoMethod(t, "setCiphers", SecureContext::SetCiphers);
   env->SetProtoMethod(t, "setECDHCurve", SecureContext::SetECDHCurve);
   env->SetProtoMethod(t, "setDHParam", SecureContext::SetDHParam);
@@ -270,6 +292,9 @@ void SecureContext::Initialize(Environment* env, Handle<Object> target) {
   env->SetProtoMethod(t, "setFreeListLength", SecureContext::SetFreeListLength);
   env->SetProtoMethod(t, "getCertificate", SecureContext::GetCertificate<true>);
   env->SetProtoMethod(t, "getIssuer", SecureContext::GetCertificate<false>);
+  env->SetProtoMethod(t, "setOCSPStaple", SecureContext::SetOCSPStaple);
+  env->SetProtoMethod(t, "clearOCSPStaple", SecureContext::ClearOCSPStaple);
+  env->SetProtoMethod(t, "getOCSPRequest", SecureContext::GetOCSPRequest);
 
   t->PrototypeTemplate()->SetAccessor(
       FIXED_ONE_BYTE_STRING(env->isolate(), "_external"),
@@ -658,6 +683,82 @@ void SecureContext::AddCRL(const FunctionCallbackInfo<Value>& args) {
 
 
 
+// Lookup method of root_cert_store.  The store starts out empty, an issuer
+// is only parsed and added to it when the store is searched for its subject
+// name.  The same subject may belong to more than one root, for example when
+// a CA has been re-issued, so all of them are added at once.
+static int GetRootCertBySubject(X509_LOOKUP* lookup,
+                                int type,
+                                X509_NAME* name,
+                                X509_OBJECT* ret) {
+  if (type != X509_LU_X509)
+    return 0;
+
+  X509_STORE* store = lookup->store_ctx;
+  bool found = false;
+
+  // Don't leave errors behind for the handshake to trip over.
+  ERR_set_mark();
+
+  for (size_t i = 0; i < ARRAY_SIZE(root_certs); i++) {
+    const RootCertificate& cert = root_certs[i];
+
+    if (root_cert_subjects[i] == nullptr) {
+      const unsigned char* p = root_certs_der + cert.subject_offset;
+      root_cert_subjects[i] = d2i_X509_NAME(nullptr, &p, cert.subject_length);
+      if (root_cert_subjects[i] == nullptr)
+        continue;
+    }
+
+    if (X509_NAME_cmp(root_cert_subjects[i], name) != 0)
+      continue;
+
+    found = true;
+    if (root_cert_loaded[i])
+      continue;
+    root_cert_loaded[i] = true;
+
+    const unsigned char* p = root_certs_der + cert.offset;
+    X509* x509 = d2i_X509(nullptr, &p, cert.length);
+    if (x509 == nullptr)
+      continue;
+    X509_STORE_add_cert(store, x509);
+    X509_free(x509);
+  }
+
+  ERR_pop_to_mark();
+
+  if (!found)
+    return 0;
+
+  // Same as the by_dir lookup: the caller takes its own reference.
+  CRYPTO_w_lock(CRYPTO_LOCK_X509_STORE);
+  X509_OBJECT* obj = X509_OBJECT_retrieve_by_subject(store->objs, type, name);
+  CRYPTO_w_unlock(CRYPTO_LOCK_X509_STORE);
+
+  if (obj == nullptr)
+    return 0;
+
+  ret->type = obj->type;
+  ret->data.x509 = obj->data.x509;
+  return 1;
+}
+
+
+static X509_LOOKUP_METHOD root_cert_lookup_method = {
+  "Load bundled root certificates",
+  nullptr,  // new_item
+  nullptr,  // free
+  nullptr,  // init
+  nullptr,  // shutdown
+  nullptr,  // ctrl
+  GetRootCertBySubject,
+  nullptr,  // get_by_issuer_serial
+  nullptr,  // get_by_fingerprint
+  nullptr   // get_by_alias
+};
+
+
 void SecureContext::AddRootCerts(const FunctionCallbackInfo<Value>& args) {
   SecureContext* sc = Unwrap<SecureContext>(args.Holder());
   ClearErrorOnReturn clear_error_on_return;
@@ -667,31 +768,123 @@ void SecureContext::AddRootCerts(const FunctionCallbackInfo<Value>& args) {
 
   if (!root_cert_store) {
     root_cert_store = X509_STORE_new();
+    X509_STORE_add_lookup(root_cert_store, &root_cert_lookup_method);
+  }
+
+  // The store is shared by all contexts, SSL_CTX_free() only drops this
+  // reference.
+  CRYPTO_add(&root_cert_store->references, 1, CRYPTO_LOCK_X509_STORE);
+  sc->ca_store_ = root_cert_store;
+  SSL_CTX_set_cert_store(sc->ctx_, sc->ca_store_);
+}
 
-    for (size_t i = 0; i < ARRAY_SIZE(root_certs); i++) {
-      BIO* bp = NodeBIO::New();
 
-      if (!BIO_write(bp, root_certs[i], strlen(root_certs[i]))) {
-        BIO_free_all(bp);
-        return;
-      }
+// Contexts created by tls.connect(), keyed by a SHA-256 of the options they
+// were created from, see lib/_tls_common.js.  Connections with the same
+// options share one SSL_CTX, and with it the certificate store, instead of
+// parsing the same keys and CA certificates again.  Every entry holds a
+// reference to its SSL_CTX and certificates, the least recently used entry
+// is dropped when the cache is full.  Entries are kept most recently used
+// first.
+struct SecureContextCacheEntry {
+  unsigned char key[SHA256_DIGEST_LENGTH];
+  SSL_CTX* ctx;
+  X509* cert;
+  X509* issuer;
+};
 
-      X509 *x509 = PEM_read_bio_X509(bp, nullptr, CryptoPemCallback, nullptr);
+static const size_t kSecureContextCacheSize = 32;
+static SecureContextCacheEntry secure_context_cache[kSecureContextCacheSize];
+static size_t secure_context_cache_count;
 
-      if (x509 == nullptr) {
-        BIO_free_all(bp);
-        return;
-      }
 
-      X509_STORE_add_cert(root_cert_store, x509);
+static void RemoveSecureContextCacheEntry(size_t index) {
+  memmove(&secure_context_cache[index],
+          &secure_context_cache[index + 1],
+          (secure_context_cache_count - index - 1) *
+              sizeof(secure_context_cache[0]));
+  secure_context_cache_count--;
+}
 
-      BIO_free_all(bp);
-      X509_free(x509);
-    }
+
+static void InsertSecureContextCacheEntry(const SecureContextCacheEntry& e) {
+  CHECK_LT(secure_context_cache_count, kSecureContextCacheSize);
+  memmove(&secure_context_cache[1],
+          &secure_context_cache[0],
+          secure_context_cache_count * sizeof(secure_context_cache[0]));
+  secure_context_cache[0] = e;
+  secure_context_cache_count++;
+}
+
+
+static X509* X509Ref(X509* x509) {
+  if (x509 != nullptr)
+    CRYPTO_add(&x509->references, 1, CRYPTO_LOCK_X509);
+  return x509;
+}
+
+
+// initFromCache(key), returns false if there is no context for that key.
+void SecureContext::InitFromCache(const FunctionCallbackInfo<Value>& args) {
+  SecureContext* sc = Unwrap<SecureContext>(args.Holder());
+
+  CHECK(Buffer::HasInstance(args[0]));
+  CHECK_EQ(Buffer::Length(args[0]), SHA256_DIGEST_LENGTH);
+  CHECK_EQ(sc->ctx_, nullptr);
+  const char* key = Buffer::Data(args[0]);
+
+  for (size_t i = 0; i < secure_context_cache_count; i++) {
+    SecureContextCacheEntry entry = secure_context_cache[i];
+    if (memcmp(entry.key, key, sizeof(entry.key)) != 0)
+      continue;
+
+    RemoveSecureContextCacheEntry(i);
+    InsertSecureContextCacheEntry(entry);
+
+    CRYPTO_add(&entry.ctx->references, 1, CRYPTO_LOCK_SSL_CTX);
+    sc->ctx_ = entry.ctx;
+    sc->ca_store_ = SSL_CTX_get_cert_store(entry.ctx);
+    sc->cert_ = X509Ref(entry.cert);
+    sc->issuer_ = X509Ref(entry.issuer);
+    return args.GetReturnValue().Set(true);
   }
 
-  sc->ca_store_ = root_cert_store;
-  SSL_CTX_set_cert_store(sc->ctx_, sc->ca_store_);
+  args.GetReturnValue().Set(false);
+}
+
+
+// addToCache(key)
+void SecureContext::AddToCache(const FunctionCallbackInfo<Value>& args) {
+  SecureContext* sc = Unwrap<SecureContext>(args.Holder());
+
+  CHECK(Buffer::HasInstance(args[0]));
+  CHECK_EQ(Buffer::Length(args[0]), SHA256_DIGEST_LENGTH);
+  CHECK_NE(sc->ctx_, nullptr);
+  const char* key = Buffer::Data(args[0]);
+
+  for (size_t i = 0; i < secure_context_cache_count; i++) {
+    if (memcmp(secure_context_cache[i].key, key, SHA256_DIGEST_LENGTH) == 0)
+      return;
+  }
+
+  if (secure_context_cache_count == kSecureContextCacheSize) {
+    SecureContextCacheEntry& last =
+        secure_context_cache[secure_context_cache_count - 1];
+    SSL_CTX_free(last.ctx);
+    if (last.cert != nullptr)
+      X509_free(last.cert);
+    if (last.issuer != nullptr)
+      X509_free(last.issuer);
+    secure_context_cache_count--;
+  }
+
+  SecureContextCacheEntry entry;
+  memcpy(entry.key, key, sizeof(entry.key));
+  CRYPTO_add(&sc->ctx_->references, 1, CRYPTO_LOCK_SSL_CTX);
+  entry.ctx = sc->ctx_;
+  entry.cert = X509Ref(sc->cert_);
+  entry.issuer = X509Ref(sc->issuer_);
+  InsertSecureContextCacheEntry(entry);
 }
 
 
@@ -983,6 +1176,206 @@ void SecureContext::GetCertificate(const FunctionCallbackInfo<Value>& args) {
 }
 
 
+#ifdef NODE__HAVE_TLSEXT_STATUS_CB
+// The OCSP response a server staples for its certificate when the client
+// asks for one and no OCSPRequest listener supplied a response.  It's kept
+// with the SSL_CTX, which may outlive the SecureContext object, and freed
+// along with it.
+struct OCSPStaple {
+  unsigned char* data;
+  size_t length;
+  // When the response expires, 0 if it doesn't say.
+  time_t next_update;
+};
+
+static int ocsp_staple_index = -1;
+
+
+static void FreeOCSPStaple(void* parent,
+                           void* ptr,
+                           CRYPTO_EX_DATA* ad,
+                           int idx,
+                           long argl,  // NOLINT(runtime/int)
+                           void* argp) {
+  OCSPStaple* staple = static_cast<OCSPStaple*>(ptr);
+  if (staple == nullptr)
+    return;
+  delete[] staple->data;
+  delete staple;
+}
+
+
+static OCSPStaple* GetOCSPStaple(SSL_CTX* ctx) {
+  return static_cast<OCSPStaple*>(SSL_CTX_get_ex_data(ctx, ocsp_staple_index));
+}
+
+
+static void ResetOCSPStaple(SSL_CTX* ctx, OCSPStaple* staple) {
+  FreeOCSPStaple(ctx, GetOCSPStaple(ctx), nullptr, 0, 0, nullptr);
+  SSL_CTX_set_ex_data(ctx, ocsp_staple_index, staple);
+}
+
+
+// Checks that `der` is a successful OCSP response for the certificate and
+// that it is current, and returns its nextUpdate in `next_update`.  Does not
+// verify the signature, that's up to the client.  Returns nullptr or the
+// reason the response can't be stapled.
+static const char* CheckOCSPResponse(X509* cert,
+                                     X509* issuer,
+                                     const unsigned char* der,
+                                     size_t length,
+                                     time_t* next_update) {
+  const char* reason = nullptr;
+  OCSP_RESPONSE* resp = nullptr;
+  OCSP_BASICRESP* basic = nullptr;
+  OCSP_CERTID* id = nullptr;
+  int status;
+  int crl_reason;
+  ASN1_GENERALIZEDTIME* revoked_at;
+  ASN1_GENERALIZEDTIME* this_update;
+  ASN1_GENERALIZEDTIME* next;
+
+  resp = d2i_OCSP_RESPONSE(nullptr, &der, length);
+  if (resp == nullptr) {
+    reason = "Invalid OCSP response";
+    goto exit;
+  }
+  if (OCSP_response_status(resp) != OCSP_RESPONSE_STATUS_SUCCESSFUL) {
+    reason = "OCSP response is not successful";
+    goto exit;
+  }
+
+  basic = OCSP_response_get1_basic(resp);
+  id = OCSP_cert_to_id(nullptr, cert, issuer);
+  if (basic == nullptr || id == nullptr ||
+      !OCSP_resp_find_status(basic,
+                             id,
+                             &status,
+                             &crl_reason,
+                             &revoked_at,
+                             &this_update,
+                             &next)) {
+    reason = "OCSP response is not for this certificate";
+    goto exit;
+  }
+
+  // Allow for 5 minutes of clock skew.
+  if (!OCSP_check_validity(this_update, next, 300, -1)) {
+    reason = "OCSP response is not valid at this time";
+    goto exit;
+  }
+
+  *next_update = 0;
+  if (next != nullptr) {
+    int days;
+    int seconds;
+    if (!ASN1_TIME_diff(&days, &seconds, nullptr, next)) {
+      reason = "Invalid OCSP response";
+      goto exit;
+    }
+    *next_update = time(nullptr) + days * 86400 + seconds;
+  }
+
+ exit:
+  if (id != nullptr)
+    OCSP_CERTID_free(id);
+  if (basic != nullptr)
+    OCSP_BASICRESP_free(basic);
+  if (resp != nullptr)
+    OCSP_RESPONSE_free(resp);
+  return reason;
+}
+#endif  // NODE__HAVE_TLSEXT_STATUS_CB
+
+
+// setOCSPStaple(response) stores the response for servers that use this
+// context to staple.  Returns its nextUpdate in ms since the epoch, or 0 if
+// it doesn't have one.
+void SecureContext::SetOCSPStaple(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+#ifdef NODE__HAVE_TLSEXT_STATUS_CB
+  SecureContext* sc = Unwrap<SecureContext>(args.Holder());
+
+  THROW_AND_RETURN_IF_NOT_BUFFER(args[0]);
+  const unsigned char* data =
+      reinterpret_cast<const unsigned char*>(Buffer::Data(args[0]));
+  const size_t length = Buffer::Length(args[0]);
+
+  if (sc->cert_ == nullptr || sc->issuer_ == nullptr)
+    return env->ThrowError("Certificate or its issuer is not known");
+
+  ClearErrorOnReturn clear_error_on_return;
+  (void) &clear_error_on_return;  // Silence compiler warning.
+
+  time_t next_update;
+  const char* reason =
+      CheckOCSPResponse(sc->cert_, sc->issuer_, data, length, &next_update);
+  if (reason != nullptr)
+    return env->ThrowError(reason);
+
+  OCSPStaple* staple = new OCSPStaple;
+  staple->data = new unsigned char[length];
+  staple->length = length;
+  staple->next_update = next_update;
+  memcpy(staple->data, data, length);
+  ResetOCSPStaple(sc->ctx_, staple);
+
+  args.GetReturnValue().Set(static_cast<double>(next_update) * 1000);
+#else
+  env->ThrowError("OCSP stapling is not supported");
+#endif  // NODE__HAVE_TLSEXT_STATUS_CB
+}
+
+
+void SecureContext::ClearOCSPStaple(const FunctionCallbackInfo<Value>& args) {
+#ifdef NODE__HAVE_TLSEXT_STATUS_CB
+  SecureContext* sc = Unwrap<SecureContext>(args.Holder());
+  ResetOCSPStaple(sc->ctx_, nullptr);
+#endif  // NODE__HAVE_TLSEXT_STATUS_CB
+}
+
+
+// getOCSPRequest() returns [url, request] for the OCSP responder of the
+// certificate, or null if it doesn't name one.
+void SecureContext::GetOCSPRequest(const FunctionCallbackInfo<Value>& args) {
+  SecureContext* sc = Unwrap<SecureContext>(args.Holder());
+  Environment* env = sc->env();
+
+  args.GetReturnValue().Set(Null(env->isolate()));
+  if (sc->cert_ == nullptr || sc->issuer_ == nullptr)
+    return;
+
+  STACK_OF(OPENSSL_STRING)* urls = X509_get1_ocsp(sc->cert_);
+  if (urls == nullptr)
+    return;
+  Local<String> url =
+      OneByteString(env->isolate(), sk_OPENSSL_STRING_value(urls, 0));
+  X509_email_free(urls);
+
+  OCSP_REQUEST* req = OCSP_REQUEST_new();
+  OCSP_CERTID* id = OCSP_cert_to_id(nullptr, sc->cert_, sc->issuer_);
+  if (req == nullptr || id == nullptr || !OCSP_request_add0_id(req, id)) {
+    if (id != nullptr)
+      OCSP_CERTID_free(id);
+    if (req != nullptr)
+      OCSP_REQUEST_free(req);
+    return ThrowCryptoError(env, ERR_get_error());
+  }
+
+  int size = i2d_OCSP_REQUEST(req, nullptr);
+  Local<Object> buff = Buffer::New(env, size);
+  unsigned char* serialized =
+      reinterpret_cast<unsigned char*>(Buffer::Data(buff));
+  i2d_OCSP_REQUEST(req, &serialized);
+  OCSP_REQUEST_free(req);
+
+  Local<Array> result = Array::New(env->isolate(), 2);
+  result->Set(0, url);
+  result->Set(1, buff);
+  args.GetReturnValue().Set(result);
+}
+
+
 template <class Base>
 void SSLWrap<Base>::AddMethods(Environment* env, Handle<FunctionTemplate> t) {
   HandleScope scope(env->isolate());
@@ -1857,8 +2250,22 @@ int SSLWrap<Base>::TLSExtStatusCallback(SSL* s, void* arg) {
     return 1;
   } else {
     // Outgoing response
-    if (w->ocsp_response_.IsEmpty())
-      return SSL_TLSEXT_ERR_NOACK;
+    if (w->ocsp_response_.IsEmpty()) {
+      // Staple the cached response of the context, if it is still current.
+      OCSPStaple* staple = GetOCSPStaple(SSL_get_SSL_CTX(s));
+      if (staple == nullptr ||
+          (staple->next_update != 0 && staple->next_update <= time(nullptr))) {
+        return SSL_TLSEXT_ERR_NOACK;
+      }
+
+      unsigned char* data =
+          static_cast<unsigned char*>(OPENSSL_malloc(staple->length));
+      CHECK_NE(data, nullptr);
+      memcpy(data, staple->data, staple->length);
+      if (!SSL_set_tlsext_status_ocsp_resp(s, data, staple->length))
+        OPENSSL_free(data);
+      return SSL_TLSEXT_ERR_OK;
+    }
 
     Local<Object> obj = PersistentToLocal(env->isolate(), w->ocsp_response_);
     char* resp = Buffer::Data(obj);
@@ -2183,6 +2590,20 @@ void Connection::NewSessionDoneCb() {
 }
 
 
+size_t Connection::self_size() const {
+  size_t size = sizeof(*this);
+  // The BIOs are owned by ssl_.
+  if (ssl_ != nullptr) {
+    size += kExternalSize;
+    if (bio_read_ != nullptr)
+      size += NodeBIO::FromBIO(bio_read_)->AllocatedSize();
+    if (bio_write_ != nullptr)
+      size += NodeBIO::FromBIO(bio_write_)->AllocatedSize();
+  }
+  return size;
+}
+
+
 void Connection::Initialize(Environment* env, Handle<Object> target) {
   Local<FunctionTemplate> t = env->NewFunctionTemplate(Connection::New);
   t->InstanceTemplate()->SetInternalFieldCount(1);
@@ -3248,84 +3669,429 @@ void Hash::HashDigest(const FunctionCallbackInfo<Value>& args) {
 }
 
 
-void SignBase::CheckThrow(SignBase::Error error) {
-  HandleScope scope(env()->isolate());
-
-  switch (error) {
-    case kSignUnknownDigest:
-      return env()->ThrowError("Unknown message digest");
-
-    case kSignNotInitialised:
-      return env()->ThrowError("Not initialised");
+// Parses a PEM key the way Sign#sign(), Verify#verify() and the public key
+// ciphers expect it.  Returns a new reference or nullptr with the reason on
+// the OpenSSL error queue.
+static EVP_PKEY* ParsePKey(const char* key_pem,
+                           int key_pem_len,
+                           const char* passphrase,
+                           PKeyKind kind) {
+  EVP_PKEY* pkey = nullptr;
+  X509* x509 = nullptr;
 
-    case kSignInit:
-    case kSignUpdate:
-    case kSignPrivateKey:
-    case kSignPublicKey:
-      {
-        unsigned long err = ERR_get_error();
-        if (err)
-          return ThrowCryptoError(env(), err);
-        switch (error) {
-          case kSignInit:
-            return env()->ThrowError("EVP_SignInit_ex failed");
-          case kSignUpdate:
-            return env()->ThrowError("EVP_SignUpdate failed");
-          case kSignPrivateKey:
-            return env()->ThrowError("PEM_read_bio_PrivateKey failed");
-          case kSignPublicKey:
-            return env()->ThrowError("PEM_read_bio_PUBKEY failed");
-          default:
-            abort();
-        }
-      }
+  BIO* bp = BIO_new_mem_buf(const_cast<char*>(key_pem), key_pem_len);
+  if (bp == nullptr)
+    return nullptr;
 
-    case kSignOk:
-      return;
+  // Check if this is a PKCS#8 or RSA public key before trying as X.509 or
+  // private key.
+  if (kind != kPKeyPrivate &&
+      strncmp(key_pem, PUBLIC_KEY_PFX, PUBLIC_KEY_PFX_LEN) == 0) {
+    pkey = PEM_read_bio_PUBKEY(bp, nullptr, CryptoPemCallback, nullptr);
+  } else if (kind != kPKeyPrivate &&
+             strncmp(key_pem, PUBRSA_KEY_PFX, PUBRSA_KEY_PFX_LEN) == 0) {
+    RSA* rsa =
+        PEM_read_bio_RSAPublicKey(bp, nullptr, CryptoPemCallback, nullptr);
+    if (rsa) {
+      pkey = EVP_PKEY_new();
+      if (pkey)
+        EVP_PKEY_set1_RSA(pkey, rsa);
+      RSA_free(rsa);
+    }
+  } else if (kind == kPKeyPublicOrCert ||
+             (kind == kPKeyPublicOrPrivate &&
+              strncmp(key_pem, CERTIFICATE_PFX, CERTIFICATE_PFX_LEN) == 0)) {
+    x509 = PEM_read_bio_X509(bp, nullptr, CryptoPemCallback, nullptr);
+    if (x509 != nullptr)
+      pkey = X509_get_pubkey(x509);
+  } else {
+    pkey = PEM_read_bio_PrivateKey(bp,
+                                   nullptr,
+                                   CryptoPemCallback,
+                                   const_cast<char*>(passphrase));
   }
-}
-
 
+  if (x509 != nullptr)
+    X509_free(x509);
+  BIO_free_all(bp);
+  return pkey;
+}
 
 
-void Sign::Initialize(Environment* env, v8::Handle<v8::Object> target) {
-  Local<FunctionTemplate> t = env->NewFunctionTemplate(New);
+// The keys of the last few calls, keyed by a SHA-256 of the PEM data, the
+// passphrase and the kind of key.  Services that sign or verify with the
+// same key over and over don't pay for parsing it every time, and the key
+// keeps the Montgomery contexts and blinding OpenSSL attaches to it.  Every
+// entry holds a reference to its EVP_PKEY, most recently used first.
+struct PKeyCacheEntry {
+  unsigned char key[SHA256_DIGEST_LENGTH];
+  EVP_PKEY* pkey;
+};
 
-  t->InstanceTemplate()->SetInternalFieldCount(1);
+static const size_t kPKeyCacheSize = 16;
+static PKeyCacheEntry pkey_cache[kPKeyCacheSize];
+static size_t pkey_cache_count;
 
-  env->SetProtoMethod(t, "init", SignInit);
-  env->SetProtoMethod(t, "update", SignUpdate);
-  env->SetProtoMethod(t, "sign", SignFinal);
 
-  target->Set(FIXED_ONE_BYTE_STRING(env->isolate(), "Sign"), t->GetFunction());
+static EVP_PKEY* PKeyRef(EVP_PKEY* pkey) {
+  CRYPTO_add(&pkey->references, 1, CRYPTO_LOCK_EVP_PKEY);
+  return pkey;
 }
 
 
-void Sign::New(const FunctionCallbackInfo<Value>& args) {
-  Environment* env = Environment::GetCurrent(args);
-  new Sign(env, args.This());
-}
+// Same as ParsePKey() but looks in the cache first.
+static EVP_PKEY* GetPKey(const char* key_pem,
+                         int key_pem_len,
+                         const char* passphrase,
+                         PKeyKind kind) {
+  const unsigned char kind_byte = kind;
+  unsigned char key[SHA256_DIGEST_LENGTH];
+  SHA256_CTX sha;
+  SHA256_Init(&sha);
+  SHA256_Update(&sha, &kind_byte, 1);
+  SHA256_Update(&sha, key_pem, key_pem_len);
+  if (passphrase != nullptr)
+    SHA256_Update(&sha, passphrase, strlen(passphrase) + 1);
+  SHA256_Final(key, &sha);
 
+  for (size_t i = 0; i < pkey_cache_count; i++) {
+    PKeyCacheEntry entry = pkey_cache[i];
+    if (memcmp(entry.key, key, sizeof(key)) != 0)
+      continue;
+    memmove(&pkey_cache[1], &pkey_cache[0], i * sizeof(pkey_cache[0]));
+    pkey_cache[0] = entry;
+    return PKeyRef(entry.pkey);
+  }
 
-SignBase::Error Sign::SignInit(const char* sign_type) {
-  CHECK_EQ(md_, nullptr);
-  md_ = EVP_get_digestbyname(sign_type);
-  if (!md_)
-    return kSignUnknownDigest;
+  EVP_PKEY* pkey = ParsePKey(key_pem, key_pem_len, passphrase, kind);
+  if (pkey == nullptr)
+    return nullptr;
 
-  EVP_MD_CTX_init(&mdctx_);
-  if (!EVP_SignInit_ex(&mdctx_, md_, nullptr))
-    return kSignInit;
-  initialised_ = true;
+  if (pkey_cache_count == kPKeyCacheSize)
+    EVP_PKEY_free(pkey_cache[--pkey_cache_count].pkey);
+  memmove(&pkey_cache[1],
+          &pkey_cache[0],
+          pkey_cache_count * sizeof(pkey_cache[0]));
+  memcpy(pkey_cache[0].key, key, sizeof(key));
+  pkey_cache[0].pkey = PKeyRef(pkey);
+  pkey_cache_count++;
 
-  return kSignOk;
+  return pkey;
 }
 
 
-void Sign::SignInit(const FunctionCallbackInfo<Value>& args) {
-  Sign* sign = Unwrap<Sign>(args.Holder());
+// An OpenSSL operation that runs on the threadpool and calls
+// ondone(err, result) when done.  Subclasses copy whatever they need on the
+// main thread, so the JS objects they came from can be used, or collected,
+// in the meantime.
+class CryptoJob : public AsyncWrap {
+ public:
+  CryptoJob(Environment* env, Local<Object> object, const char* default_error)
+      : AsyncWrap(env, object, AsyncWrap::PROVIDER_CRYPTO),
+        default_error_(default_error),
+        ok_(false),
+        error_(0) {
+  }
 
-  if (args.Length() == 0 || !args[0]->IsString()) {
+  ~CryptoJob() override {
+    persistent().Reset();
+  }
+
+  void Queue() {
+    uv_queue_work(env()->event_loop(), &work_req_, Work, After);
+  }
+
+  // An object for the request with `callback` as its ondone function.
+  static Local<Object> NewObject(Environment* env, Local<Value> callback) {
+    Local<Object> obj = Object::New(env->isolate());
+    obj->Set(env->ondone_string(), callback);
+    // XXX(trevnorris): This will need to go with the rest of domains.
+    if (env->in_domain())
+      obj->Set(env->domain_string(), env->domain_array()->Get(0));
+    return obj;
+  }
+
+ protected:
+  // Runs on the threadpool.  Returns false with the reason on the OpenSSL
+  // error queue, which is per thread.
+  virtual bool DoWork() = 0;
+  // Runs on the main thread once DoWork() succeeded.
+  virtual Local<Value> Result() = 0;
+
+ private:
+  static void Work(uv_work_t* work_req) {
+    CryptoJob* req = ContainerOf(&CryptoJob::work_req_, work_req);
+    req->ok_ = req->DoWork();
+    if (!req->ok_)
+      req->error_ = ERR_get_error();
+    ERR_clear_error();
+  }
+
+  static void After(uv_work_t* work_req, int status) {
+    CHECK_EQ(status, 0);
+    CryptoJob* req = ContainerOf(&CryptoJob::work_req_, work_req);
+    Environment* env = req->env();
+    HandleScope handle_scope(env->isolate());
+    Context::Scope context_scope(env->context());
+
+    Local<Value> argv[2];
+    if (req->ok_) {
+      argv[0] = Null(env->isolate());
+      argv[1] = req->Result();
+    } else {
+      argv[0] = CryptoError(env, req->error_, req->default_error_);
+      argv[1] = Undefined(env->isolate());
+    }
+    req->MakeCallback(env->ondone_string(), ARRAY_SIZE(argv), argv);
+    delete req;
+  }
+
+  uv_work_t work_req_;
+  const char* const default_error_;
+  bool ok_;
+  unsigned long error_;
+};
+
+
+// Sign#sign(), Verify#verify() and the public key ciphers when they are
+// given a callback.  The key is parsed, or found in the cache, on the main
+// thread and the private or public key operation runs on the threadpool.
+class PKeyRequest : public CryptoJob {
+ public:
+  PKeyRequest(Environment* env,
+              Local<Object> object,
+              EVP_PKEY* pkey,
+              const char* default_error)
+      : CryptoJob(env, object, default_error),
+        pkey_(pkey) {
+  }
+
+  ~PKeyRequest() override {
+    EVP_PKEY_free(pkey_);
+  }
+
+ protected:
+  EVP_PKEY* const pkey_;
+};
+
+
+class SignRequest : public PKeyRequest {
+ public:
+  // Takes over `mdctx`, leaving it cleaned up.
+  SignRequest(Environment* env,
+              Local<Object> object,
+              EVP_PKEY* pkey,
+              EVP_MD_CTX* mdctx)
+      : PKeyRequest(env, object, pkey, "EVP_SignFinal failed"),
+        sig_(new unsigned char[EVP_PKEY_size(pkey)]),
+        sig_len_(0) {
+    EVP_MD_CTX_init(&mdctx_);
+    copied_ = EVP_MD_CTX_copy_ex(&mdctx_, mdctx) == 1;
+    EVP_MD_CTX_cleanup(mdctx);
+  }
+
+  ~SignRequest() override {
+    EVP_MD_CTX_cleanup(&mdctx_);
+    delete[] sig_;
+  }
+
+  size_t self_size() const override {
+    return sizeof(*this) + EVP_PKEY_size(pkey_);
+  }
+
+ protected:
+  bool DoWork() override {
+    return copied_ && EVP_SignFinal(&mdctx_, sig_, &sig_len_, pkey_);
+  }
+
+  Local<Value> Result() override {
+    return Buffer::New(env(), reinterpret_cast<char*>(sig_), sig_len_);
+  }
+
+ private:
+  EVP_MD_CTX mdctx_;
+  bool copied_;
+  unsigned char* const sig_;
+  unsigned int sig_len_;
+};
+
+
+class VerifyRequest : public PKeyRequest {
+ public:
+  // Takes over `mdctx`, leaving it cleaned up.
+  VerifyRequest(Environment* env,
+                Local<Object> object,
+                EVP_PKEY* pkey,
+                EVP_MD_CTX* mdctx,
+                const char* sig,
+                int sig_len)
+      : PKeyRequest(env, object, pkey, "EVP_VerifyFinal failed"),
+        sig_(new unsigned char[sig_len]),
+        sig_len_(sig_len),
+        result_(false) {
+    memcpy(sig_, sig, sig_len);
+    EVP_MD_CTX_init(&mdctx_);
+    copied_ = EVP_MD_CTX_copy_ex(&mdctx_, mdctx) == 1;
+    EVP_MD_CTX_cleanup(mdctx);
+  }
+
+  ~VerifyRequest() override {
+    EVP_MD_CTX_cleanup(&mdctx_);
+    delete[] sig_;
+  }
+
+  size_t self_size() const override {
+    return sizeof(*this) + sig_len_;
+  }
+
+ protected:
+  // Like the synchronous version, a signature that doesn't match is not an
+  // error.
+  bool DoWork() override {
+    if (!copied_)
+      return false;
+    result_ = EVP_VerifyFinal(&mdctx_, sig_, sig_len_, pkey_) == 1;
+    return true;
+  }
+
+  Local<Value> Result() override {
+    return Boolean::New(env()->isolate(), result_);
+  }
+
+ private:
+  EVP_MD_CTX mdctx_;
+  bool copied_;
+  unsigned char* const sig_;
+  const int sig_len_;
+  bool result_;
+};
+
+
+template <PublicKeyCipher::EVP_PKEY_cipher_init_t EVP_PKEY_cipher_init,
+          PublicKeyCipher::EVP_PKEY_cipher_t EVP_PKEY_cipher>
+class PublicKeyCipherRequest : public PKeyRequest {
+ public:
+  PublicKeyCipherRequest(Environment* env,
+                         Local<Object> object,
+                         EVP_PKEY* pkey,
+                         int padding,
+                         const char* data,
+                         int len)
+      : PKeyRequest(env, object, pkey, nullptr),
+        padding_(padding),
+        data_(new unsigned char[len]),
+        len_(len),
+        out_(nullptr),
+        out_len_(0) {
+    memcpy(data_, data, len);
+  }
+
+  ~PublicKeyCipherRequest() override {
+    delete[] data_;
+    delete[] out_;
+  }
+
+  size_t self_size() const override {
+    return sizeof(*this) + len_ + out_len_;
+  }
+
+ protected:
+  bool DoWork() override {
+    return PublicKeyCipher::Cipher<EVP_PKEY_cipher_init, EVP_PKEY_cipher>(
+        pkey_, padding_, data_, len_, &out_, &out_len_);
+  }
+
+  Local<Value> Result() override {
+    return Buffer::New(env(), reinterpret_cast<char*>(out_), out_len_);
+  }
+
+ private:
+  const int padding_;
+  unsigned char* const data_;
+  const int len_;
+  unsigned char* out_;
+  size_t out_len_;
+};
+
+
+void SignBase::CheckThrow(SignBase::Error error) {
+  HandleScope scope(env()->isolate());
+
+  switch (error) {
+    case kSignUnknownDigest:
+      return env()->ThrowError("Unknown message digest");
+
+    case kSignNotInitialised:
+      return env()->ThrowError("Not initialised");
+
+    case kSignInit:
+    case kSignUpdate:
+    case kSignPrivateKey:
+    case kSignPublicKey:
+      {
+        unsigned long err = ERR_get_error();
+        if (err)
+          return ThrowCryptoError(env(), err);
+        switch (error) {
+          case kSignInit:
+            return env()->ThrowError("EVP_SignInit_ex failed");
+          case kSignUpdate:
+            return env()->ThrowError("EVP_SignUpdate failed");
+          case kSignPrivateKey:
+            return env()->ThrowError("PEM_read_bio_PrivateKey failed");
+          case kSignPublicKey:
+            return env()->ThrowError("PEM_read_bio_PUBKEY failed");
+          default:
+            abort();
+        }
+      }
+
+    case kSignOk:
+      return;
+  }
+}
+
+
+
+
+void Sign::Initialize(Environment* env, v8::Handle<v8::Object> target) {
+  Local<FunctionTemplate> t = env->NewFunctionTemplate(New);
+
+  t->InstanceTemplate()->SetInternalFieldCount(1);
+
+  env->SetProtoMethod(t, "init", SignInit);
+  env->SetProtoMethod(t, "update", SignUpdate);
+  env->SetProtoMethod(t, "sign", SignFinal);
+
+  target->Set(FIXED_ONE_BYTE_STRING(env->isolate(), "Sign"), t->GetFunction());
+}
+
+
+void Sign::New(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  new Sign(env, args.This());
+}
+
+
+SignBase::Error Sign::SignInit(const char* sign_type) {
+  CHECK_EQ(md_, nullptr);
+  md_ = EVP_get_digestbyname(sign_type);
+  if (!md_)
+    return kSignUnknownDigest;
+
+  EVP_MD_CTX_init(&mdctx_);
+  if (!EVP_SignInit_ex(&mdctx_, md_, nullptr))
+    return kSignInit;
+  initialised_ = true;
+
+  return kSignOk;
+}
+
+
+void Sign::SignInit(const FunctionCallbackInfo<Value>& args) {
+  Sign* sign = Unwrap<Sign>(args.Holder());
+
+  if (args.Length() == 0 || !args[0]->IsString()) {
     return sign->env()->ThrowError("Must give signtype string as argument");
   }
 
@@ -3375,31 +4141,15 @@ SignBase::Error Sign::SignFinal(const char* key_pem,
   if (!initialised_)
     return kSignNotInitialised;
 
-  BIO* bp = nullptr;
-  EVP_PKEY* pkey = nullptr;
   bool fatal = true;
 
-  bp = BIO_new_mem_buf(const_cast<char*>(key_pem), key_pem_len);
-  if (bp == nullptr)
-    goto exit;
-
-  pkey = PEM_read_bio_PrivateKey(bp,
-                                 nullptr,
-                                 CryptoPemCallback,
-                                 const_cast<char*>(passphrase));
-  if (pkey == nullptr)
-    goto exit;
-
-  if (EVP_SignFinal(&mdctx_, *sig, sig_len, pkey))
-    fatal = false;
-
-  initialised_ = false;
-
- exit:
-  if (pkey != nullptr)
+  EVP_PKEY* pkey = GetPKey(key_pem, key_pem_len, passphrase, kPKeyPrivate);
+  if (pkey != nullptr) {
+    if (EVP_SignFinal(&mdctx_, *sig, sig_len, pkey))
+      fatal = false;
+    initialised_ = false;
     EVP_PKEY_free(pkey);
-  if (bp != nullptr)
-    BIO_free_all(bp);
+  }
 
   EVP_MD_CTX_cleanup(&mdctx_);
 
@@ -3432,6 +4182,27 @@ void Sign::SignFinal(const FunctionCallbackInfo<Value>& args) {
   size_t buf_len = Buffer::Length(args[0]);
   char* buf = Buffer::Data(args[0]);
 
+  // sign(key, encoding, passphrase, callback)
+  if (args[3]->IsFunction()) {
+    if (!sign->initialised_)
+      return sign->CheckThrow(kSignNotInitialised);
+
+    EVP_PKEY* pkey = GetPKey(buf,
+                             buf_len,
+                             !args[2]->IsNull() ? *passphrase : nullptr,
+                             kPKeyPrivate);
+    if (pkey == nullptr) {
+      EVP_MD_CTX_cleanup(&sign->mdctx_);
+      sign->initialised_ = false;
+      return sign->CheckThrow(kSignPrivateKey);
+    }
+
+    Local<Object> obj = CryptoJob::NewObject(env, args[3]);
+    SignRequest* req = new SignRequest(env, obj, pkey, &sign->mdctx_);
+    sign->initialised_ = false;
+    return req->Queue();
+  }
+
   md_len = 8192;  // Maximum key size is 8192 bits
   md_value = new unsigned char[md_len];
 
@@ -3550,58 +4321,18 @@ SignBase::Error Verify::VerifyFinal(const char* key_pem,
   ClearErrorOnReturn clear_error_on_return;
   (void) &clear_error_on_return;  // Silence compiler warning.
 
-  EVP_PKEY* pkey = nullptr;
-  BIO* bp = nullptr;
-  X509* x509 = nullptr;
   bool fatal = true;
   int r = 0;
 
-  bp = BIO_new_mem_buf(const_cast<char*>(key_pem), key_pem_len);
-  if (bp == nullptr)
-    goto exit;
-
-  // Check if this is a PKCS#8 or RSA public key before trying as X.509.
-  // Split this out into a separate function once we have more than one
-  // consumer of public keys.
-  if (strncmp(key_pem, PUBLIC_KEY_PFX, PUBLIC_KEY_PFX_LEN) == 0) {
-    pkey = PEM_read_bio_PUBKEY(bp, nullptr, CryptoPemCallback, nullptr);
-    if (pkey == nullptr)
-      goto exit;
-  } else if (strncmp(key_pem, PUBRSA_KEY_PFX, PUBRSA_KEY_PFX_LEN) == 0) {
-    RSA* rsa =
-        PEM_read_bio_RSAPublicKey(bp, nullptr, CryptoPemCallback, nullptr);
-    if (rsa) {
-      pkey = EVP_PKEY_new();
-      if (pkey)
-        EVP_PKEY_set1_RSA(pkey, rsa);
-      RSA_free(rsa);
-    }
-    if (pkey == nullptr)
-      goto exit;
-  } else {
-    // X.509 fallback
-    x509 = PEM_read_bio_X509(bp, nullptr, CryptoPemCallback, nullptr);
-    if (x509 == nullptr)
-      goto exit;
-
-    pkey = X509_get_pubkey(x509);
-    if (pkey == nullptr)
-      goto exit;
-  }
-
-  fatal = false;
-  r = EVP_VerifyFinal(&mdctx_,
-                      reinterpret_cast<const unsigned char*>(sig),
-                      siglen,
-                      pkey);
-
- exit:
-  if (pkey != nullptr)
+  EVP_PKEY* pkey = GetPKey(key_pem, key_pem_len, nullptr, kPKeyPublicOrCert);
+  if (pkey != nullptr) {
+    fatal = false;
+    r = EVP_VerifyFinal(&mdctx_,
+                        reinterpret_cast<const unsigned char*>(sig),
+                        siglen,
+                        pkey);
     EVP_PKEY_free(pkey);
-  if (bp != nullptr)
-    BIO_free_all(bp);
-  if (x509 != nullptr)
-    X509_free(x509);
+  }
 
   EVP_MD_CTX_cleanup(&mdctx_);
   initialised_ = false;
@@ -3649,6 +4380,33 @@ void Verify::VerifyFinal(const FunctionCallbackInfo<Value>& args) {
     hbuf = Buffer::Data(args[1]);
   }
 
+  // verify(key, signature, encoding, callback)
+  if (args[3]->IsFunction()) {
+    Error err = kSignOk;
+    EVP_PKEY* pkey = nullptr;
+    if (!verify->initialised_) {
+      err = kSignNotInitialised;
+    } else {
+      pkey = GetPKey(kbuf, klen, nullptr, kPKeyPublicOrCert);
+      if (pkey == nullptr) {
+        EVP_MD_CTX_cleanup(&verify->mdctx_);
+        verify->initialised_ = false;
+        err = kSignPublicKey;
+      }
+    }
+
+    if (err == kSignOk) {
+      Local<Object> obj = CryptoJob::NewObject(env, args[3]);
+      VerifyRequest* req =
+          new VerifyRequest(env, obj, pkey, &verify->mdctx_, hbuf, hlen);
+      verify->initialised_ = false;
+      req->Queue();
+    }
+    if (args[1]->IsString())
+      delete[] hbuf;
+    return verify->CheckThrow(err);
+  }
+
   bool verify_result;
   Error err = verify->VerifyFinal(kbuf, klen, hbuf, hlen, &verify_result);
   if (args[1]->IsString())
@@ -3659,63 +4417,17 @@ void Verify::VerifyFinal(const FunctionCallbackInfo<Value>& args) {
 }
 
 
-template <PublicKeyCipher::Operation operation,
-          PublicKeyCipher::EVP_PKEY_cipher_init_t EVP_PKEY_cipher_init,
+template <PublicKeyCipher::EVP_PKEY_cipher_init_t EVP_PKEY_cipher_init,
           PublicKeyCipher::EVP_PKEY_cipher_t EVP_PKEY_cipher>
-bool PublicKeyCipher::Cipher(const char* key_pem,
-                             int key_pem_len,
-                             const char* passphrase,
+bool PublicKeyCipher::Cipher(EVP_PKEY* pkey,
                              int padding,
                              const unsigned char* data,
                              int len,
                              unsigned char** out,
                              size_t* out_len) {
-  EVP_PKEY* pkey = nullptr;
   EVP_PKEY_CTX* ctx = nullptr;
-  BIO* bp = nullptr;
-  X509* x509 = nullptr;
   bool fatal = true;
 
-  bp = BIO_new_mem_buf(const_cast<char*>(key_pem), key_pem_len);
-  if (bp == nullptr)
-    goto exit;
-
-  // Check if this is a PKCS#8 or RSA public key before trying as X.509 and
-  // private key.
-  if (operation == kPublic &&
-      strncmp(key_pem, PUBLIC_KEY_PFX, PUBLIC_KEY_PFX_LEN) == 0) {
-    pkey = PEM_read_bio_PUBKEY(bp, nullptr, nullptr, nullptr);
-    if (pkey == nullptr)
-      goto exit;
-  } else if (operation == kPublic &&
-             strncmp(key_pem, PUBRSA_KEY_PFX, PUBRSA_KEY_PFX_LEN) == 0) {
-    RSA* rsa = PEM_read_bio_RSAPublicKey(bp, nullptr, nullptr, nullptr);
-    if (rsa) {
-      pkey = EVP_PKEY_new();
-      if (pkey)
-        EVP_PKEY_set1_RSA(pkey, rsa);
-      RSA_free(rsa);
-    }
-    if (pkey == nullptr)
-      goto exit;
-  } else if (operation == kPublic &&
-             strncmp(key_pem, CERTIFICATE_PFX, CERTIFICATE_PFX_LEN) == 0) {
-    x509 = PEM_read_bio_X509(bp, nullptr, CryptoPemCallback, nullptr);
-    if (x509 == nullptr)
-      goto exit;
-
-    pkey = X509_get_pubkey(x509);
-    if (pkey == nullptr)
-      goto exit;
-  } else {
-    pkey = PEM_read_bio_PrivateKey(bp,
-                                   nullptr,
-                                   CryptoPemCallback,
-                                   const_cast<char*>(passphrase));
-    if (pkey == nullptr)
-      goto exit;
-  }
-
   ctx = EVP_PKEY_CTX_new(pkey, nullptr);
   if (!ctx)
     goto exit;
@@ -3735,10 +4447,6 @@ bool PublicKeyCipher::Cipher(const char* key_pem,
   fatal = false;
 
  exit:
-  if (pkey != nullptr)
-    EVP_PKEY_free(pkey);
-  if (bp != nullptr)
-    BIO_free_all(bp);
   if (ctx != nullptr)
     EVP_PKEY_CTX_free(ctx);
 
@@ -3764,18 +4472,34 @@ void PublicKeyCipher::Cipher(const FunctionCallbackInfo<Value>& args) {
 
   String::Utf8Value passphrase(args[3]);
 
+  EVP_PKEY* pkey = GetPKey(
+      kbuf,
+      klen,
+      args.Length() >= 4 && !args[3]->IsNull() ? *passphrase : nullptr,
+      operation == kPublic ? kPKeyPublicOrPrivate : kPKeyPrivate);
+  if (pkey == nullptr)
+    return ThrowCryptoError(env, ERR_get_error());
+
+  // cipher(key, buffer, padding, passphrase, callback)
+  if (args[4]->IsFunction()) {
+    Local<Object> obj = CryptoJob::NewObject(env, args[4]);
+    PKeyRequest* req =
+        new PublicKeyCipherRequest<EVP_PKEY_cipher_init, EVP_PKEY_cipher>(
+            env, obj, pkey, padding, buf, len);
+    return req->Queue();
+  }
+
   unsigned char* out_value = nullptr;
   size_t out_len = 0;
 
-  bool r = Cipher<operation, EVP_PKEY_cipher_init, EVP_PKEY_cipher>(
-      kbuf,
-      klen,
-      args.Length() >= 3 && !args[2]->IsNull() ? *passphrase : nullptr,
+  bool r = Cipher<EVP_PKEY_cipher_init, EVP_PKEY_cipher>(
+      pkey,
       padding,
       reinterpret_cast<const unsigned char*>(buf),
       len,
       &out_value,
       &out_len);
+  EVP_PKEY_free(pkey);
 
   if (out_len == 0 || !r) {
     delete[] out_value;
@@ -3793,6 +4517,428 @@ void PublicKeyCipher::Cipher(const FunctionCallbackInfo<Value>& args) {
 }
 
 
+// Pre-generated keys for ECDH#generateKeys() and
+// DiffieHellmanGroup#generateKeys(), one pool per curve or group.  A key
+// that is taken out of a pool is replaced in the background, so a handshake
+// that needs an ephemeral key doesn't have to wait for one.  Pools are only
+// touched on the main thread, generating a key only reads the curve or
+// group.  They live as long as the process.
+class KeyPool {
+ public:
+  static const unsigned int kMaxSize = 64;
+
+  // The pool for a curve or modp group name, created empty.  Returns
+  // nullptr for an unknown name.
+  static KeyPool* Get(const char* name);
+
+  // A key from the pool for the given curve or group, or nullptr if the
+  // pool is empty.  Takes over the reference.
+  static EVP_PKEY* Take(Environment* env, int nid, int group);
+
+  // Generates a key; runs on the threadpool.
+  EVP_PKEY* Generate() const;
+
+  void Add(EVP_PKEY* pkey);
+  void Resize(unsigned int size);
+  // Queues the missing keys on the threadpool, one job per key.
+  void Refill(Environment* env);
+
+  unsigned int missing() const {
+    if (count_ + pending_ >= size_)
+      return 0;
+    return size_ - count_ - pending_;
+  }
+
+  void AddPending(unsigned int n) { pending_ += n; }
+  void RemovePending(unsigned int n) { pending_ -= n; }
+
+ private:
+  KeyPool(int nid, int group)
+      : next_(pools_),
+        nid_(nid),
+        group_(group),
+        size_(0),
+        pending_(0),
+        count_(0) {
+    pools_ = this;
+  }
+
+  struct RefillRequest {
+    uv_work_t work_req;
+    KeyPool* pool;
+    EVP_PKEY* pkey;
+  };
+
+  static void RefillWork(uv_work_t* work_req);
+  static void RefillAfter(uv_work_t* work_req, int status);
+
+  static KeyPool* pools_;
+
+  KeyPool* const next_;
+  // The curve, NID_undef for DH groups.
+  const int nid_;
+  // Index into modp_groups, -1 for curves.
+  const int group_;
+  unsigned int size_;
+  unsigned int pending_;
+  unsigned int count_;
+  EVP_PKEY* keys_[kMaxSize];
+};
+
+
+KeyPool* KeyPool::pools_;
+
+
+KeyPool* KeyPool::Get(const char* name) {
+  int nid = NID_undef;
+  int group = -1;
+  for (unsigned int i = 0; i < ARRAY_SIZE(modp_groups); ++i) {
+    if (strcasecmp(name, modp_groups[i].name) == 0)
+      group = i;
+  }
+  if (group == -1) {
+    nid = OBJ_sn2nid(name);
+    if (nid == NID_undef)
+      return nullptr;
+    EC_GROUP* ec_group = EC_GROUP_new_by_curve_name(nid);
+    if (ec_group == nullptr)
+      return nullptr;
+    EC_GROUP_free(ec_group);
+  }
+
+  for (KeyPool* pool = pools_; pool != nullptr; pool = pool->next_) {
+    if (pool->nid_ == nid && pool->group_ == group)
+      return pool;
+  }
+  return new KeyPool(nid, group);
+}
+
+
+EVP_PKEY* KeyPool::Take(Environment* env, int nid, int group) {
+  for (KeyPool* pool = pools_; pool != nullptr; pool = pool->next_) {
+    if (pool->nid_ != nid || pool->group_ != group)
+      continue;
+    if (pool->count_ == 0)
+      return nullptr;
+    EVP_PKEY* pkey = pool->keys_[--pool->count_];
+    pool->Refill(env);
+    return pkey;
+  }
+  return nullptr;
+}
+
+
+EVP_PKEY* KeyPool::Generate() const {
+  EVP_PKEY* pkey = EVP_PKEY_new();
+  if (pkey == nullptr)
+    return nullptr;
+
+  if (nid_ != NID_undef) {
+    EC_KEY* key = EC_KEY_new_by_curve_name(nid_);
+    if (key == nullptr || !EC_KEY_generate_key(key)) {
+      if (key != nullptr)
+        EC_KEY_free(key);
+      EVP_PKEY_free(pkey);
+      return nullptr;
+    }
+    EVP_PKEY_assign_EC_KEY(pkey, key);
+    return pkey;
+  }
+
+  const modp_group* it = modp_groups + group_;
+  DH* dh = DH_new();
+  if (dh == nullptr) {
+    EVP_PKEY_free(pkey);
+    return nullptr;
+  }
+  dh->p = BN_bin2bn(reinterpret_cast<const unsigned char*>(it->prime),
+                    it->prime_size,
+                    nullptr);
+  dh->g = BN_bin2bn(reinterpret_cast<const unsigned char*>(it->gen),
+                    it->gen_size,
+                    nullptr);
+  if (dh->p == nullptr || dh->g == nullptr || !DH_generate_key(dh)) {
+    DH_free(dh);
+    EVP_PKEY_free(pkey);
+    return nullptr;
+  }
+  EVP_PKEY_assign_DH(pkey, dh);
+  return pkey;
+}
+
+
+void KeyPool::Add(EVP_PKEY* pkey) {
+  if (pkey == nullptr)
+    return;
+  if (count_ < size_)
+    keys_[count_++] = pkey;
+  else
+    EVP_PKEY_free(pkey);
+}
+
+
+void KeyPool::Resize(unsigned int size) {
+  CHECK_LE(size, kMaxSize);
+  size_ = size;
+  while (count_ > size_)
+    EVP_PKEY_free(keys_[--count_]);
+}
+
+
+void KeyPool::Refill(Environment* env) {
+  for (unsigned int n = missing(); n > 0; n--) {
+    RefillRequest* req = new RefillRequest;
+    req->pool = this;
+    req->pkey = nullptr;
+    pending_++;
+    uv_queue_work(env->event_loop(), &req->work_req, RefillWork, RefillAfter);
+  }
+}
+
+
+void KeyPool::RefillWork(uv_work_t* work_req) {
+  RefillRequest* req = ContainerOf(&RefillRequest::work_req, work_req);
+  req->pkey = req->pool->Generate();
+  ERR_clear_error();
+}
+
+
+// A key that couldn't be generated is not retried until the next one is
+// taken out of the pool.
+void KeyPool::RefillAfter(uv_work_t* work_req, int status) {
+  RefillRequest* req = ContainerOf(&RefillRequest::work_req, work_req);
+  req->pool->pending_--;
+  req->pool->Add(req->pkey);
+  delete req;
+}
+
+
+// crypto.warmKeyPool() with a callback: generates the keys that are
+// missing from the pool, one after the other on a single threadpool thread.
+class KeyPoolWarmJob : public CryptoJob {
+ public:
+  KeyPoolWarmJob(Environment* env,
+                 Local<Object> object,
+                 KeyPool* pool,
+                 unsigned int count)
+      : CryptoJob(env, object, "Key generation failed"),
+        pool_(pool),
+        keys_(new EVP_PKEY*[count]()),
+        count_(count) {
+    pool_->AddPending(count_);
+  }
+
+  ~KeyPoolWarmJob() override {
+    pool_->RemovePending(count_);
+    for (unsigned int i = 0; i < count_; i++)
+      pool_->Add(keys_[i]);
+    delete[] keys_;
+  }
+
+  size_t self_size() const override {
+    return sizeof(*this) + count_ * sizeof(*keys_);
+  }
+
+ protected:
+  bool DoWork() override {
+    for (unsigned int i = 0; i < count_; i++) {
+      keys_[i] = pool_->Generate();
+      if (keys_[i] == nullptr)
+        return false;
+    }
+    return true;
+  }
+
+  // Adds the keys before the callback runs.
+  Local<Value> Result() override {
+    pool_->RemovePending(count_);
+    for (unsigned int i = 0; i < count_; i++)
+      pool_->Add(keys_[i]);
+    count_ = 0;
+    return Undefined(env()->isolate());
+  }
+
+ private:
+  KeyPool* const pool_;
+  EVP_PKEY** const keys_;
+  unsigned int count_;
+};
+
+
+// warmKeyPool(name, size[, callback])
+void WarmKeyPool(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+
+  CHECK(args[0]->IsString());
+
+  const node::Utf8Value name(env->isolate(), args[0]);
+  KeyPool* pool = KeyPool::Get(*name);
+  if (pool == nullptr)
+    return env->ThrowError("Unknown curve or group");
+
+  if (!args[1]->IsUint32() || args[1]->Uint32Value() > KeyPool::kMaxSize)
+    return env->ThrowRangeError("Key pool size is too large");
+  const uint32_t size = args[1]->Uint32Value();
+  pool->Resize(size);
+
+  if (!args[2]->IsFunction())
+    return pool->Refill(env);
+
+  Local<Object> obj = CryptoJob::NewObject(env, args[2]);
+  KeyPoolWarmJob* job = new KeyPoolWarmJob(env, obj, pool, pool->missing());
+  job->Queue();
+}
+
+
+// DiffieHellman#generateParameters(): DH_generate_parameters_ex() and the
+// DH_check() DiffieHellman::VerifyContext() does.  `object.handle` keeps
+// the DiffieHellman alive.
+class DHParametersJob : public CryptoJob {
+ public:
+  DHParametersJob(Environment* env,
+                  Local<Object> object,
+                  DiffieHellman* target,
+                  int prime_length,
+                  int generator)
+      : CryptoJob(env, object, "Initialization failed"),
+        target_(target),
+        prime_length_(prime_length),
+        generator_(generator),
+        dh_(DH_new()),
+        verify_error_(0) {
+  }
+
+  ~DHParametersJob() override {
+    if (dh_ != nullptr)
+      DH_free(dh_);
+  }
+
+  size_t self_size() const override { return sizeof(*this); }
+
+ protected:
+  bool DoWork() override {
+    return dh_ != nullptr &&
+           DH_generate_parameters_ex(dh_,
+                                     prime_length_,
+                                     generator_,
+                                     nullptr) &&
+           DH_check(dh_, &verify_error_);
+  }
+
+  Local<Value> Result() override {
+    if (target_->dh != nullptr)
+      DH_free(target_->dh);
+    target_->dh = dh_;
+    target_->verifyError_ = verify_error_;
+    target_->initialised_ = true;
+    dh_ = nullptr;
+    return Undefined(env()->isolate());
+  }
+
+ private:
+  DiffieHellman* const target_;
+  const int prime_length_;
+  const int generator_;
+  DH* dh_;
+  int verify_error_;
+};
+
+
+// DiffieHellman#generateKeys() with a callback.  Works on a copy of the
+// parameters and private key; the new keys replace those of the
+// DiffieHellman object when done.
+class DHKeyJob : public CryptoJob {
+ public:
+  DHKeyJob(Environment* env, Local<Object> object, DiffieHellman* target)
+      : CryptoJob(env, object, "Key generation failed"),
+        target_(target),
+        dh_(DH_new()) {
+    if (dh_ == nullptr)
+      return;
+    dh_->p = BN_dup(target->dh->p);
+    dh_->g = BN_dup(target->dh->g);
+    if (target->dh->priv_key != nullptr)
+      dh_->priv_key = BN_dup(target->dh->priv_key);
+  }
+
+  ~DHKeyJob() override {
+    if (dh_ != nullptr)
+      DH_free(dh_);
+  }
+
+  size_t self_size() const override { return sizeof(*this); }
+
+ protected:
+  bool DoWork() override {
+    return dh_ != nullptr &&
+           dh_->p != nullptr &&
+           dh_->g != nullptr &&
+           DH_generate_key(dh_);
+  }
+
+  Local<Value> Result() override {
+    DH* dh = target_->dh;
+    if (dh->pub_key != nullptr)
+      BN_free(dh->pub_key);
+    if (dh->priv_key != nullptr)
+      BN_clear_free(dh->priv_key);
+    dh->pub_key = dh_->pub_key;
+    dh->priv_key = dh_->priv_key;
+    dh_->pub_key = nullptr;
+    dh_->priv_key = nullptr;
+
+    const int size = BN_num_bytes(dh->pub_key);
+    char* data = new char[size];
+    BN_bn2bin(dh->pub_key, reinterpret_cast<unsigned char*>(data));
+    Local<Value> result = Encode(env()->isolate(), data, size, BUFFER);
+    delete[] data;
+    return result;
+  }
+
+ private:
+  DiffieHellman* const target_;
+  DH* dh_;
+};
+
+
+// ECDH#generateKeys() with a callback.  The new key replaces the one of the
+// ECDH object when done.
+class ECKeyJob : public CryptoJob {
+ public:
+  ECKeyJob(Environment* env, Local<Object> object, ECDH* target)
+      : CryptoJob(env, object, "Failed to generate EC_KEY"),
+        target_(target),
+        key_(EC_KEY_new()) {
+    if (key_ != nullptr && !EC_KEY_set_group(key_, target->group_)) {
+      EC_KEY_free(key_);
+      key_ = nullptr;
+    }
+  }
+
+  ~ECKeyJob() override {
+    if (key_ != nullptr)
+      EC_KEY_free(key_);
+  }
+
+  size_t self_size() const override { return sizeof(*this); }
+
+ protected:
+  bool DoWork() override {
+    return key_ != nullptr && EC_KEY_generate_key(key_);
+  }
+
+  Local<Value> Result() override {
+    target_->SetKey(key_);
+    key_ = nullptr;
+    return Undefined(env()->isolate());
+  }
+
+ private:
+  ECDH* const target_;
+  EC_KEY* key_;
+};
+
+
 void DiffieHellman::Initialize(Environment* env, Handle<Object> target) {
   Local<FunctionTemplate> t = env->NewFunctionTemplate(New);
 
@@ -3809,6 +4955,7 @@ void DiffieHellman::Initialize(Environment* env, Handle<Object> target) {
   env->SetProtoMethod(t, "getPrivateKey", GetPrivateKey);
   env->SetProtoMethod(t, "setPublicKey", SetPublicKey);
   env->SetProtoMethod(t, "setPrivateKey", SetPrivateKey);
+  env->SetProtoMethod(t, "generateParameters", GenerateParameters);
 
   t->InstanceTemplate()->SetAccessor(env->verify_error_string(),
                                      DiffieHellman::VerifyErrorGetter,
@@ -3902,7 +5049,8 @@ void DiffieHellman::DiffieHellmanGroup(
                                       it->gen,
                                       it->gen_size);
     if (!initialized)
-      env->ThrowError("Initialization failed");
+      return env->ThrowError("Initialization failed");
+    diffieHellman->group_ = i;
     return;
   }
 
@@ -3916,6 +5064,10 @@ void DiffieHellman::New(const FunctionCallbackInfo<Value>& args) {
       new DiffieHellman(env, args.This());
   bool initialized = false;
 
+  // Initialized later by generateParameters().
+  if (args.Length() == 0)
+    return;
+
   if (args.Length() == 2) {
     if (args[0]->IsInt32()) {
       if (args[1]->IsInt32()) {
@@ -3951,8 +5103,19 @@ void DiffieHellman::GenerateKeys(const FunctionCallbackInfo<Value>& args) {
     return env->ThrowError("Not initialized");
   }
 
-  if (!DH_generate_key(diffieHellman->dh)) {
-    return env->ThrowError("Key generation failed");
+  // generateKeys(callback) returns the public key if a pooled key could be
+  // used right away, the callback is not called then.
+  if (!diffieHellman->TakePooledKey()) {
+    if (args[0]->IsFunction()) {
+      Local<Object> obj = CryptoJob::NewObject(env, args[0]);
+      obj->Set(env->handle_string(), args.Holder());
+      DHKeyJob* job = new DHKeyJob(env, obj, diffieHellman);
+      return job->Queue();
+    }
+
+    if (!DH_generate_key(diffieHellman->dh)) {
+      return env->ThrowError("Key generation failed");
+    }
   }
 
   int dataSize = BN_num_bytes(diffieHellman->dh->pub_key);
@@ -3965,6 +5128,49 @@ void DiffieHellman::GenerateKeys(const FunctionCallbackInfo<Value>& args) {
 }
 
 
+// DiffieHellmanGroup objects that don't have a private key yet take their
+// keys from the pool of their group, if there is one.
+bool DiffieHellman::TakePooledKey() {
+  if (group_ == -1 || dh->priv_key != nullptr)
+    return false;
+
+  EVP_PKEY* pkey = KeyPool::Take(env(), NID_undef, group_);
+  if (pkey == nullptr)
+    return false;
+
+  DH* pooled = EVP_PKEY_get1_DH(pkey);
+  if (dh->pub_key != nullptr)
+    BN_free(dh->pub_key);
+  dh->pub_key = BN_dup(pooled->pub_key);
+  dh->priv_key = BN_dup(pooled->priv_key);
+  DH_free(pooled);
+  EVP_PKEY_free(pkey);
+  return dh->pub_key != nullptr && dh->priv_key != nullptr;
+}
+
+
+// generateParameters(primeLength, generator, callback)
+void DiffieHellman::GenerateParameters(
+    const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+
+  DiffieHellman* diffieHellman = Unwrap<DiffieHellman>(args.Holder());
+  CHECK(!diffieHellman->initialised_);
+  CHECK(args[0]->IsInt32());
+  CHECK(args[1]->IsInt32());
+  CHECK(args[2]->IsFunction());
+
+  Local<Object> obj = CryptoJob::NewObject(env, args[2]);
+  obj->Set(env->handle_string(), args.Holder());
+  DHParametersJob* job = new DHParametersJob(env,
+                                             obj,
+                                             diffieHellman,
+                                             args[0]->Int32Value(),
+                                             args[1]->Int32Value());
+  job->Queue();
+}
+
+
 void DiffieHellman::GetPrime(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
 
@@ -4222,6 +5428,23 @@ void ECDH::GenerateKeys(const FunctionCallbackInfo<Value>& args) {
 
   ECDH* ecdh = Unwrap<ECDH>(args.Holder());
 
+  // generateKeys(callback) returns true if a pooled key could be used right
+  // away, the callback is not called then.
+  EVP_PKEY* pkey =
+      KeyPool::Take(env, EC_GROUP_get_curve_name(ecdh->group_), -1);
+  if (pkey != nullptr) {
+    ecdh->SetKey(EVP_PKEY_get1_EC_KEY(pkey));
+    EVP_PKEY_free(pkey);
+    return args.GetReturnValue().Set(true);
+  }
+
+  if (args[0]->IsFunction()) {
+    Local<Object> obj = CryptoJob::NewObject(env, args[0]);
+    obj->Set(env->handle_string(), args.Holder());
+    ECKeyJob* job = new ECKeyJob(env, obj, ecdh);
+    return job->Queue();
+  }
+
   if (!EC_KEY_generate_key(ecdh->key_))
     return env->ThrowError("Failed to generate EC_KEY");
 
@@ -4229,6 +5452,14 @@ void ECDH::GenerateKeys(const FunctionCallbackInfo<Value>& args) {
 }
 
 
+void ECDH::SetKey(EC_KEY* key) {
+  EC_KEY_free(key_);
+  key_ = key;
+  group_ = EC_KEY_get0_group(key_);
+  generated_ = true;
+}
+
+
 EC_POINT* ECDH::BufferToPoint(char* data, size_t len) {
   EC_POINT* pub;
   int r;
@@ -4390,8 +5621,246 @@ void ECDH::SetPublicKey(const FunctionCallbackInfo<Value>& args) {
 }
 
 
+// A thread pool of its own for CPU-bound crypto work, so that a burst of
+// long running jobs doesn't hold up the file system and DNS requests that go
+// through libuv's threadpool.  It is enabled by setting
+// NODE_CRYPTO_THREADPOOL_SIZE, jobs go to libuv's threadpool otherwise.  The
+// threads are started on first use and live as long as the process.
+//
+// Queue() takes the same arguments as uv_queue_work() and is only called from
+// the main thread, which is also where the after_work_cb callbacks run.
+class CryptoThreadPool {
+ public:
+  static const unsigned kMaxSize = 128;
+
+  // Returns the number of threads, 0 if the pool is disabled.
+  static unsigned size();
+
+  static void Queue(uv_loop_t* loop,
+                    uv_work_t* req,
+                    uv_work_cb work_cb,
+                    uv_after_work_cb after_work_cb);
+
+ private:
+  struct Task {
+    uv_work_t* req;
+    uv_work_cb work_cb;
+    uv_after_work_cb after_work_cb;
+    Task* next;
+  };
+
+  struct TaskList {
+    Task* head;
+    Task* tail;
+
+    void Push(Task* task) {
+      task->next = nullptr;
+      if (tail == nullptr)
+        head = task;
+      else
+        tail->next = task;
+      tail = task;
+    }
+  };
+
+  static void Start(uv_loop_t* loop);
+  static void Run(void* arg);
+  static void OnDone(uv_async_t* handle);
+
+  static uv_mutex_t mutex_;
+  static uv_cond_t cond_;
+  // Guarded by mutex_.
+  static TaskList queued_;
+  static TaskList done_;
+  // Main thread only.
+  static uv_async_t async_;
+  static bool started_;
+  static unsigned pending_;
+};
+
+uv_mutex_t CryptoThreadPool::mutex_;
+uv_cond_t CryptoThreadPool::cond_;
+CryptoThreadPool::TaskList CryptoThreadPool::queued_;
+CryptoThreadPool::TaskList CryptoThreadPool::done_;
+uv_async_t CryptoThreadPool::async_;
+bool CryptoThreadPool::started_;
+unsigned CryptoThreadPool::pending_;
+
+
+unsigned CryptoThreadPool::size() {
+  static int size = -1;
+  if (size == -1) {
+    const char* val = getenv("NODE_CRYPTO_THREADPOOL_SIZE");
+    size = val != nullptr ? atoi(val) : 0;
+    if (size < 0)
+      size = 0;
+    if (size > static_cast<int>(kMaxSize))
+      size = kMaxSize;
+  }
+  return size;
+}
+
+
+void CryptoThreadPool::Start(uv_loop_t* loop) {
+  CHECK_EQ(0, uv_mutex_init(&mutex_));
+  CHECK_EQ(0, uv_cond_init(&cond_));
+  CHECK_EQ(0, uv_async_init(loop, &async_, OnDone));
+  uv_unref(reinterpret_cast<uv_handle_t*>(&async_));
+  for (unsigned i = 0; i < size(); i++) {
+    uv_thread_t thread;
+    CHECK_EQ(0, uv_thread_create(&thread, Run, nullptr));
+  }
+  started_ = true;
+}
+
+
+void CryptoThreadPool::Queue(uv_loop_t* loop,
+                             uv_work_t* req,
+                             uv_work_cb work_cb,
+                             uv_after_work_cb after_work_cb) {
+  if (size() == 0) {
+    CHECK_EQ(0, uv_queue_work(loop, req, work_cb, after_work_cb));
+    return;
+  }
+
+  if (!started_)
+    Start(loop);
+  // The completion handle belongs to the first loop.
+  CHECK_EQ(async_.loop, loop);
+
+  req->loop = loop;
+  Task* task = new Task;
+  task->req = req;
+  task->work_cb = work_cb;
+  task->after_work_cb = after_work_cb;
+
+  // Keeps the loop alive like a uv_work_t does.
+  if (pending_++ == 0)
+    uv_ref(reinterpret_cast<uv_handle_t*>(&async_));
+
+  uv_mutex_lock(&mutex_);
+  queued_.Push(task);
+  uv_cond_signal(&cond_);
+  uv_mutex_unlock(&mutex_);
+}
+
+
+void CryptoThreadPool::Run(void* arg) {
+  uv_mutex_lock(&mutex_);
+  for (;;) {
+    while (queued_.head == nullptr)
+      uv_cond_wait(&cond_, &mutex_);
+    Task* task = queued_.head;
+    queued_.head = task->next;
+    if (queued_.head == nullptr)
+      queued_.tail = nullptr;
+    uv_mutex_unlock(&mutex_);
+
+    task->work_cb(task->req);
+
+    uv_mutex_lock(&mutex_);
+    done_.Push(task);
+    uv_async_send(&async_);
+  }
+}
+
+
+void CryptoThreadPool::OnDone(uv_async_t* handle) {
+  uv_mutex_lock(&mutex_);
+  Task* task = done_.head;
+  done_.head = done_.tail = nullptr;
+  uv_mutex_unlock(&mutex_);
+
+  while (task != nullptr) {
+    Task* next = task->next;
+    task->after_work_cb(task->req, 0);
+    delete task;
+    task = next;
+    if (--pending_ == 0)
+      uv_unref(reinterpret_cast<uv_handle_t*>(&async_));
+  }
+}
+
+
+// Derives T_index, block `index` (counting from 1) of the PBKDF2 output as
+// RFC 2898 calls it.  The blocks don't depend on each other, which is what
+// lets the blocks of a long key be derived in parallel.  Same steps and same
+// output as PKCS5_PBKDF2_HMAC(), which always does all blocks in order.
+static bool PBKDF2Block(const EVP_MD* digest,
+                        const char* pass,
+                        size_t passlen,
+                        const unsigned char* salt,
+                        size_t saltlen,
+                        int iter,
+                        uint32_t index,
+                        unsigned char* out,
+                        size_t outlen) {
+  static const char empty[] = "";
+  const size_t mdlen = EVP_MD_size(digest);
+  unsigned char digtmp[EVP_MAX_MD_SIZE];
+  unsigned char itmp[4];
+  HMAC_CTX hctx_tpl;
+  HMAC_CTX hctx;
+  bool ok = false;
+
+  CHECK_LE(outlen, mdlen);
+
+  // HMAC_Init_ex() takes a null key to mean "keep the last one".
+  if (pass == nullptr) {
+    pass = empty;
+    passlen = 0;
+  }
+
+  itmp[0] = static_cast<unsigned char>(index >> 24);
+  itmp[1] = static_cast<unsigned char>(index >> 16);
+  itmp[2] = static_cast<unsigned char>(index >> 8);
+  itmp[3] = static_cast<unsigned char>(index);
+
+  HMAC_CTX_init(&hctx_tpl);
+  HMAC_CTX_init(&hctx);
+  if (!HMAC_Init_ex(&hctx_tpl, pass, passlen, digest, nullptr))
+    goto done;
+
+  if (!HMAC_CTX_copy(&hctx, &hctx_tpl) ||
+      !HMAC_Update(&hctx, salt, saltlen) ||
+      !HMAC_Update(&hctx, itmp, sizeof(itmp)) ||
+      !HMAC_Final(&hctx, digtmp, nullptr)) {
+    goto done;
+  }
+  memcpy(out, digtmp, outlen);
+
+  for (int i = 1; i < iter; i++) {
+    HMAC_CTX_cleanup(&hctx);
+    if (!HMAC_CTX_copy(&hctx, &hctx_tpl) ||
+        !HMAC_Update(&hctx, digtmp, mdlen) ||
+        !HMAC_Final(&hctx, digtmp, nullptr)) {
+      goto done;
+    }
+    for (size_t k = 0; k < outlen; k++)
+      out[k] ^= digtmp[k];
+  }
+  ok = true;
+
+ done:
+  HMAC_CTX_cleanup(&hctx);
+  HMAC_CTX_cleanup(&hctx_tpl);
+  OPENSSL_cleanse(digtmp, sizeof(digtmp));
+  return ok;
+}
+
+
+// Runs of consecutive key blocks are derived on different threads, see
+// PBKDF2Request::Split().
 class PBKDF2Request : public AsyncWrap {
  public:
+  struct Piece {
+    uv_work_t work_req;
+    PBKDF2Request* req;
+    uint32_t first_block;
+    uint32_t end_block;
+    bool ok;
+  };
+
   PBKDF2Request(Environment* env,
                 Local<Object> object,
                 const EVP_MD* digest,
@@ -4410,17 +5879,22 @@ class PBKDF2Request : public AsyncWrap {
         salt_(salt),
         keylen_(keylen),
         key_(static_cast<char*>(malloc(keylen))),
-        iter_(iter) {
+        iter_(iter),
+        pieces_(nullptr),
+        piece_count_(0),
+        pending_(0) {
     if (key() == nullptr)
       FatalError("node::PBKDF2Request()", "Out of Memory");
   }
 
   ~PBKDF2Request() override {
+    delete[] pieces_;
     persistent().Reset();
   }
 
-  uv_work_t* work_req() {
-    return &work_req_;
+  size_t self_size() const override {
+    return sizeof(*this) + passlen_ + saltlen_ + keylen_ +
+           piece_count_ * sizeof(*pieces_);
   }
 
   inline const EVP_MD* digest() const {
@@ -4472,7 +5946,26 @@ class PBKDF2Request : public AsyncWrap {
     error_ = err;
   }
 
-  uv_work_t work_req_;
+  inline Piece* pieces() const {
+    return pieces_;
+  }
+
+  inline unsigned piece_count() const {
+    return piece_count_;
+  }
+
+  // Divides the key blocks into up to `count` runs of about the same length.
+  void Split(unsigned count);
+
+  // Derives the blocks of one piece.
+  void Derive(Piece* piece);
+
+  // Called on the main thread for each piece, returns true for the last one.
+  inline bool Finish(Piece* piece) {
+    if (!piece->ok)
+      set_error(0);
+    return --pending_ == 0;
+  }
 
  private:
   const EVP_MD* digest_;
@@ -4484,31 +5977,100 @@ class PBKDF2Request : public AsyncWrap {
   ssize_t keylen_;
   char* key_;
   ssize_t iter_;
+  Piece* pieces_;
+  unsigned piece_count_;
+  unsigned pending_;
 };
 
 
+void PBKDF2Request::Split(unsigned count) {
+  const size_t mdlen = EVP_MD_size(digest());
+  const uint32_t blocks = (keylen() + mdlen - 1) / mdlen;
+  if (count > blocks)
+    count = blocks;
+  if (count == 0)
+    count = 1;
+
+  pieces_ = new Piece[count];
+  piece_count_ = count;
+  pending_ = count;
+  // set_error() takes the OpenSSL convention, 1 means success.
+  set_error(1);
+
+  uint32_t first = 1;
+  for (unsigned i = 0; i < count; i++) {
+    const uint32_t length = blocks / count + (i < blocks % count ? 1 : 0);
+    pieces_[i].req = this;
+    pieces_[i].first_block = first;
+    pieces_[i].end_block = first + length;
+    pieces_[i].ok = false;
+    first += length;
+  }
+}
+
+
+void PBKDF2Request::Derive(Piece* piece) {
+  const size_t mdlen = EVP_MD_size(digest());
+  piece->ok = true;
+  for (uint32_t i = piece->first_block; i < piece->end_block; i++) {
+    const size_t offset = (i - 1) * mdlen;
+    const size_t remaining = keylen() - offset;
+    const size_t length = remaining < mdlen ? remaining : mdlen;
+    if (!PBKDF2Block(digest(),
+                     pass(),
+                     passlen(),
+                     reinterpret_cast<unsigned char*>(salt()),
+                     saltlen(),
+                     iter(),
+                     i,
+                     reinterpret_cast<unsigned char*>(key()) + offset,
+                     length)) {
+      piece->ok = false;
+      break;
+    }
+  }
+}
+
+
+// The number of pieces a request is split into.  Requests on libuv's
+// threadpool leave one of its threads to other work.
+static unsigned PBKDF2Parallelism() {
+  const unsigned dedicated = CryptoThreadPool::size();
+  if (dedicated > 0)
+    return dedicated;
+
+  // Same parsing as libuv.
+  unsigned size = 4;
+  const char* val = getenv("UV_THREADPOOL_SIZE");
+  if (val != nullptr)
+    size = atoi(val);
+  if (size == 0)
+    size = 1;
+  if (size > 128)
+    size = 128;
+  return size > 1 ? size - 1 : 1;
+}
+
+
 void EIO_PBKDF2(PBKDF2Request* req) {
-  req->set_error(PKCS5_PBKDF2_HMAC(
-    req->pass(),
-    req->passlen(),
-    reinterpret_cast<unsigned char*>(req->salt()),
-    req->saltlen(),
-    req->iter(),
-    req->digest(),
-    req->keylen(),
-    reinterpret_cast<unsigned char*>(req->key())));
-  memset(req->pass(), 0, req->passlen());
-  memset(req->salt(), 0, req->saltlen());
+  for (unsigned i = 0; i < req->piece_count(); i++) {
+    PBKDF2Request::Piece* piece = &req->pieces()[i];
+    req->Derive(piece);
+    req->Finish(piece);
+  }
 }
 
 
 void EIO_PBKDF2(uv_work_t* work_req) {
-  PBKDF2Request* req = ContainerOf(&PBKDF2Request::work_req_, work_req);
-  EIO_PBKDF2(req);
+  PBKDF2Request::Piece* piece =
+      ContainerOf(&PBKDF2Request::Piece::work_req, work_req);
+  piece->req->Derive(piece);
 }
 
 
 void EIO_PBKDF2After(PBKDF2Request* req, Local<Value> argv[2]) {
+  memset(req->pass(), 0, req->passlen());
+  memset(req->salt(), 0, req->saltlen());
   if (req->error()) {
     argv[0] = Undefined(req->env()->isolate());
     argv[1] = Encode(req->env()->isolate(), req->key(), req->keylen(), BUFFER);
@@ -4522,7 +6084,11 @@ void EIO_PBKDF2After(PBKDF2Request* req, Local<Value> argv[2]) {
 
 void EIO_PBKDF2After(uv_work_t* work_req, int status) {
   CHECK_EQ(status, 0);
-  PBKDF2Request* req = ContainerOf(&PBKDF2Request::work_req_, work_req);
+  PBKDF2Request::Piece* piece =
+      ContainerOf(&PBKDF2Request::Piece::work_req, work_req);
+  PBKDF2Request* req = piece->req;
+  if (!req->Finish(piece))
+    return;
   Environment* env = req->env();
   HandleScope handle_scope(env->isolate());
   Context::Scope context_scope(env->context());
@@ -4631,13 +6197,17 @@ void PBKDF2(const FunctionCallbackInfo<Value>& args) {
     // XXX(trevnorris): This will need to go with the rest of domains.
     if (env->in_domain())
       obj->Set(env->domain_string(), env->domain_array()->Get(0));
-    uv_queue_work(env->event_loop(),
-                  req->work_req(),
-                  EIO_PBKDF2,
-                  EIO_PBKDF2After);
+    req->Split(PBKDF2Parallelism());
+    for (unsigned i = 0; i < req->piece_count(); i++) {
+      CryptoThreadPool::Queue(env->event_loop(),
+                              &req->pieces()[i].work_req,
+                              EIO_PBKDF2,
+                              EIO_PBKDF2After);
+    }
   } else {
     env->PrintSyncTrace();
     Local<Value> argv[2];
+    req->Split(1);
     EIO_PBKDF2(req);
     EIO_PBKDF2After(req, argv);
     if (argv[0]->IsObject())
@@ -4670,6 +6240,8 @@ class RandomBytesRequest : public AsyncWrap {
     persistent().Reset();
   }
 
+  size_t self_size() const override { return sizeof(*this) + size_; }
+
   uv_work_t* work_req() {
     return &work_req_;
   }
@@ -4779,6 +6351,17 @@ void RandomBytes(const FunctionCallbackInfo<Value>& args) {
     return env->ThrowTypeError("size > Buffer::kMaxLength");
   }
 
+  // Small requests are served from the pool without blocking, also when
+  // there is a callback; lib/crypto.js defers the callback then.
+  if (size <= Environment::RandomPool::kMaxRequestSize) {
+    char data[Environment::RandomPool::kMaxRequestSize];
+    if (env->random_pool()->Take(env, data, size)) {
+      args.GetReturnValue().Set(Buffer::New(env, data, size));
+      OPENSSL_cleanse(data, size);
+      return;
+    }
+  }
+
   Local<Object> obj = Object::New(env->isolate());
   RandomBytesRequest* req = new RandomBytesRequest(env, obj, size);
 
@@ -5086,6 +6669,12 @@ void InitCryptoOnce() {
   ERR_load_ENGINE_strings();
   ENGINE_load_builtin_engines();
 #endif  // !OPENSSL_NO_ENGINE
+
+#ifdef NODE__HAVE_TLSEXT_STATUS_CB
+  ocsp_staple_index =
+      SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, FreeOCSPStaple);
+  CHECK_NE(ocsp_staple_index, -1);
+#endif  // NODE__HAVE_TLSEXT_STATUS_CB
 }
 
 
@@ -5157,6 +6746,7 @@ void InitCrypto(Handle<Object> target,
 #endif  // !OPENSSL_NO_ENGINE
   env->SetMethod(target, "PBKDF2", PBKDF2);
   env->SetMethod(target, "randomBytes", RandomBytes);
+  env->SetMethod(target, "warmKeyPool", WarmKeyPool);
   env->SetMethod(target, "getSSLCiphers", GetSSLCiphers);
   env->SetMethod(target, "getCiphers", GetCiphers);
   env->SetMethod(target, "getHashes", GetHashes);
@@ -31,6 +31,7 @@
 #include <openssl/hmac.h>
 #include <openssl/rand.h>
 #include <openssl/pkcs12.h>
+#include <openssl/ocsp.h>
 
 #define EVP_F_EVP_DECRYPTFINAL 101
 
@@ -73,6 +74,8 @@ class SecureContext : public BaseObject {
   static void AddCACert(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void AddCRL(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void AddRootCerts(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void InitFromCache(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void AddToCache(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void SetCiphers(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void SetECDHCurve(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void SetDHParam(const v8::FunctionCallbackInfo<v8::Value>& args);
@@ -87,6 +90,10 @@ class SecureContext : public BaseObject {
   static void SetTicketKeys(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void SetFreeListLength(
       const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void SetOCSPStaple(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void ClearOCSPStaple(
+      const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void GetOCSPRequest(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void CtxGetter(v8::Local<v8::String> property,
                         const v8::PropertyCallbackInfo<v8::Value>& info);
 
@@ -106,13 +113,8 @@ class SecureContext : public BaseObject {
   void FreeCTXMem() {
     if (ctx_) {
       env()->isolate()->AdjustAmountOfExternalAllocatedMemory(-kExternalSize);
-      if (ctx_->cert_store == root_cert_store) {
-        // SSL_CTX_free() will attempt to free the cert_store as well.
-        // Since we want our root_cert_store to stay around forever
-        // we just clear the field. Hopefully OpenSSL will not modify this
-        // struct in future versions.
-        ctx_->cert_store = nullptr;
-      }
+      // The SSL_CTX may be shared with other contexts through the cache,
+      // this only drops our reference.
       SSL_CTX_free(ctx_);
       if (cert_ != nullptr)
         X509_free(cert_);
@@ -281,7 +283,7 @@ class SSLWrap {
 // Connection inherits from AsyncWrap because SSLWrap makes calls to
 // MakeCallback, but SSLWrap doesn't store the handle itself. Instead it
 // assumes that any args.This() called will be the handle from Connection.
-class Connection : public SSLWrap<Connection>, public AsyncWrap {
+class Connection : public AsyncWrap, public SSLWrap<Connection> {
  public:
   ~Connection() override {
 #ifdef SSL_CTRL_SET_TLSEXT_SERVERNAME_CB
@@ -293,6 +295,8 @@ class Connection : public SSLWrap<Connection>, public AsyncWrap {
   static void Initialize(Environment* env, v8::Handle<v8::Object> target);
   void NewSessionDoneCb();
 
+  size_t self_size() const override;
+
 #ifdef OPENSSL_NPN_NEGOTIATED
   v8::Persistent<v8::Object> npnProtos_;
   v8::Persistent<v8::Value> selectedNPNProto_;
@@ -344,8 +348,8 @@ class Connection : public SSLWrap<Connection>, public AsyncWrap {
              v8::Local<v8::Object> wrap,
              SecureContext* sc,
              SSLWrap<Connection>::Kind kind)
-      : SSLWrap<Connection>(env, sc, kind),
-        AsyncWrap(env, wrap, AsyncWrap::PROVIDER_CRYPTO),
+      : AsyncWrap(env, wrap, AsyncWrap::PROVIDER_CRYPTO),
+        SSLWrap<Connection>(env, sc, kind),
         bio_read_(nullptr),
         bio_write_(nullptr),
         hello_offset_(0) {
@@ -497,6 +501,15 @@ class Hash : public BaseObject {
   bool initialised_;
 };
 
+// How Sign#sign(), Verify#verify() and the public key ciphers read a key:
+// as a private key, as a public key or certificate, or as a public key,
+// certificate or private key.
+enum PKeyKind {
+  kPKeyPrivate,
+  kPKeyPublicOrCert,
+  kPKeyPublicOrPrivate
+};
+
 class SignBase : public BaseObject {
  public:
   typedef enum {
@@ -588,12 +601,9 @@ class PublicKeyCipher {
     kPrivate
   };
 
-  template <Operation operation,
-            EVP_PKEY_cipher_init_t EVP_PKEY_cipher_init,
+  template <EVP_PKEY_cipher_init_t EVP_PKEY_cipher_init,
             EVP_PKEY_cipher_t EVP_PKEY_cipher>
-  static bool Cipher(const char* key_pem,
-                     int key_pem_len,
-                     const char* passphrase,
+  static bool Cipher(EVP_PKEY* pkey,
                      int padding,
                      const unsigned char* data,
                      int len,
@@ -632,6 +642,8 @@ class DiffieHellman : public BaseObject {
   static void ComputeSecret(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void SetPublicKey(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void SetPrivateKey(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void GenerateParameters(
+      const v8::FunctionCallbackInfo<v8::Value>& args);
   static void VerifyErrorGetter(
       v8::Local<v8::String> property,
       const v8::PropertyCallbackInfo<v8::Value>& args);
@@ -640,15 +652,22 @@ class DiffieHellman : public BaseObject {
       : BaseObject(env, wrap),
         initialised_(false),
         verifyError_(0),
+        group_(-1),
         dh(nullptr) {
     MakeWeak<DiffieHellman>(this);
   }
 
  private:
+  friend class DHParametersJob;
+  friend class DHKeyJob;
+
   bool VerifyContext();
+  bool TakePooledKey();
 
   bool initialised_;
   int verifyError_;
+  // Index into modp_groups for DiffieHellmanGroup objects, -1 otherwise.
+  int group_;
   DH* dh;
 };
 
@@ -682,6 +701,9 @@ class ECDH : public BaseObject {
   static void SetPublicKey(const v8::FunctionCallbackInfo<v8::Value>& args);
 
   EC_POINT* BufferToPoint(char* data, size_t len);
+  void SetKey(EC_KEY* key);
+
+  friend class ECKeyJob;
 
   bool generated_;
   EC_KEY* key_;
@@ -707,8 +729,13 @@ class Certificate : public AsyncWrap {
       : AsyncWrap(env, wrap, AsyncWrap::PROVIDER_CRYPTO) {
     MakeWeak<Certificate>(this);
   }
+
+  size_t self_size() const override { return sizeof(*this); }
 };
 
+void WarmKeyPool(const v8::FunctionCallbackInfo<v8::Value>& args);
+
+void CheckEntropy();
 bool EntropySource(unsigned char* buffer, size_t length);
 #ifndef OPENSSL_NO_ENGINE
 void SetEngine(const v8::FunctionCallbackInfo<v8::Value>& args);
@@ -436,6 +436,21 @@ void NodeBIO::Reset() {
 }
 
 
+size_t NodeBIO::AllocatedSize() const {
+  size_t size = sizeof(*this);
+  if (read_head_ == nullptr)
+    return size;
+
+  Buffer* current = read_head_;
+  do {
+    size += sizeof(*current) + current->len_;
+    current = current->next_;
+  } while (current != read_head_);
+
+  return size;
+}
+
+
 NodeBIO::~NodeBIO() {
   if (read_head_ == nullptr)
     return;
@@ -69,6 +69,9 @@ class NodeBIO {
     return length_;
   }
 
+  // Return size of all allocated buffers in bytes, used or not
+  size_t AllocatedSize() const;
+
   inline void set_initial(size_t initial) {
     initial_ = initial;
   }
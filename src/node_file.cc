@@ -3,7 +3,10 @@
 #include "node_buffer.h"
 #include "node_internals.h"
 #include "node_stat_watcher.h"
+#include "smalloc.h"
 
+#include "base-object.h"
+#include "base-object-inl.h"
 #include "env.h"
 #include "env-inl.h"
 #include "req-wrap.h"
@@ -11,6 +14,7 @@
 #include "string_bytes.h"
 #include "util.h"
 
+#include <ctype.h>
 #include <fcntl.h>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -22,6 +26,8 @@
 # include <io.h>
 #endif
 
+#include <map>
+#include <string>
 #include <vector>
 
 namespace node {
@@ -73,6 +79,8 @@ class FSReqWrap: public ReqWrap<uv_fs_t> {
   const char* syscall() const { return syscall_; }
   const char* data() const { return data_; }
 
+  size_t self_size() const override { return sizeof(*this); }
+
  private:
   FSReqWrap(Environment* env,
             Local<Object> req,
@@ -124,6 +132,63 @@ static void NewFSReqWrap(const FunctionCallbackInfo<Value>& args) {
 }
 
 
+// Stat fields in the order the fs.Stats constructor takes them.  The stat
+// family and directory walks hand them to JS as kStatFieldCount doubles
+// per file in this layout.
+#define FS_STAT_FIELDS(V)                                                     \
+  V(dev)                                                                      \
+  V(mode)                                                                     \
+  V(nlink)                                                                    \
+  V(uid)                                                                      \
+  V(gid)                                                                      \
+  V(rdev)                                                                     \
+  V(blksize)                                                                  \
+  V(ino)                                                                      \
+  V(size)                                                                     \
+  V(blocks)                                                                   \
+
+#define FS_STAT_TIME_FIELDS(V)                                                \
+  V(atim)                                                                     \
+  V(mtim)                                                                     \
+  V(ctim)                                                                     \
+  V(birthtim)                                                                 \
+
+enum StatField {
+#define V(name) kStat_##name,
+  FS_STAT_FIELDS(V)
+  FS_STAT_TIME_FIELDS(V)
+#undef V
+  kStatFieldCount
+};
+
+
+static void FillStatFields(double* fields, const uv_stat_t* s) {
+#define V(name) fields[kStat_##name] = static_cast<double>(s->st_##name);
+  FS_STAT_FIELDS(V)
+#undef V
+#define V(name)                                                               \
+  fields[kStat_##name] =                                                      \
+      (static_cast<double>(s->st_##name.tv_sec) * 1000) +                     \
+      (static_cast<double>(s->st_##name.tv_nsec / 1000000));
+  FS_STAT_TIME_FIELDS(V)
+#undef V
+}
+
+
+// Fills the Float64Array shared with lib/fs.js.  stat() and friends return
+// their result through it instead of allocating an fs.Stats object, JS
+// reads it back immediately.
+static void FillStatsArray(Environment* env, const uv_stat_t* s) {
+  Local<Object> fields_array = env->fs_stats_field_array();
+  CHECK_EQ(fields_array->GetIndexedPropertiesExternalArrayDataType(),
+           v8::kExternalFloat64Array);
+  CHECK_EQ(fields_array->GetIndexedPropertiesExternalArrayDataLength(),
+           kStatFieldCount);
+  void* fields = fields_array->GetIndexedPropertiesExternalArrayData();
+  FillStatFields(static_cast<double*>(fields), s);
+}
+
+
 static inline bool IsInt64(double x) {
   return x == static_cast<double>(static_cast<int64_t>(x));
 }
@@ -197,8 +262,9 @@ static void After(uv_fs_t *req) {
       case UV_FS_STAT:
       case UV_FS_LSTAT:
       case UV_FS_FSTAT:
-        argv[1] = BuildStatsObject(env,
-                                   static_cast<const uv_stat_t*>(req->ptr));
+        // The result goes through the shared stats array.
+        FillStatsArray(env, static_cast<const uv_stat_t*>(req->ptr));
+        argc = 1;
         break;
 
       case UV_FS_READLINK:
@@ -499,6 +565,533 @@ static void InternalModuleStat(const FunctionCallbackInfo<Value>& args) {
   args.GetReturnValue().Set(rc);
 }
 
+#ifdef _WIN32
+static const char kPathSeparator = '\\';
+static inline bool IsPathSeparator(char c) { return c == '/' || c == '\\'; }
+#else
+static const char kPathSeparator = '/';
+static inline bool IsPathSeparator(char c) { return c == '/'; }
+#endif
+
+
+// Appends |name| to the absolute, normalized path |dir| the way
+// path.resolve(dir, name) does: '.' and '..' are applied lexically and
+// repeated or trailing separators are dropped.  Returns false if |name|
+// is absolute or |dir| is a UNC path, the JS side deals with those.
+static bool ResolveRelative(const std::string& dir,
+                            const std::string& name,
+                            std::string* out) {
+  if (name.empty() || IsPathSeparator(name[0]))
+    return false;
+#ifdef _WIN32
+  if (name.size() > 1 && name[1] == ':')
+    return false;
+#endif
+
+#ifdef _WIN32
+  if (dir.size() > 1 && IsPathSeparator(dir[0]) && IsPathSeparator(dir[1]))
+    return false;  // UNC path.
+#endif
+
+  // Length of the root, "/" or "C:\".
+  size_t root = 0;
+  while (root < dir.size() && !IsPathSeparator(dir[root]))
+    root++;
+  if (root == dir.size())
+    return false;
+  root++;
+
+  std::string result(dir);
+  size_t pos = 0;
+  while (pos <= name.size()) {
+    size_t end = pos;
+    while (end < name.size() && !IsPathSeparator(name[end]))
+      end++;
+    const size_t len = end - pos;
+
+    if (len == 0 || (len == 1 && name[pos] == '.')) {
+      // Nothing to append.
+    } else if (len == 2 && name[pos] == '.' && name[pos + 1] == '.') {
+      size_t cut = result.size();
+      while (cut > root && !IsPathSeparator(result[cut - 1]))
+        cut--;
+      result.resize(cut > root ? cut - 1 : root);
+    } else {
+      if (result.size() > root)
+        result += kPathSeparator;
+      result.append(name, pos, len);
+    }
+
+    pos = end + 1;
+  }
+
+  *out = result;
+  return true;
+}
+
+
+enum PackageState {
+  kPackageNoMain,
+  kPackageMain,
+  kPackageUnsupported
+};
+
+
+// Minimal JSON scanner that extracts the top-level "main" string of a
+// package.json without building the object.  Anything it isn't sure
+// about, including documents JSON.parse() would reject, is reported as
+// kPackageUnsupported so that lib/module.js can take the slow path and
+// produce the usual error.
+class PackageMainScanner {
+ public:
+  PackageMainScanner(const char* data, size_t length)
+      : p_(data), end_(data + length) {}
+
+  PackageState Scan(std::string* main);
+
+ private:
+  static const int kMaxDepth = 64;
+
+  void SkipWhitespace() {
+    while (p_ < end_ &&
+           (*p_ == ' ' || *p_ == '\t' || *p_ == '\n' || *p_ == '\r')) {
+      p_++;
+    }
+  }
+
+  bool Consume(char c) {
+    SkipWhitespace();
+    if (p_ == end_ || *p_ != c)
+      return false;
+    p_++;
+    return true;
+  }
+
+  bool ScanString(std::string* out, bool* escaped);
+  bool ScanEscape();
+  bool ScanLiteral(const char* literal);
+  bool ScanDigits();
+  bool ScanNumber();
+  bool ScanValue(int depth);
+
+  const char* p_;
+  const char* const end_;
+};
+
+
+// Skips a string, copying its raw contents to |out|.  |escaped| is set if
+// it contains escape sequences, the raw contents are meaningless then.
+bool PackageMainScanner::ScanString(std::string* out, bool* escaped) {
+  if (!Consume('"'))
+    return false;
+  const char* start = p_;
+  *escaped = false;
+  while (p_ < end_ && *p_ != '"') {
+    const unsigned char c = static_cast<unsigned char>(*p_);
+    if (c < 0x20)
+      return false;
+    if (c == '\\') {
+      *escaped = true;
+      if (!ScanEscape())
+        return false;
+      continue;
+    }
+    p_++;
+  }
+  if (p_ == end_)
+    return false;
+  out->assign(start, p_ - start);
+  p_++;
+  return true;
+}
+
+
+// Skips the escape sequence at |p_|, backslash included.
+bool PackageMainScanner::ScanEscape() {
+  if (++p_ == end_)
+    return false;
+  switch (*p_++) {
+    case '"':
+    case '\\':
+    case '/':
+    case 'b':
+    case 'f':
+    case 'n':
+    case 'r':
+    case 't':
+      return true;
+    case 'u':
+      for (int i = 0; i < 4; i++, p_++) {
+        if (p_ == end_ || !isxdigit(static_cast<unsigned char>(*p_)))
+          return false;
+      }
+      return true;
+    default:
+      return false;
+  }
+}
+
+
+bool PackageMainScanner::ScanLiteral(const char* literal) {
+  const size_t length = strlen(literal);
+  if (static_cast<size_t>(end_ - p_) < length ||
+      memcmp(p_, literal, length) != 0) {
+    return false;
+  }
+  p_ += length;
+  return true;
+}
+
+
+// Skips one or more decimal digits.
+bool PackageMainScanner::ScanDigits() {
+  const char* start = p_;
+  while (p_ < end_ && *p_ >= '0' && *p_ <= '9')
+    p_++;
+  return p_ > start;
+}
+
+
+// Skips a number with the JSON grammar: an optional minus, an integer part
+// without leading zeros, then an optional fraction and exponent.
+bool PackageMainScanner::ScanNumber() {
+  if (p_ < end_ && *p_ == '-')
+    p_++;
+  if (p_ < end_ && *p_ == '0')
+    p_++;
+  else if (!ScanDigits())
+    return false;
+  if (p_ < end_ && *p_ == '.') {
+    p_++;
+    if (!ScanDigits())
+      return false;
+  }
+  if (p_ < end_ && (*p_ == 'e' || *p_ == 'E')) {
+    p_++;
+    if (p_ < end_ && (*p_ == '+' || *p_ == '-'))
+      p_++;
+    if (!ScanDigits())
+      return false;
+  }
+  return true;
+}
+
+
+bool PackageMainScanner::ScanValue(int depth) {
+  SkipWhitespace();
+  if (p_ == end_ || depth > kMaxDepth)
+    return false;
+
+  std::string ignored;
+  bool escaped;
+  switch (*p_) {
+    case '"':
+      return ScanString(&ignored, &escaped);
+    case 't':
+      return ScanLiteral("true");
+    case 'f':
+      return ScanLiteral("false");
+    case 'n':
+      return ScanLiteral("null");
+    case '{':
+      p_++;
+      if (Consume('}'))
+        return true;
+      do {
+        if (!ScanString(&ignored, &escaped) ||
+            !Consume(':') ||
+            !ScanValue(depth + 1)) {
+          return false;
+        }
+      } while (Consume(','));
+      return Consume('}');
+    case '[':
+      p_++;
+      if (Consume(']'))
+        return true;
+      do {
+        if (!ScanValue(depth + 1))
+          return false;
+      } while (Consume(','));
+      return Consume(']');
+    default:
+      return ScanNumber();
+  }
+}
+
+
+PackageState PackageMainScanner::Scan(std::string* main) {
+  PackageState state = kPackageNoMain;
+
+  if (!Consume('{'))
+    return kPackageUnsupported;
+
+  if (!Consume('}')) {
+    do {
+      std::string key;
+      bool escaped;
+      if (!ScanString(&key, &escaped) || escaped || !Consume(':'))
+        return kPackageUnsupported;
+
+      if (key != "main") {
+        if (!ScanValue(1))
+          return kPackageUnsupported;
+        continue;
+      }
+
+      // Like JSON.parse(), the last "main" wins.  Only plain strings are
+      // handled here.
+      SkipWhitespace();
+      if (p_ == end_ || *p_ != '"')
+        return kPackageUnsupported;
+      if (!ScanString(main, &escaped) || escaped)
+        return kPackageUnsupported;
+      state = main->empty() ? kPackageNoMain : kPackageMain;
+    } while (Consume(','));
+
+    if (!Consume('}'))
+      return kPackageUnsupported;
+  }
+
+  SkipWhitespace();
+  return p_ == end_ ? state : kPackageUnsupported;
+}
+
+
+// Performs the whole require() search for one request natively: stat()
+// for every candidate file, extension and index file, and reading `main`
+// from package.json files.  Every package.json that was found is cached for
+// the lifetime of the resolver, including the ones without `main`.  Like
+// readPackage() in lib/module.js, a directory without one is looked at
+// again next time, so a package.json created later is picked up.
+// lib/module.js owns one instance and replaces it to reset the cache.
+class ModuleResolver : public BaseObject {
+ public:
+  static void Initialize(Environment* env, Local<Object> target);
+
+ private:
+  enum Outcome { kNotFound, kFound, kFallback };
+
+  struct Package {
+    PackageState state;
+    std::string main;
+  };
+
+  ModuleResolver(Environment* env, Local<Object> object)
+      : BaseObject(env, object) {
+    MakeWeak<ModuleResolver>(this);
+  }
+
+  static void New(const FunctionCallbackInfo<Value>& args);
+  static void Resolve(const FunctionCallbackInfo<Value>& args);
+
+  int StatPath(const std::string& path);
+  bool TryFile(const std::string& path, std::string* filename);
+  bool TryExtensions(const std::string& path, std::string* filename);
+  Outcome TryPackage(const std::string& dir, std::string* filename);
+  Outcome TryBasePath(const std::string& base,
+                      bool trailing_slash,
+                      std::string* filename);
+  const Package* ReadPackage(const std::string& dir);
+
+  std::vector<std::string> exts_;
+  std::map<std::string, Package> packages_;
+};
+
+
+void ModuleResolver::Initialize(Environment* env, Local<Object> target) {
+  Local<FunctionTemplate> t = env->NewFunctionTemplate(New);
+  t->InstanceTemplate()->SetInternalFieldCount(1);
+  t->SetClassName(FIXED_ONE_BYTE_STRING(env->isolate(), "ModuleResolver"));
+  env->SetProtoMethod(t, "resolve", Resolve);
+  target->Set(FIXED_ONE_BYTE_STRING(env->isolate(), "ModuleResolver"),
+              t->GetFunction());
+}
+
+
+void ModuleResolver::New(const FunctionCallbackInfo<Value>& args) {
+  CHECK(args.IsConstructCall());
+  Environment* env = Environment::GetCurrent(args);
+  new ModuleResolver(env, args.This());
+}
+
+
+// Same return values as InternalModuleStat().
+int ModuleResolver::StatPath(const std::string& path) {
+  uv_fs_t req;
+  int rc = uv_fs_stat(env()->event_loop(), &req, path.c_str(), nullptr);
+  if (rc == 0) {
+    const uv_stat_t* const s = static_cast<const uv_stat_t*>(req.ptr);
+    rc = !!(s->st_mode & S_IFDIR);
+  }
+  uv_fs_req_cleanup(&req);
+  return rc;
+}
+
+
+bool ModuleResolver::TryFile(const std::string& path, std::string* filename) {
+  if (StatPath(path) != 0)
+    return false;
+  *filename = path;
+  return true;
+}
+
+
+bool ModuleResolver::TryExtensions(const std::string& path,
+                                   std::string* filename) {
+  for (size_t i = 0; i < exts_.size(); i++) {
+    if (TryFile(path + exts_[i], filename))
+      return true;
+  }
+  return false;
+}
+
+
+// Returns nullptr if |dir| has no package.json.
+const ModuleResolver::Package* ModuleResolver::ReadPackage(
+    const std::string& dir) {
+  std::map<std::string, Package>::iterator it = packages_.find(dir);
+  if (it != packages_.end())
+    return &it->second;
+
+  std::string json_path(dir);
+  if (!IsPathSeparator(json_path[json_path.size() - 1]))
+    json_path += kPathSeparator;
+  json_path += "package.json";
+
+  FILE* const stream = fopen(json_path.c_str(), "rb");
+  if (stream == nullptr)
+    return nullptr;
+
+  std::vector<char> chars;
+  char buf[8192];
+  size_t numchars;
+  while ((numchars = fread(buf, 1, sizeof(buf), stream)) > 0)
+    chars.insert(chars.end(), buf, buf + numchars);
+  const bool failed = ferror(stream) != 0;
+  fclose(stream);
+
+  size_t start = 0;
+  if (chars.size() >= 3 && 0 == memcmp(&chars[0], "\xEF\xBB\xBF", 3))
+    start = 3;  // Skip UTF-8 BOM.
+
+  Package& package = packages_[dir];
+  if (failed) {
+    package.state = kPackageUnsupported;
+  } else {
+    PackageMainScanner scanner(chars.data() + start, chars.size() - start);
+    package.state = scanner.Scan(&package.main);
+  }
+  return &package;
+}
+
+
+ModuleResolver::Outcome ModuleResolver::TryPackage(const std::string& dir,
+                                                   std::string* filename) {
+  const Package* package = ReadPackage(dir);
+  if (package == nullptr)
+    return kNotFound;
+  if (package->state == kPackageUnsupported)
+    return kFallback;
+  if (package->state != kPackageMain)
+    return kNotFound;
+
+  std::string main;
+  std::string index;
+  if (!ResolveRelative(dir, package->main, &main) ||
+      !ResolveRelative(main, "index", &index)) {
+    return kFallback;
+  }
+  if (TryFile(main, filename) ||
+      TryExtensions(main, filename) ||
+      TryExtensions(index, filename)) {
+    return kFound;
+  }
+  return kNotFound;
+}
+
+
+// Mirrors the search order of Module._findPath() for one search path.
+ModuleResolver::Outcome ModuleResolver::TryBasePath(const std::string& base,
+                                                    bool trailing_slash,
+                                                    std::string* filename) {
+  Outcome outcome = kNotFound;
+
+  // UNC paths on Windows are left to the JS search.
+  std::string index;
+  if (!ResolveRelative(base, "index", &index))
+    return kFallback;
+
+  if (!trailing_slash) {
+    // 0 is a file, 1 a directory.
+    const int rc = StatPath(base);
+    if (rc == 0) {
+      *filename = base;
+      return kFound;
+    }
+    if (rc == 1) {
+      outcome = TryPackage(base, filename);
+      if (outcome != kNotFound)
+        return outcome;
+    }
+    if (TryExtensions(base, filename))
+      return kFound;
+  }
+
+  outcome = TryPackage(base, filename);
+  if (outcome != kNotFound)
+    return outcome;
+
+  return TryExtensions(index, filename) ? kFound : kNotFound;
+}
+
+
+// resolve(basePaths, exts, trailingSlash) returns [index, filename] for
+// the first search path that yields a file, false if there is none, or
+// the directory of a package.json that needs to be handled in JS.
+// Filenames are not passed through realpath().
+void ModuleResolver::Resolve(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  ModuleResolver* resolver = Unwrap<ModuleResolver>(args.Holder());
+
+  CHECK(args[0]->IsArray());
+  CHECK(args[1]->IsArray());
+  Local<Array> base_paths = args[0].As<Array>();
+  Local<Array> exts = args[1].As<Array>();
+  const bool trailing_slash = args[2]->BooleanValue();
+
+  resolver->exts_.resize(exts->Length());
+  for (uint32_t i = 0; i < exts->Length(); i++) {
+    node::Utf8Value ext(env->isolate(), exts->Get(i));
+    resolver->exts_[i].assign(*ext, ext.length());
+  }
+
+  for (uint32_t i = 0; i < base_paths->Length(); i++) {
+    node::Utf8Value path(env->isolate(), base_paths->Get(i));
+    const std::string base(*path, path.length());
+    std::string filename;
+
+    switch (resolver->TryBasePath(base, trailing_slash, &filename)) {
+      case kFound: {
+        Local<Array> result = Array::New(env->isolate(), 2);
+        result->Set(0, Integer::NewFromUnsigned(env->isolate(), i));
+        result->Set(1, String::NewFromUtf8(env->isolate(),
+                                           filename.data(),
+                                           String::kNormalString,
+                                           filename.size()));
+        return args.GetReturnValue().Set(result);
+      }
+      case kFallback:
+        return args.GetReturnValue().Set(base_paths->Get(i));
+      case kNotFound:
+        break;
+    }
+  }
+
+  args.GetReturnValue().Set(false);
+}
+
+
 static void Stat(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
 
@@ -513,8 +1106,7 @@ static void Stat(const FunctionCallbackInfo<Value>& args) {
     ASYNC_CALL(stat, args[1], *path)
   } else {
     SYNC_CALL(stat, *path, *path)
-    args.GetReturnValue().Set(
-        BuildStatsObject(env, static_cast<const uv_stat_t*>(SYNC_REQ.ptr)));
+    FillStatsArray(env, static_cast<const uv_stat_t*>(SYNC_REQ.ptr));
   }
 }
 
@@ -532,8 +1124,7 @@ static void LStat(const FunctionCallbackInfo<Value>& args) {
     ASYNC_CALL(lstat, args[1], *path)
   } else {
     SYNC_CALL(lstat, *path, *path)
-    args.GetReturnValue().Set(
-        BuildStatsObject(env, static_cast<const uv_stat_t*>(SYNC_REQ.ptr)));
+    FillStatsArray(env, static_cast<const uv_stat_t*>(SYNC_REQ.ptr));
   }
 }
 
@@ -550,8 +1141,7 @@ static void FStat(const FunctionCallbackInfo<Value>& args) {
     ASYNC_CALL(fstat, args[1], fd)
   } else {
     SYNC_CALL(fstat, 0, fd)
-    args.GetReturnValue().Set(
-        BuildStatsObject(env, static_cast<const uv_stat_t*>(SYNC_REQ.ptr)));
+    FillStatsArray(env, static_cast<const uv_stat_t*>(SYNC_REQ.ptr));
   }
 }
 
@@ -804,6 +1394,423 @@ static void ReadDir(const FunctionCallbackInfo<Value>& args) {
   }
 }
 
+static uv_dirent_type_t DirentTypeFromMode(uint64_t mode) {
+  switch (mode & S_IFMT) {
+    case S_IFREG: return UV_DIRENT_FILE;
+    case S_IFDIR: return UV_DIRENT_DIR;
+    case S_IFCHR: return UV_DIRENT_CHAR;
+#ifdef S_IFLNK
+    case S_IFLNK: return UV_DIRENT_LINK;
+#endif
+#ifdef S_IFIFO
+    case S_IFIFO: return UV_DIRENT_FIFO;
+#endif
+#ifdef S_IFSOCK
+    case S_IFSOCK: return UV_DIRENT_SOCKET;
+#endif
+#ifdef S_IFBLK
+    case S_IFBLK: return UV_DIRENT_BLOCK;
+#endif
+    default: return UV_DIRENT_UNKNOWN;
+  }
+}
+
+
+// Lists a directory, optionally recursively, together with the d_type of
+// every entry and, when asked for, its lstat() data.  The results are kept
+// off the JS heap until the walk is done and are then handed out as one
+// array of names plus flat external arrays for the types and stat fields,
+// which is a lot cheaper than an fs.Stats object per entry.
+//
+// DirWalk only holds the walk state; the synchronous version drives it
+// directly and DirWalkWrap drives it from the threadpool.  Symbolic links
+// are reported, not followed.
+class DirWalk {
+ public:
+  DirWalk(const char* root, bool with_stats, bool recursive)
+      : root_(root),
+        with_stats_(with_stats),
+        recursive_(recursive),
+        next_stat_(0),
+        error_(0),
+        error_syscall_(nullptr) {
+    pending_dirs_.push_back(std::string());
+  }
+
+  // Runs the whole walk on the calling thread.
+  void RunSync(uv_loop_t* loop);
+
+  // Returns [names, types, stats], or the exception for the first error
+  // seen when failed() is true.
+  Local<Value> Result(Environment* env);
+
+  bool failed() const { return error_ != 0; }
+
+  size_t memory_size() const;
+
+ private:
+  friend class DirWalkWrap;
+
+  bool NextStat(size_t* index);
+  std::string FullPath(const std::string& rel) const;
+  void SetError(int err, const char* syscall, const std::string& rel);
+  void OnScan(const std::string& rel, uv_fs_t* req);
+  void OnStat(size_t index, uv_fs_t* req);
+
+  const std::string root_;
+  const bool with_stats_;
+  const bool recursive_;
+  std::vector<std::string> pending_dirs_;
+  std::vector<std::string> names_;
+  std::vector<uint8_t> types_;
+  std::vector<double> stats_;
+  size_t next_stat_;
+  int error_;
+  const char* error_syscall_;
+  std::string error_path_;
+};
+
+
+// Asynchronous walk.  Keeps up to kMaxInflight scandir and lstat requests
+// in flight, so subdirectories and stat batches are processed in parallel
+// on the threadpool.
+class DirWalkWrap : public AsyncWrap {
+ public:
+  DirWalkWrap(Environment* env,
+              Local<Object> object,
+              const char* root,
+              bool with_stats,
+              bool recursive)
+      : AsyncWrap(env, object, AsyncWrap::PROVIDER_FSREQWRAP),
+        walk_(root, with_stats, recursive),
+        inflight_(0) {
+  }
+
+  ~DirWalkWrap() override {
+    persistent().Reset();
+  }
+
+  // Starts the walk; |oncomplete| on the wrapped object is called with
+  // (err, [names, types, stats]) once every outstanding request is done.
+  // Returns false without calling |oncomplete| when not even the first
+  // request could be queued, walk()->Result() then holds the error.
+  bool Start();
+
+  DirWalk* walk() { return &walk_; }
+
+  size_t self_size() const override {
+    return sizeof(*this) - sizeof(walk_) + walk_.memory_size();
+  }
+
+ private:
+  static const unsigned kMaxInflight = 32;
+
+  struct Request {
+    DirWalkWrap* wrap;
+    std::string rel;
+    size_t index;
+    uv_fs_t req;
+  };
+
+  void Pump();
+  void Done();
+
+  static void AfterScan(uv_fs_t* req);
+  static void AfterStat(uv_fs_t* req);
+
+  DirWalk walk_;
+  unsigned inflight_;
+};
+
+
+size_t DirWalk::memory_size() const {
+  size_t size = sizeof(*this);
+  size += pending_dirs_.capacity() * sizeof(pending_dirs_[0]);
+  size += names_.capacity() * sizeof(names_[0]);
+  size += types_.capacity() * sizeof(types_[0]);
+  size += stats_.capacity() * sizeof(stats_[0]);
+  return size;
+}
+
+
+std::string DirWalk::FullPath(const std::string& rel) const {
+  if (rel.empty())
+    return root_;
+  return root_ + kPathSeparator + rel;
+}
+
+
+void DirWalk::SetError(int err, const char* syscall, const std::string& rel) {
+  if (failed())
+    return;
+  error_ = err;
+  error_syscall_ = syscall;
+  error_path_ = FullPath(rel);
+}
+
+
+// An entry needs an lstat() when the caller wants stats, or when the
+// file system did not report its type and we need to know whether to
+// descend into it.
+bool DirWalk::NextStat(size_t* index) {
+  while (next_stat_ < names_.size()) {
+    size_t i = next_stat_++;
+    if (with_stats_ || (recursive_ && types_[i] == UV_DIRENT_UNKNOWN)) {
+      *index = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+
+void DirWalk::OnScan(const std::string& rel, uv_fs_t* req) {
+  if (req->result < 0)
+    return SetError(req->result, "scandir", rel);
+
+  uv_dirent_t ent;
+  int r;
+  while ((r = uv_fs_scandir_next(req, &ent)) == 0) {
+    std::string name(rel);
+    if (!name.empty())
+      name += kPathSeparator;
+    name += ent.name;
+    if (recursive_ && ent.type == UV_DIRENT_DIR)
+      pending_dirs_.push_back(name);
+    names_.push_back(name);
+    types_.push_back(static_cast<uint8_t>(ent.type));
+  }
+
+  if (r != UV_EOF)
+    SetError(r, "scandir", rel);
+
+  if (with_stats_)
+    stats_.resize(names_.size() * kStatFieldCount);
+}
+
+
+void DirWalk::OnStat(size_t index, uv_fs_t* req) {
+  if (req->result < 0)
+    return SetError(req->result, "lstat", names_[index]);
+
+  const uv_stat_t* s = static_cast<const uv_stat_t*>(req->ptr);
+  if (with_stats_)
+    FillStatFields(&stats_[index * kStatFieldCount], s);
+
+  if (types_[index] == UV_DIRENT_UNKNOWN) {
+    uv_dirent_type_t type = DirentTypeFromMode(s->st_mode);
+    types_[index] = static_cast<uint8_t>(type);
+    if (recursive_ && type == UV_DIRENT_DIR)
+      pending_dirs_.push_back(names_[index]);
+  }
+}
+
+
+void DirWalk::RunSync(uv_loop_t* loop) {
+  size_t index;
+
+  while (!failed()) {
+    uv_fs_t req;
+    if (!pending_dirs_.empty()) {
+      std::string rel = pending_dirs_.back();
+      pending_dirs_.pop_back();
+      uv_fs_scandir(loop, &req, FullPath(rel).c_str(), 0, nullptr);
+      OnScan(rel, &req);
+    } else if (NextStat(&index)) {
+      uv_fs_lstat(loop, &req, FullPath(names_[index]).c_str(), nullptr);
+      OnStat(index, &req);
+    } else {
+      break;
+    }
+    uv_fs_req_cleanup(&req);
+  }
+}
+
+
+Local<Value> DirWalk::Result(Environment* env) {
+  EscapableHandleScope handle_scope(env->isolate());
+
+  if (failed()) {
+    return handle_scope.Escape(UVException(env->isolate(),
+                                           error_,
+                                           error_syscall_,
+                                           nullptr,
+                                           error_path_.c_str()));
+  }
+
+  const size_t count = names_.size();
+  Local<Array> names = Array::New(env->isolate(), count);
+  for (size_t i = 0; i < count; i++) {
+    Local<String> name = String::NewFromUtf8(env->isolate(),
+                                             names_[i].data(),
+                                             String::kNormalString,
+                                             names_[i].size());
+    names->Set(i, name);
+  }
+
+  Local<Object> types = Object::New(env->isolate());
+  if (count > 0) {
+    char* data = static_cast<char*>(malloc(count));
+    CHECK_NE(data, nullptr);
+    memcpy(data, &types_[0], count);
+    smalloc::Alloc(env, types, data, count, v8::kExternalUint8Array);
+  }
+
+  Local<Value> stats = Undefined(env->isolate());
+  if (with_stats_) {
+    Local<Object> obj = Object::New(env->isolate());
+    const size_t byte_length = stats_.size() * sizeof(stats_[0]);
+    if (byte_length > 0) {
+      char* data = static_cast<char*>(malloc(byte_length));
+      CHECK_NE(data, nullptr);
+      memcpy(data, &stats_[0], byte_length);
+      smalloc::Alloc(env, obj, data, byte_length, v8::kExternalFloat64Array);
+    }
+    stats = obj;
+  }
+
+  Local<Array> result = Array::New(env->isolate(), 3);
+  result->Set(0, names);
+  result->Set(1, types);
+  result->Set(2, stats);
+  return handle_scope.Escape(result);
+}
+
+
+bool DirWalkWrap::Start() {
+  Pump();
+  return inflight_ > 0;
+}
+
+
+// Keeps the threadpool busy: directories are scanned before queued stats
+// so that the walk widens as quickly as possible.
+void DirWalkWrap::Pump() {
+  uv_loop_t* loop = env()->event_loop();
+  size_t index;
+
+  while (!walk_.failed() && inflight_ < kMaxInflight) {
+    Request* r = new Request();
+    r->wrap = this;
+    r->index = 0;
+    const char* syscall;
+    int err;
+
+    if (!walk_.pending_dirs_.empty()) {
+      syscall = "scandir";
+      r->rel = walk_.pending_dirs_.back();
+      walk_.pending_dirs_.pop_back();
+      err = uv_fs_scandir(loop,
+                          &r->req,
+                          walk_.FullPath(r->rel).c_str(),
+                          0,
+                          AfterScan);
+    } else if (walk_.NextStat(&index)) {
+      syscall = "lstat";
+      r->index = index;
+      r->rel = walk_.names_[index];
+      err = uv_fs_lstat(loop,
+                        &r->req,
+                        walk_.FullPath(r->rel).c_str(),
+                        AfterStat);
+    } else {
+      delete r;
+      break;
+    }
+
+    if (err < 0) {
+      walk_.SetError(err, syscall, r->rel);
+      delete r;
+      break;
+    }
+
+    inflight_++;
+  }
+}
+
+
+void DirWalkWrap::AfterScan(uv_fs_t* req) {
+  Request* r = ContainerOf(&Request::req, req);
+  DirWalkWrap* wrap = r->wrap;
+  wrap->walk_.OnScan(r->rel, req);
+  uv_fs_req_cleanup(req);
+  delete r;
+  wrap->inflight_--;
+  wrap->Pump();
+  if (wrap->inflight_ == 0)
+    wrap->Done();
+}
+
+
+void DirWalkWrap::AfterStat(uv_fs_t* req) {
+  Request* r = ContainerOf(&Request::req, req);
+  DirWalkWrap* wrap = r->wrap;
+  wrap->walk_.OnStat(r->index, req);
+  uv_fs_req_cleanup(req);
+  delete r;
+  wrap->inflight_--;
+  wrap->Pump();
+  if (wrap->inflight_ == 0)
+    wrap->Done();
+}
+
+
+void DirWalkWrap::Done() {
+  Environment* env = this->env();
+  HandleScope handle_scope(env->isolate());
+  Context::Scope context_scope(env->context());
+
+  Local<Value> argv[2] = { Null(env->isolate()), Undefined(env->isolate()) };
+  Local<Value> result = walk_.Result(env);
+  if (walk_.failed())
+    argv[0] = result;
+  else
+    argv[1] = result;
+
+  MakeCallback(env->oncomplete_string(), ARRAY_SIZE(argv), argv);
+  delete this;
+}
+
+
+// walkdir(path, withStats, recursive[, req])
+//
+// The asynchronous form returns the error instead of calling |oncomplete|
+// when the walk fails before anything was queued, the caller is expected
+// to defer the callback so that it never runs synchronously.
+static void WalkDir(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+
+  if (args.Length() < 1)
+    return TYPE_ERROR("path required");
+  if (!args[0]->IsString())
+    return TYPE_ERROR("path must be a string");
+
+  node::Utf8Value path(env->isolate(), args[0]);
+  const bool with_stats = args[1]->BooleanValue();
+  const bool recursive = args[2]->BooleanValue();
+
+  if (args[3]->IsObject()) {
+    Local<Object> req = args[3].As<Object>();
+    if (env->in_domain())
+      req->Set(env->domain_string(), env->domain_array()->Get(0));
+    DirWalkWrap* wrap =
+        new DirWalkWrap(env, req, *path, with_stats, recursive);
+    if (!wrap->Start()) {
+      args.GetReturnValue().Set(wrap->walk()->Result(env));
+      delete wrap;
+    }
+  } else {
+    env->PrintSyncTrace();
+    DirWalk walk(*path, with_stats, recursive);
+    walk.RunSync(env->event_loop());
+    Local<Value> result = walk.Result(env);
+    if (walk.failed())
+      env->isolate()->ThrowException(result);
+    else
+      args.GetReturnValue().Set(result);
+  }
+}
+
 static void Open(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
 
@@ -1181,9 +2188,11 @@ static void FUTimes(const FunctionCallbackInfo<Value>& args) {
 void FSInitialize(const FunctionCallbackInfo<Value>& args) {
   Local<Function> stats_constructor = args[0].As<Function>();
   CHECK(stats_constructor->IsFunction());
+  CHECK(args[1]->IsObject());
 
   Environment* env = Environment::GetCurrent(args);
   env->set_fs_stats_constructor_function(stats_constructor);
+  env->set_fs_stats_field_array(args[1].As<Object>());
 }
 
 void InitFs(Handle<Object> target,
@@ -1207,8 +2216,10 @@ void InitFs(Handle<Object> target,
   env->SetMethod(target, "rmdir", RMDir);
   env->SetMethod(target, "mkdir", MKDir);
   env->SetMethod(target, "readdir", ReadDir);
+  env->SetMethod(target, "walkdir", WalkDir);
   env->SetMethod(target, "internalModuleReadFile", InternalModuleReadFile);
   env->SetMethod(target, "internalModuleStat", InternalModuleStat);
+  ModuleResolver::Initialize(env, target);
   env->SetMethod(target, "stat", Stat);
   env->SetMethod(target, "lstat", LStat);
   env->SetMethod(target, "fstat", FStat);
@@ -1230,6 +2241,16 @@ void InitFs(Handle<Object> target,
   env->SetMethod(target, "utimes", UTimes);
   env->SetMethod(target, "futimes", FUTimes);
 
+  NODE_DEFINE_CONSTANT(target, UV_DIRENT_UNKNOWN);
+  NODE_DEFINE_CONSTANT(target, UV_DIRENT_FILE);
+  NODE_DEFINE_CONSTANT(target, UV_DIRENT_DIR);
+  NODE_DEFINE_CONSTANT(target, UV_DIRENT_LINK);
+  NODE_DEFINE_CONSTANT(target, UV_DIRENT_FIFO);
+  NODE_DEFINE_CONSTANT(target, UV_DIRENT_SOCKET);
+  NODE_DEFINE_CONSTANT(target, UV_DIRENT_CHAR);
+  NODE_DEFINE_CONSTANT(target, UV_DIRENT_BLOCK);
+  NODE_DEFINE_CONSTANT(target, kStatFieldCount);
+
   StatWatcher::Initialize(env, target);
 
   // Create FunctionTemplate for FSReqWrap
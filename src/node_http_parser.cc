@@ -10,9 +10,12 @@
 #include "util-inl.h"
 #include "v8.h"
 
+#include <stdio.h>  // snprintf()
 #include <stdlib.h>  // free()
 #include <string.h>  // strdup()
 
+#include <vector>
+
 #if defined(_MSC_VER)
 #define strcasecmp _stricmp
 #else
@@ -55,6 +58,83 @@ const uint32_t kOnHeadersComplete = 1;
 const uint32_t kOnBody = 2;
 const uint32_t kOnMessageComplete = 3;
 
+// Bits reported back to _http_outgoing.js by SerializeHeaders().
+#define HEADER_FLAGS(V)                                                       \
+  V(0x001, kSentConnectionHeader)                                             \
+  V(0x002, kSentContentLengthHeader)                                          \
+  V(0x004, kSentTransferEncodingHeader)                                       \
+  V(0x008, kSentDateHeader)                                                   \
+  V(0x010, kSentExpect)                                                       \
+  V(0x020, kSentTrailer)                                                      \
+  V(0x040, kConnectionClose)                                                  \
+  V(0x080, kConnectionKeepAlive)                                              \
+  V(0x100, kChunkedEncoding)
+
+#define V(value, name) const uint32_t name = value;
+HEADER_FLAGS(V)
+#undef V
+
+
+// Well-known header names are found through a perfect hash over the length
+// and the first and last character of the lower-cased name.  The table is
+// filled, and checked for collisions, when the binding is first loaded.
+struct KnownHeader {
+  const char* lower;
+  const char* canonical;
+  size_t length;
+  Local<String> (Environment::*lower_string)() const;
+  Local<String> (Environment::*canonical_string)() const;
+};
+
+
+static const KnownHeader known_headers[] = {
+#define V(_, name, lower, canonical)                                          \
+  { lower,                                                                    \
+    canonical,                                                                \
+    sizeof(lower) - 1,                                                        \
+    &Environment::name ## _header_string,                                     \
+    &Environment::name ## _raw_header_string },
+  HTTP_KNOWN_HEADERS(V, _)
+#undef V
+};
+
+
+static const size_t kKnownHeaderSlots = 64;
+static int8_t known_header_slots[kKnownHeaderSlots];
+
+
+static inline size_t KnownHeaderHash(const char* lower, size_t length) {
+  const unsigned char first = lower[0];
+  const unsigned char last = lower[length - 1];
+  return (length + first * 9 + last * 35) & (kKnownHeaderSlots - 1);
+}
+
+
+static void InitKnownHeaderSlots() {
+  for (size_t i = 0; i < kKnownHeaderSlots; i++)
+    known_header_slots[i] = -1;
+
+  for (size_t i = 0; i < ARRAY_SIZE(known_headers); i++) {
+    const KnownHeader& header = known_headers[i];
+    const size_t slot = KnownHeaderHash(header.lower, header.length);
+    CHECK_EQ(known_header_slots[slot], -1);  // Hash must stay perfect.
+    known_header_slots[slot] = static_cast<int8_t>(i);
+  }
+}
+
+
+// |lower| must be lower case and |length| greater than zero.
+static inline const KnownHeader* LookupKnownHeader(const char* lower,
+                                                   size_t length) {
+  const int index = known_header_slots[KnownHeaderHash(lower, length)];
+  if (index == -1)
+    return nullptr;
+  const KnownHeader* header = &known_headers[index];
+  if (header->length != length || memcmp(header->lower, lower, length) != 0)
+    return nullptr;
+  return header;
+}
+
 
 #define HTTP_CB(name)                                                         \
   static int name(http_parser* p_) {                                          \
@@ -233,6 +313,7 @@ class Parser : public BaseObject {
       A_STATUS_MESSAGE,
       A_UPGRADE,
       A_SHOULD_KEEP_ALIVE,
+      A_HEADER_NAMES,
       A_MAX
     };
 
@@ -252,7 +333,11 @@ class Parser : public BaseObject {
       Flush();
     } else {
       // Fast case, pass headers and URL to JS land.
-      argv[A_HEADERS] = CreateHeaders();
+      Local<Array> headers;
+      Local<Array> names;
+      CreateHeaders(&headers, &names);
+      argv[A_HEADERS] = headers;
+      argv[A_HEADER_NAMES] = names;
       if (parser_.type == HTTP_REQUEST)
         argv[A_URL] = url_.ToString(env());
     }
@@ -480,17 +565,76 @@ class Parser : public BaseObject {
 
  private:
 
-  Local<Array> CreateHeaders() {
+  // Returns the header field at |index| both as sent and in lower case.
+  // Well-known names come from the per-isolate string table and names that
+  // are lower case already share one string, so typical requests allocate
+  // no name strings at all.
+  void HeaderName(int index, Local<String>* raw, Local<String>* lower) {
+    const StringPtr& field = fields_[index];
+    const char* const data = field.str_;
+    const size_t length = field.size_;
+
+    if (length == 0) {
+      *raw = *lower = String::Empty(env()->isolate());
+      return;
+    }
+
+    char stack_storage[256];
+    char* lowered = stack_storage;
+    if (length > sizeof(stack_storage))
+      lowered = new char[length];
+
+    // http_parser only lets token characters through, so ASCII case
+    // folding matches what String#toLowerCase() did.
+    bool has_upper = false;
+    for (size_t i = 0; i < length; i++) {
+      const char c = data[i];
+      if (c >= 'A' && c <= 'Z') {
+        lowered[i] = c | 0x20;
+        has_upper = true;
+      } else {
+        lowered[i] = c;
+      }
+    }
+
+    const KnownHeader* known = LookupKnownHeader(lowered, length);
+    if (known != nullptr) {
+      *lower = (env()->*known->lower_string)();
+      if (!has_upper)
+        *raw = *lower;
+      else if (memcmp(data, known->canonical, length) == 0)
+        *raw = (env()->*known->canonical_string)();
+      else
+        *raw = OneByteString(env()->isolate(), data, length);
+    } else {
+      *raw = OneByteString(env()->isolate(), data, length);
+      if (has_upper)
+        *lower = OneByteString(env()->isolate(), lowered, length);
+      else
+        *lower = *raw;
+    }
+
+    if (lowered != stack_storage)
+      delete[] lowered;
+  }
+
+
+  // Fills |headers| with [field, value, field, value, ...] pairs and |names|
+  // with the lower-cased field names.
+  void CreateHeaders(Local<Array>* headers, Local<Array>* names) {
     // num_values_ is either -1 or the entry # of the last header
     // so num_values_ == 0 means there's a single header
-    Local<Array> headers = Array::New(env()->isolate(), 2 * num_values_);
+    *headers = Array::New(env()->isolate(), 2 * num_values_);
+    *names = Array::New(env()->isolate(), num_values_);
 
     for (int i = 0; i < num_values_; ++i) {
-      headers->Set(2 * i, fields_[i].ToString(env()));
-      headers->Set(2 * i + 1, values_[i].ToString(env()));
+      Local<String> raw;
+      Local<String> lower;
+      HeaderName(i, &raw, &lower);
+      (*headers)->Set(2 * i, raw);
+      (*headers)->Set(2 * i + 1, values_[i].ToString(env()));
+      (*names)->Set(i, lower);
     }
-
-    return headers;
   }
 
 
@@ -504,9 +648,14 @@ class Parser : public BaseObject {
     if (!cb->IsFunction())
       return;
 
-    Local<Value> argv[2] = {
-      CreateHeaders(),
-      url_.ToString(env())
+    Local<Array> headers;
+    Local<Array> names;
+    CreateHeaders(&headers, &names);
+
+    Local<Value> argv[3] = {
+      headers,
+      url_.ToString(env()),
+      names
     };
 
     Local<Value> r = cb.As<Function>()->Call(obj, ARRAY_SIZE(argv), argv);
@@ -560,11 +709,256 @@ const struct http_parser_settings Parser::settings = {
 };
 
 
+// Builds the header block of an outgoing message into a single buffer, the
+// way OutgoingMessage#_storeHeader() used to do with string concatenation.
+class HeaderSerializer {
+ public:
+  explicit HeaderSerializer(Environment* env) : env_(env), flags_(0) {
+    buf_.reserve(1024);
+  }
+
+  void Append(const char* data, size_t length) {
+    buf_.insert(buf_.end(), data, data + length);
+  }
+
+  size_t Append(Local<String> string) {
+    const size_t offset = buf_.size();
+    const size_t length = string->Length();
+    buf_.resize(offset + length);
+    if (length > 0) {
+      string->Write(&buf_[offset], 0, length, String::NO_NULL_TERMINATION);
+    }
+    return offset;
+  }
+
+  // Returns false with a pending exception if a name or value can't be
+  // stringified or the name is not a valid RFC 7230 token.
+  bool AddHeader(Local<Value> field, Local<Value> value) {
+    if (value->IsArray()) {
+      Local<Array> values = value.As<Array>();
+      for (uint32_t i = 0, n = values->Length(); i < n; i++) {
+        if (!AddHeaderLine(field, values->Get(i)))
+          return false;
+      }
+      return true;
+    }
+    return AddHeaderLine(field, value);
+  }
+
+  Local<String> ToString() const {
+    return String::NewFromTwoByte(env_->isolate(),
+                                  buf_.data(),
+                                  String::kNormalString,
+                                  buf_.size());
+  }
+
+  uint32_t flags() const {
+    return flags_;
+  }
+
+ private:
+  bool AddHeaderLine(Local<Value> field_value, Local<Value> value_value) {
+    Local<String> field = field_value->ToString(env_->isolate());
+    if (field.IsEmpty())
+      return false;
+    Local<String> value = value_value->ToString(env_->isolate());
+    if (value.IsEmpty())
+      return false;
+
+    const size_t field_start = Append(field);
+    const size_t field_end = buf_.size();
+    if (!IsToken(field_start, field_end)) {
+      buf_.resize(field_start);
+      Utf8Value name(env_->isolate(), field);
+      char message[256];
+      snprintf(message,
+               sizeof(message),
+               "Header name must be a valid HTTP Token [\"%s\"]",
+               *name);
+      env_->ThrowTypeError(message);
+      return false;
+    }
+
+    Append(": ", 2);
+    const size_t value_start = Append(value);
+    StripLineBreaks(value_start);
+    const size_t value_end = buf_.size();
+    Append("\r\n", 2);
+
+    UpdateFlags(field_start, field_end, value_start, value_end);
+    return true;
+  }
+
+  static bool IsTokenChar(uint16_t c) {
+    // tchar = "!" / "#" / "$" / "%" / "&" / "'" / "*" / "+" / "-" / "." /
+    //         "^" / "_" / "`" / "|" / "~" / DIGIT / ALPHA
+    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))
+      return true;
+    if (c >= '0' && c <= '9')
+      return true;
+    switch (c) {
+      case '!': case '#': case '$': case '%': case '&': case '\'':
+      case '*': case '+': case '-': case '.': case '^': case '_':
+      case '`': case '|': case '~':
+        return true;
+    }
+    return false;
+  }
+
+  bool IsToken(size_t start, size_t end) const {
+    if (start == end)
+      return false;
+    for (size_t i = start; i < end; i++) {
+      if (!IsTokenChar(buf_[i]))
+        return false;
+    }
+    return true;
+  }
+
+  // Protects against response splitting by removing every run of CR and LF
+  // characters plus the whitespace that follows it, like the
+  // value.replace(/[\r\n]+[ \t]*/g, '') it replaces.
+  void StripLineBreaks(size_t start) {
+    size_t out = start;
+    size_t i = start;
+    const size_t end = buf_.size();
+    while (i < end) {
+      uint16_t c = buf_[i];
+      if (c != '\r' && c != '\n') {
+        buf_[out++] = c;
+        i++;
+        continue;
+      }
+      while (i < end && (buf_[i] == '\r' || buf_[i] == '\n'))
+        i++;
+      while (i < end && (buf_[i] == ' ' || buf_[i] == '\t'))
+        i++;
+    }
+    buf_.resize(out);
+  }
+
+  static uint16_t ToLower(uint16_t c) {
+    return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+  }
+
+  // |name| must be lower case.
+  bool Equals(size_t start, size_t end, const char* name) const {
+    const size_t length = strlen(name);
+    if (end - start != length)
+      return false;
+    for (size_t i = 0; i < length; i++) {
+      if (ToLower(buf_[start + i]) != name[i])
+        return false;
+    }
+    return true;
+  }
+
+  // |needle| must be lower case.
+  bool Contains(size_t start, size_t end, const char* needle) const {
+    const size_t length = strlen(needle);
+    for (size_t i = start; i + length <= end; i++) {
+      size_t j = 0;
+      while (j < length && ToLower(buf_[i + j]) == needle[j])
+        j++;
+      if (j == length)
+        return true;
+    }
+    return false;
+  }
+
+  void UpdateFlags(size_t field_start,
+                   size_t field_end,
+                   size_t value_start,
+                   size_t value_end) {
+    if (Equals(field_start, field_end, "connection")) {
+      flags_ |= kSentConnectionHeader;
+      if (Contains(value_start, value_end, "close"))
+        flags_ |= kConnectionClose;
+      else
+        flags_ |= kConnectionKeepAlive;
+    } else if (Equals(field_start, field_end, "transfer-encoding")) {
+      flags_ |= kSentTransferEncodingHeader;
+      if (Contains(value_start, value_end, "chunk"))
+        flags_ |= kChunkedEncoding;
+    } else if (Equals(field_start, field_end, "content-length")) {
+      flags_ |= kSentContentLengthHeader;
+    } else if (Equals(field_start, field_end, "date")) {
+      flags_ |= kSentDateHeader;
+    } else if (Equals(field_start, field_end, "expect")) {
+      flags_ |= kSentExpect;
+    } else if (Equals(field_start, field_end, "trailer")) {
+      flags_ |= kSentTrailer;
+    }
+  }
+
+  Environment* const env_;
+  std::vector<uint16_t> buf_;
+  uint32_t flags_;
+};
+
+
+// serializeHeaders(firstLine, headers, isArray, flags)
+//
+// |headers| is either an object or an array of [name, value] pairs.  The
+// resulting flags are written to the first slot of the |flags| Uint32Array.
+static void SerializeHeaders(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+
+  CHECK(args[0]->IsString());
+  CHECK(args[3]->IsObject());
+
+  if (!args[1]->IsObject())
+    return env->ThrowTypeError("headers must be an object or an array");
+
+  Local<Object> flags_obj = args[3].As<Object>();
+  CHECK_EQ(flags_obj->GetIndexedPropertiesExternalArrayDataType(),
+           v8::kExternalUint32Array);
+  CHECK_GE(flags_obj->GetIndexedPropertiesExternalArrayDataLength(), 1);
+  uint32_t* flags = static_cast<uint32_t*>(
+      flags_obj->GetIndexedPropertiesExternalArrayData());
+
+  HeaderSerializer serializer(env);
+  serializer.Append(args[0].As<String>());
+
+  Local<Object> headers = args[1].As<Object>();
+  if (args[2]->IsTrue()) {
+    Local<Array> pairs = headers.As<Array>();
+    for (uint32_t i = 0, n = pairs->Length(); i < n; i++) {
+      Local<Value> pair_value = pairs->Get(i);
+      if (!pair_value->IsObject()) {
+        return env->ThrowTypeError(
+            "Header arrays must contain [name, value] pairs");
+      }
+      Local<Object> pair = pair_value.As<Object>();
+      if (!serializer.AddHeader(pair->Get(0), pair->Get(1)))
+        return;
+    }
+  } else {
+    Local<Array> keys = headers->GetOwnPropertyNames();
+    for (uint32_t i = 0, n = keys->Length(); i < n; i++) {
+      Local<Value> key = keys->Get(i);
+      if (!serializer.AddHeader(key, headers->Get(key)))
+        return;
+    }
+  }
+
+  flags[0] = serializer.flags();
+  args.GetReturnValue().Set(serializer.ToString());
+}
+
+
 void InitHttpParser(Handle<Object> target,
                     Handle<Value> unused,
                     Handle<Context> context,
                     void* priv) {
   Environment* env = Environment::GetCurrent(context);
+
+  static bool known_header_slots_initialized = false;
+  if (!known_header_slots_initialized) {
+    InitKnownHeaderSlots();
+    known_header_slots_initialized = true;
+  }
+
   Local<FunctionTemplate> t = env->NewFunctionTemplate(Parser::New);
   t->InstanceTemplate()->SetInternalFieldCount(1);
   t->SetClassName(FIXED_ONE_BYTE_STRING(env->isolate(), "HTTPParser"));
@@ -598,6 +992,14 @@ void InitHttpParser(Handle<Object> target,
 
   target->Set(FIXED_ONE_BYTE_STRING(env->isolate(), "HTTPParser"),
               t->GetFunction());
+
+  env->SetMethod(target, "serializeHeaders", SerializeHeaders);
+
+#define V(value, name)                                                        \
+  target->Set(FIXED_ONE_BYTE_STRING(env->isolate(), #name),                   \
+              Integer::NewFromUnsigned(env->isolate(), name));
+  HEADER_FLAGS(V)
+#undef V
 }
 
 }  // namespace node
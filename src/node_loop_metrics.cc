@@ -0,0 +1,214 @@
+#include "node.h"
+#include "env.h"
+#include "env-inl.h"
+#include "util.h"
+#include "util-inl.h"
+#include "uv.h"
+#include "v8.h"
+
+namespace node {
+namespace loop_metrics {
+
+using v8::Context;
+using v8::FunctionCallbackInfo;
+using v8::Handle;
+using v8::Integer;
+using v8::Local;
+using v8::Object;
+using v8::Value;
+using v8::kExternalFloat64Array;
+
+// Each iteration of the event loop is measured from one prepare callback to
+// the next.  The prepare callback runs right before the loop blocks for I/O,
+// the wait ends when the first callback into JS is made or, if there is
+// none, when the check callback runs.  I/O callbacks are the time from there
+// to the check callback, minus the immediates that ran in between.
+//
+// Immediates are timed separately by CheckImmediate().  libuv runs check
+// handles in the reverse order they were started, and the immediate handle
+// is started again whenever the immediate queue goes from empty to
+// non-empty.  So CheckImmediate() can run before or after our check
+// callback, and both orders have to be accounted for.
+//
+// The rest of the iteration (timers, close callbacks and deferred I/O
+// callbacks) is what remains once idle, I/O and immediate time are
+// subtracted.
+//
+// The histogram counts iterations by busy time, the iteration minus its wait
+// for I/O.  That is the longest an incoming event could have been delayed.
+// Buckets are log-linear: values below 16 us get a bucket each, larger values
+// are split into powers of two with 8 buckets each.  The relative error is at
+// most 12.5%, and everything from 2^36 us upward ends up in the last bucket.
+
+static const int kHistogramLinearBuckets = 16;
+static const int kHistogramSubBucketBits = 3;
+static const int kHistogramMaxExponent = 35;
+
+
+static int HistogramBucket(uint64_t value) {
+  if (value < kHistogramLinearBuckets)
+    return static_cast<int>(value);
+
+  int exponent = 4;
+  while (exponent < kHistogramMaxExponent && (value >> (exponent + 1)) != 0)
+    exponent++;
+
+  if ((value >> (exponent + 1)) != 0)
+    return Environment::LoopMetrics::kHistogramBuckets - 1;
+
+  const int shift = exponent - kHistogramSubBucketBits;
+  const int sub_bucket =
+      (value >> shift) & ((1 << kHistogramSubBucketBits) - 1);
+  return kHistogramLinearBuckets +
+         ((exponent - 4) << kHistogramSubBucketBits) +
+         sub_bucket;
+}
+
+}  // namespace loop_metrics
+
+
+// The times of an iteration are only added to the totals once it is
+// complete, so the totals always add up to kLoopTime.
+void Environment::LoopMetrics::OnPrepare(uint64_t now) {
+  if (prepare_time_ != 0) {
+    const uint64_t iteration = now - prepare_time_;
+    fields_[kIterations] += 1;
+    fields_[kLoopTime] += iteration;
+    fields_[kIdleTime] += idle_time_;
+    fields_[kIOTime] += io_time_;
+    fields_[kImmediateTime] += immediate_time_;
+
+    const uint64_t busy = iteration - idle_time_;
+    histogram_[loop_metrics::HistogramBucket(busy / 1000)] += 1;
+  }
+
+  prepare_time_ = now;
+  wake_time_ = 0;
+  idle_time_ = 0;
+  io_time_ = 0;
+  immediate_time_ = 0;
+  polling_ = true;
+}
+
+
+void Environment::LoopMetrics::OnCheck(uint64_t now) {
+  // Started halfway through an iteration.
+  if (prepare_time_ == 0)
+    return;
+
+  if (polling_) {
+    polling_ = false;
+    wake_time_ = now;
+  }
+
+  // Immediates that already ran in this check phase are not I/O time.  The
+  // ones that run after this callback only add to immediate_time_.
+  idle_time_ = wake_time_ - prepare_time_;
+  io_time_ = now - wake_time_ - immediate_time_;
+}
+
+
+// The immediate callback goes through OnCallback(), which records the wake
+// up a little after `start`.  Move it back so the immediate isn't partly
+// counted as idle time.
+void Environment::LoopMetrics::OnImmediate(uint64_t start, uint64_t end) {
+  if (prepare_time_ == 0)
+    return;
+  if (polling_ || wake_time_ > start) {
+    polling_ = false;
+    wake_time_ = start;
+  }
+  immediate_time_ += end - start;
+}
+
+
+namespace loop_metrics {
+
+static void OnPrepare(uv_prepare_t* handle) {
+  Environment* env = Environment::from_loop_metrics_prepare_handle(handle);
+  env->loop_metrics()->OnPrepare(uv_hrtime());
+}
+
+
+static void OnCheck(uv_check_t* handle) {
+  Environment* env = Environment::from_loop_metrics_check_handle(handle);
+  env->loop_metrics()->OnCheck(uv_hrtime());
+}
+
+
+void Setup(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  Environment::LoopMetrics* metrics = env->loop_metrics();
+
+  CHECK(args[0]->IsObject());
+  CHECK(args[1]->IsObject());
+
+  args[0].As<Object>()->SetIndexedPropertiesToExternalArrayData(
+      metrics->fields(),
+      kExternalFloat64Array,
+      metrics->fields_count());
+  args[1].As<Object>()->SetIndexedPropertiesToExternalArrayData(
+      metrics->histogram(),
+      kExternalFloat64Array,
+      metrics->histogram_count());
+}
+
+
+void Start(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  if (env->loop_metrics()->enabled())
+    return;
+  env->loop_metrics()->set_enabled(true);
+  uv_prepare_start(env->loop_metrics_prepare_handle(), OnPrepare);
+  uv_check_start(env->loop_metrics_check_handle(), OnCheck);
+}
+
+
+void Stop(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  env->loop_metrics()->set_enabled(false);
+  uv_prepare_stop(env->loop_metrics_prepare_handle());
+  uv_check_stop(env->loop_metrics_check_handle());
+}
+
+
+void Reset(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  env->loop_metrics()->Reset();
+}
+
+
+void Initialize(Handle<Object> target,
+                Handle<Value> unused,
+                Handle<Context> context) {
+  Environment* env = Environment::GetCurrent(context);
+
+  env->SetMethod(target, "setup", Setup);
+  env->SetMethod(target, "start", Start);
+  env->SetMethod(target, "stop", Stop);
+  env->SetMethod(target, "reset", Reset);
+
+#define V(name)                                                               \
+  target->Set(FIXED_ONE_BYTE_STRING(env->isolate(), #name),                   \
+              Integer::New(env->isolate(), Environment::LoopMetrics::name));
+  V(kIterations)
+  V(kLoopTime)
+  V(kIdleTime)
+  V(kIOTime)
+  V(kImmediateTime)
+  V(kFieldsCount)
+  V(kHistogramBuckets)
+#undef V
+
+#define V(name)                                                               \
+  target->Set(FIXED_ONE_BYTE_STRING(env->isolate(), #name),                   \
+              Integer::New(env->isolate(), name));
+  V(kHistogramLinearBuckets)
+  V(kHistogramSubBucketBits)
+#undef V
+}
+
+}  // namespace loop_metrics
+}  // namespace node
+
+NODE_MODULE_CONTEXT_AWARE_BUILTIN(loop_metrics, node::loop_metrics::Initialize)
@@ -0,0 +1,619 @@
+#include "node.h"
+#include "env.h"
+#include "env-inl.h"
+#include "util.h"
+#include "util-inl.h"
+#include "v8.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace node {
+namespace querystring {
+
+using v8::Array;
+using v8::Context;
+using v8::FunctionCallbackInfo;
+using v8::Handle;
+using v8::Isolate;
+using v8::Local;
+using v8::Object;
+using v8::String;
+using v8::Value;
+
+
+// Hex value of an ASCII code unit, -1 if it is not a hex digit.
+static const int8_t unhex_table[256] = {
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  0, 1, 2, 3, 4, 5, 6, 7, 8, 9, -1, -1, -1, -1, -1, -1,
+  -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+
+
+// Characters that QueryString.escape() passes through unchanged:
+// A-Z a-z 0-9 ! - . _ ~ ' ( ) *
+static const uint8_t unreserved_table[128] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 1, 0, 0, 0, 0, 0, 1, 1, 1, 1, 0, 0, 1, 1, 0,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0,
+  0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 1,
+  0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 1, 0
+};
+
+
+template <typename TypeName>
+static inline int Unhex(TypeName c) {
+  return static_cast<uint32_t>(c) < 256 ? unhex_table[c] : -1;
+}
+
+
+// Scratch memory that lives on the stack for short inputs and on the heap
+// for everything else.
+template <typename TypeName, size_t kStackSize = 1024>
+class ScratchBuffer {
+ public:
+  explicit ScratchBuffer(size_t size) : data_(stack_) {
+    if (size > kStackSize) {
+      data_ = static_cast<TypeName*>(malloc(size * sizeof(*data_)));
+      CHECK_NE(data_, nullptr);
+    }
+  }
+
+  ~ScratchBuffer() {
+    if (data_ != stack_)
+      free(data_);
+  }
+
+  TypeName* operator*() {
+    return data_;
+  }
+
+ private:
+  TypeName* data_;
+  TypeName stack_[kStackSize];
+
+  DISALLOW_COPY_AND_ASSIGN(ScratchBuffer);
+};
+
+
+// Byte-for-byte port of the state machine in QueryString.unescapeBuffer(),
+// including the way a malformed escape is copied through together with the
+// character that broke it.
+class ByteUnescaper {
+ public:
+  explicit ByteUnescaper(char* out) : out_(out), pos_(0), state_(kChar) {}
+
+  void Push(uint32_t c) {
+    switch (state_) {
+      case kChar:
+        if (c == '%') {
+          state_ = kHex0;
+        } else {
+          out_[pos_++] = static_cast<char>(c);
+        }
+        break;
+
+      case kHex0:
+        state_ = kHex1;
+        hexchar_ = c;
+        high_ = Unhex(c);
+        if (high_ < 0) {
+          out_[pos_++] = '%';
+          out_[pos_++] = static_cast<char>(c);
+          state_ = kChar;
+        }
+        break;
+
+      case kHex1: {
+        state_ = kChar;
+        int low = Unhex(c);
+        if (low < 0) {
+          out_[pos_++] = '%';
+          out_[pos_++] = static_cast<char>(hexchar_);
+          out_[pos_++] = static_cast<char>(c);
+          break;
+        }
+        out_[pos_++] = static_cast<char>(high_ * 16 + low);
+        break;
+      }
+    }
+  }
+
+  size_t Finish() {
+    if (state_ == kHex0) {
+      out_[pos_++] = '%';
+    } else if (state_ == kHex1) {
+      out_[pos_++] = '%';
+      out_[pos_++] = static_cast<char>(hexchar_);
+    }
+    state_ = kChar;
+    return pos_;
+  }
+
+ private:
+  enum State { kChar, kHex0, kHex1 };
+  char* out_;
+  size_t pos_;
+  State state_;
+  uint32_t hexchar_;
+  int high_;
+};
+
+
+// Decodes |src| like decodeURIComponent() would after every '+' has been
+// replaced with "%20".  Returns false where decodeURIComponent() would throw.
+template <typename TypeName>
+static bool DecodeURIComponent(uint16_t* dst,
+                               size_t* written,
+                               const TypeName* src,
+                               size_t len) {
+  size_t n = 0;
+
+  for (size_t k = 0; k < len; k++) {
+    uint32_t c = src[k];
+    if (c == '+') {
+      dst[n++] = ' ';
+      continue;
+    }
+    if (c != '%') {
+      dst[n++] = static_cast<uint16_t>(c);
+      continue;
+    }
+
+    if (k + 2 >= len)
+      return false;
+    int high = Unhex(src[k + 1]);
+    int low = Unhex(src[k + 2]);
+    if (high < 0 || low < 0)
+      return false;
+    uint32_t b = (high << 4) | low;
+    k += 2;
+
+    if (b < 0x80) {
+      dst[n++] = static_cast<uint16_t>(b);
+      continue;
+    }
+
+    size_t trail;
+    uint32_t value;
+    uint32_t min;
+    if (b >= 0xC2 && b <= 0xDF) {
+      trail = 1;
+      value = b & 0x1F;
+      min = 0x80;
+    } else if (b >= 0xE0 && b <= 0xEF) {
+      trail = 2;
+      value = b & 0x0F;
+      min = 0x800;
+    } else if (b >= 0xF0 && b <= 0xF7) {
+      trail = 3;
+      value = b & 0x07;
+      min = 0x10000;
+    } else {
+      return false;
+    }
+
+    if (k + 3 * trail >= len)
+      return false;
+
+    for (size_t i = 0; i < trail; i++, k += 3) {
+      if (src[k + 1] != '%')
+        return false;
+      high = Unhex(src[k + 2]);
+      low = Unhex(src[k + 3]);
+      if (high < 0 || low < 0)
+        return false;
+      b = (high << 4) | low;
+      if ((b & 0xC0) != 0x80)
+        return false;
+      value = (value << 6) | (b & 0x3F);
+    }
+
+    if (value < min || value > 0x10FFFF)
+      return false;
+    if (value >= 0xD800 && value <= 0xDFFF)
+      return false;
+
+    if (value < 0x10000) {
+      dst[n++] = static_cast<uint16_t>(value);
+    } else {
+      dst[n++] = static_cast<uint16_t>((value >> 10) + 0xD7C0);
+      dst[n++] = static_cast<uint16_t>((value & 0x3FF) + 0xDC00);
+    }
+  }
+
+  *written = n;
+  return true;
+}
+
+
+// Slow path for input that decodeURIComponent() rejects: percent-decode
+// leniently to bytes, then read those bytes back as UTF-8.
+template <typename TypeName>
+static size_t UnescapeBytes(char* dst, const TypeName* src, size_t len) {
+  ByteUnescaper unescaper(dst);
+
+  for (size_t k = 0; k < len; k++) {
+    if (src[k] == '+') {
+      unescaper.Push('%');
+      unescaper.Push('2');
+      unescaper.Push('0');
+    } else {
+      unescaper.Push(src[k]);
+    }
+  }
+
+  return unescaper.Finish();
+}
+
+
+static inline Local<String> NewString(Isolate* isolate,
+                                      const uint8_t* data,
+                                      size_t length) {
+  return String::NewFromOneByte(isolate,
+                                data,
+                                String::kNormalString,
+                                length);
+}
+
+
+static inline Local<String> NewString(Isolate* isolate,
+                                      const uint16_t* data,
+                                      size_t length) {
+  return String::NewFromTwoByte(isolate,
+                                data,
+                                String::kNormalString,
+                                length);
+}
+
+
+// |units| must have room for |len| code units and |bytes| for 3 * |len|.
+template <typename TypeName>
+static Local<String> DecodeComponent(Isolate* isolate,
+                                     const TypeName* src,
+                                     size_t len,
+                                     uint16_t* units,
+                                     char* bytes) {
+  size_t k;
+  for (k = 0; k < len; k++) {
+    if (src[k] == '%' || src[k] == '+')
+      break;
+  }
+
+  // Nothing to decode, copy the slice straight into a new string.
+  if (k == len)
+    return NewString(isolate, src, len);
+
+  size_t written;
+  if (DecodeURIComponent(units, &written, src, len))
+    return NewString(isolate, units, written);
+
+  written = UnescapeBytes(bytes, src, len);
+  return String::NewFromUtf8(isolate,
+                             bytes,
+                             String::kNormalString,
+                             written);
+}
+
+
+template <typename TypeName>
+static inline size_t Find(const TypeName* haystack,
+                          size_t start,
+                          size_t end,
+                          const uint16_t* needle,
+                          size_t needle_len) {
+  if (needle_len > end - start)
+    return end;
+
+  const size_t last = end - needle_len;
+  for (size_t i = start; i <= last; i++) {
+    if (haystack[i] != needle[0])
+      continue;
+    size_t j = 1;
+    while (j < needle_len && haystack[i + j] == needle[j])
+      j++;
+    if (j == needle_len)
+      return i;
+  }
+
+  return end;
+}
+
+
+// True when |eq| could be found at a different place once every '+' has
+// been replaced with "%20", i.e. when it contains one of those characters.
+static bool EqSeesEscapedPlus(const uint16_t* eq, size_t eq_len) {
+  for (size_t i = 0; i < eq_len; i++) {
+    if (eq[i] == '+' || eq[i] == '%' || eq[i] == '2' || eq[i] == '0')
+      return true;
+  }
+  return false;
+}
+
+
+// Copies |src| with every '+' replaced with "%20".  |dst| must have room for
+// 3 * |len| code units.
+template <typename TypeName>
+static size_t EscapePlus(uint16_t* dst, const TypeName* src, size_t len) {
+  size_t n = 0;
+  for (size_t k = 0; k < len; k++) {
+    if (src[k] == '+') {
+      dst[n++] = '%';
+      dst[n++] = '2';
+      dst[n++] = '0';
+    } else {
+      dst[n++] = src[k];
+    }
+  }
+  return n;
+}
+
+
+// Splits the part between |start| and |end| into key and value, the same
+// way the JS implementation does: '+' is replaced before |eq| is searched
+// for and the value starts one character after the match, whatever the
+// length of |eq|.
+template <typename TypeName>
+static void ParsePart(Isolate* isolate,
+                      const TypeName* src,
+                      size_t start,
+                      size_t end,
+                      const uint16_t* eq,
+                      size_t eq_len,
+                      uint16_t* units,
+                      char* bytes,
+                      Local<String>* key,
+                      Local<String>* value) {
+  const size_t mid = Find(src, start, end, eq, eq_len);
+  *key = DecodeComponent(isolate, src + start, mid - start, units, bytes);
+  if (mid < end) {
+    *value = DecodeComponent(isolate,
+                             src + mid + 1,
+                             end - mid - 1,
+                             units,
+                             bytes);
+  } else {
+    *value = String::Empty(isolate);
+  }
+}
+
+
+template <typename TypeName>
+static Local<Array> ParseImpl(Isolate* isolate,
+                              const TypeName* src,
+                              size_t len,
+                              const uint16_t* sep,
+                              size_t sep_len,
+                              const uint16_t* eq,
+                              size_t eq_len,
+                              size_t max_keys) {
+  // Searching the unescaped input gives the same result, and saves a copy,
+  // unless |eq| could match inside a "%20".
+  const bool escape_plus = EqSeesEscapedPlus(eq, eq_len);
+  const size_t max_part_len = escape_plus ? 3 * len : len;
+  ScratchBuffer<uint16_t> escaped(escape_plus ? max_part_len : 0);
+  ScratchBuffer<uint16_t> units(max_part_len);
+  ScratchBuffer<char> bytes(3 * max_part_len);
+  Local<Array> pairs = Array::New(isolate);
+  uint32_t index = 0;
+  size_t start = 0;
+
+  for (size_t count = 0; max_keys == 0 || count < max_keys; count++) {
+    size_t end = Find(src, start, len, sep, sep_len);
+    Local<String> key;
+    Local<String> value;
+
+    if (escape_plus) {
+      size_t part_len = EscapePlus(*escaped, src + start, end - start);
+      ParsePart(isolate,
+                static_cast<const uint16_t*>(*escaped),
+                0,
+                part_len,
+                eq,
+                eq_len,
+                *units,
+                *bytes,
+                &key,
+                &value);
+    } else {
+      ParsePart(isolate,
+                src,
+                start,
+                end,
+                eq,
+                eq_len,
+                *units,
+                *bytes,
+                &key,
+                &value);
+    }
+
+    pairs->Set(index++, key);
+    pairs->Set(index++, value);
+
+    if (end == len)
+      break;
+    start = end + sep_len;
+  }
+
+  return pairs;
+}
+
+
+// parse(qs, sep, eq, maxKeys)
+//
+// Splits |qs| on |sep|, then every part on the first |eq|, and decodes both
+// halves.  Returns the result as a flat [key, value, key, value, ...] array.
+// At most |maxKeys| parts are looked at; zero means no limit.
+static void Parse(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+
+  CHECK(args[0]->IsString());
+  CHECK(args[1]->IsString());
+  CHECK(args[2]->IsString());
+
+  Local<String> qs = args[0].As<String>();
+  String::Value sep(args[1]);
+  String::Value eq(args[2]);
+  CHECK_GT(sep.length(), 0);
+  CHECK_GT(eq.length(), 0);
+
+  size_t max_keys = 0;
+  double max_keys_arg = args[3]->NumberValue();
+  if (max_keys_arg > 0 && max_keys_arg < static_cast<double>(UINT32_MAX))
+    max_keys = static_cast<size_t>(ceil(max_keys_arg));
+
+  const size_t len = qs->Length();
+  Local<Array> pairs;
+
+  if (qs->IsOneByte()) {
+    ScratchBuffer<uint8_t> src(len);
+    qs->WriteOneByte(*src, 0, len, String::NO_NULL_TERMINATION);
+    pairs = ParseImpl(env->isolate(),
+                      static_cast<const uint8_t*>(*src),
+                      len,
+                      *sep,
+                      sep.length(),
+                      *eq,
+                      eq.length(),
+                      max_keys);
+  } else {
+    ScratchBuffer<uint16_t> src(len);
+    qs->Write(*src, 0, len, String::NO_NULL_TERMINATION);
+    pairs = ParseImpl(env->isolate(),
+                      static_cast<const uint16_t*>(*src),
+                      len,
+                      *sep,
+                      sep.length(),
+                      *eq,
+                      eq.length(),
+                      max_keys);
+  }
+
+  args.GetReturnValue().Set(pairs);
+}
+
+
+static inline char* WriteHex(char* dst, uint32_t byte) {
+  static const char hex[] = "0123456789ABCDEF";
+  *dst++ = '%';
+  *dst++ = hex[(byte >> 4) & 0xF];
+  *dst++ = hex[byte & 0xF];
+  return dst;
+}
+
+
+// Mirrors the JS implementation that used to live in QueryString.escape(),
+// down to how it treats unpaired surrogates.  |dst| must have room for
+// 9 * |len| bytes.
+template <typename TypeName>
+static size_t EscapeImpl(char* dst, const TypeName* src, size_t len) {
+  char* const start = dst;
+
+  for (size_t i = 0; i < len; i++) {
+    uint32_t c = src[i];
+
+    if (c < 0x80) {
+      if (unreserved_table[c])
+        *dst++ = static_cast<char>(c);
+      else
+        dst = WriteHex(dst, c);
+      continue;
+    }
+
+    if (c < 0x800) {
+      dst = WriteHex(dst, 0xC0 | (c >> 6));
+      dst = WriteHex(dst, 0x80 | (c & 0x3F));
+      continue;
+    }
+
+    if (c < 0xD800 || c >= 0xE000) {
+      dst = WriteHex(dst, 0xE0 | (c >> 12));
+      dst = WriteHex(dst, 0x80 | ((c >> 6) & 0x3F));
+      dst = WriteHex(dst, 0x80 | (c & 0x3F));
+      continue;
+    }
+
+    // Surrogate pair.  A missing trail surrogate reads as zero, exactly like
+    // the NaN that charCodeAt() returns past the end of the string.
+    uint32_t trail = ++i < len ? src[i] : 0;
+    c = 0x10000 + (((c & 0x3FF) << 10) | (trail & 0x3FF));
+    dst = WriteHex(dst, 0xF0 | (c >> 18));
+    dst = WriteHex(dst, 0x80 | ((c >> 12) & 0x3F));
+    dst = WriteHex(dst, 0x80 | ((c >> 6) & 0x3F));
+    dst = WriteHex(dst, 0x80 | (c & 0x3F));
+  }
+
+  return dst - start;
+}
+
+
+template <typename TypeName>
+static bool NeedsEscape(const TypeName* src, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    if (src[i] >= 0x80 || !unreserved_table[src[i]])
+      return true;
+  }
+  return false;
+}
+
+
+// escape(str)
+//
+// Percent-encodes |str| the way QueryString.escape() is documented to.
+// Returns |str| itself when there is nothing to encode.
+static void Escape(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+
+  CHECK(args[0]->IsString());
+
+  Local<String> str = args[0].As<String>();
+  const size_t len = str->Length();
+
+  if (str->IsOneByte()) {
+    ScratchBuffer<uint8_t> src(len);
+    str->WriteOneByte(*src, 0, len, String::NO_NULL_TERMINATION);
+    if (!NeedsEscape(*src, len))
+      return args.GetReturnValue().Set(str);
+    ScratchBuffer<char> out(9 * len);
+    size_t written =
+        EscapeImpl(*out, static_cast<const uint8_t*>(*src), len);
+    args.GetReturnValue().Set(OneByteString(env->isolate(), *out, written));
+  } else {
+    String::Value src(str);
+    ScratchBuffer<char> out(9 * len);
+    size_t written = EscapeImpl(*out, *src, len);
+    args.GetReturnValue().Set(OneByteString(env->isolate(), *out, written));
+  }
+}
+
+
+void Initialize(Handle<Object> target,
+                Handle<Value> unused,
+                Handle<Context> context) {
+  Environment* env = Environment::GetCurrent(context);
+  env->SetMethod(target, "parse", Parse);
+  env->SetMethod(target, "escape", Escape);
+}
+
+}  // namespace querystring
+}  // namespace node
+
+NODE_MODULE_CONTEXT_AWARE_BUILTIN(querystring, node::querystring::Initialize)
@@ -15,6 +15,8 @@ class StatWatcher : public AsyncWrap {
 
   static void Initialize(Environment* env, v8::Handle<v8::Object> target);
 
+  size_t self_size() const override { return sizeof(*this); }
+
  protected:
   StatWatcher(Environment* env, v8::Local<v8::Object> wrap);
 
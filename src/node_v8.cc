@@ -1,21 +1,45 @@
 #include "node.h"
 #include "env.h"
 #include "env-inl.h"
+#include "smalloc.h"
 #include "util.h"
 #include "util-inl.h"
 #include "v8.h"
+#include "v8-profiler.h"
+
+#include <errno.h>
+#include <string.h>
+#include <vector>
+
+#ifdef _WIN32
+# include <io.h>
+#else
+# include <unistd.h>
+#endif
 
 namespace node {
 
+using v8::Array;
 using v8::Context;
+using v8::CpuProfile;
+using v8::CpuProfileNode;
+using v8::CpuProfiler;
 using v8::ExternalArrayType;
 using v8::Function;
 using v8::FunctionCallbackInfo;
+using v8::GCCallbackFlags;
+using v8::GCType;
 using v8::Handle;
+using v8::HeapProfiler;
+using v8::HeapSnapshot;
 using v8::HeapStatistics;
+using v8::Integer;
 using v8::Isolate;
 using v8::Local;
+using v8::Number;
 using v8::Object;
+using v8::OutputStream;
+using v8::Persistent;
 using v8::String;
 using v8::Uint32;
 using v8::V8;
@@ -59,6 +83,524 @@ void GetHeapStatistics(const FunctionCallbackInfo<Value>& args) {
 }
 
 
+void GetIdleGCStatistics(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  CHECK(args.Length() == 1 && args[0]->IsObject());
+
+  Local<Object> obj = args[0].As<Object>();
+  double* data =
+      static_cast<double*>(obj->GetIndexedPropertiesExternalArrayData());
+
+  CHECK_NE(data, nullptr);
+  ASSERT_EQ(obj->GetIndexedPropertiesExternalArrayDataType(),
+            v8::kExternalFloat64Array);
+  ASSERT_EQ(obj->GetIndexedPropertiesExternalArrayDataLength(),
+            Environment::kIdleGCFieldsCount);
+
+  const double* fields = env->idle_gc_fields();
+  for (int i = 0; i < Environment::kIdleGCFieldsCount; i++)
+    data[i] = fields[i];
+}
+
+
+#define GC_EVENT_FIELDS(V)                                                    \
+  V(0, type, kGCEventTypeIndex)                                               \
+  V(1, flags, kGCEventFlagsIndex)                                             \
+  V(2, start, kGCEventStartIndex)                                             \
+  V(3, duration, kGCEventDurationIndex)                                       \
+  V(4, used_heap_size_before, kGCEventUsedBeforeIndex)                        \
+  V(5, used_heap_size_after, kGCEventUsedAfterIndex)                          \
+  V(6, total_heap_size_before, kGCEventTotalBeforeIndex)                      \
+  V(7, total_heap_size_after, kGCEventTotalAfterIndex)
+
+#define V(a, b, c) +1
+static const size_t kGCEventFieldsCount = GC_EVENT_FIELDS(V);
+#undef V
+
+enum GCEventField {
+#define V(i, _, name) name = i,
+  GC_EVENT_FIELDS(V)
+#undef V
+};
+
+// Records every garbage collection into a ring buffer that lib/v8.js
+// allocates and drains.  The first element of the buffer counts the events
+// recorded so far, event n is stored at 1 + (n % capacity) * fields.  Times
+// are milliseconds on the uv_hrtime() clock, like process.hrtime().
+//
+// The GC callbacks don't get a context, only the isolate, so the trackers
+// are kept in a list keyed by isolate.  A tracker that is still running
+// when its environment goes away is stopped by a cleanup hook.
+class GCTracker {
+ public:
+  static void Start(Environment* env, Local<Object> buffer, size_t capacity);
+  static void Stop(Isolate* isolate);
+
+ private:
+  GCTracker(Environment* env, Local<Object> buffer, size_t capacity);
+  ~GCTracker();
+
+  static GCTracker* Find(Isolate* isolate);
+  static void OnEnvironmentCleanup(void* arg);
+  static void Prologue(Isolate* isolate, GCType type, GCCallbackFlags flags);
+  static void Epilogue(Isolate* isolate, GCType type, GCCallbackFlags flags);
+
+  static GCTracker* trackers_;
+
+  Isolate* const isolate_;
+  Persistent<Object> buffer_;
+  double* const data_;
+  const size_t capacity_;
+  uint64_t start_;
+  HeapStatistics before_;
+  GCTracker* next_;
+  Environment::CleanupHook cleanup_hook_;
+};
+
+GCTracker* GCTracker::trackers_;
+
+
+GCTracker::GCTracker(Environment* env,
+                     Local<Object> buffer,
+                     size_t capacity)
+    : isolate_(env->isolate()),
+      buffer_(env->isolate(), buffer),
+      data_(static_cast<double*>(
+          buffer->GetIndexedPropertiesExternalArrayData())),
+      capacity_(capacity),
+      start_(0),
+      next_(trackers_),
+      cleanup_hook_(OnEnvironmentCleanup, this) {
+  trackers_ = this;
+  env->AddCleanupHook(&cleanup_hook_);
+}
+
+
+GCTracker::~GCTracker() {
+  buffer_.Reset();
+  GCTracker** p = &trackers_;
+  while (*p != this)
+    p = &(*p)->next_;
+  *p = next_;
+}
+
+
+GCTracker* GCTracker::Find(Isolate* isolate) {
+  GCTracker* tracker = trackers_;
+  while (tracker != nullptr && tracker->isolate_ != isolate)
+    tracker = tracker->next_;
+  return tracker;
+}
+
+
+void GCTracker::OnEnvironmentCleanup(void* arg) {
+  Stop(static_cast<GCTracker*>(arg)->isolate_);
+}
+
+
+void GCTracker::Start(Environment* env,
+                      Local<Object> buffer,
+                      size_t capacity) {
+  Isolate* isolate = env->isolate();
+  Stop(isolate);
+  new GCTracker(env, buffer, capacity);
+  isolate->AddGCPrologueCallback(Prologue);
+  isolate->AddGCEpilogueCallback(Epilogue);
+}
+
+
+void GCTracker::Stop(Isolate* isolate) {
+  GCTracker* tracker = Find(isolate);
+  if (tracker == nullptr)
+    return;
+  isolate->RemoveGCPrologueCallback(Prologue);
+  isolate->RemoveGCEpilogueCallback(Epilogue);
+  delete tracker;
+}
+
+
+void GCTracker::Prologue(Isolate* isolate,
+                         GCType type,
+                         GCCallbackFlags flags) {
+  GCTracker* tracker = Find(isolate);
+  if (tracker == nullptr)
+    return;
+  isolate->GetHeapStatistics(&tracker->before_);
+  tracker->start_ = uv_hrtime();
+}
+
+
+void GCTracker::Epilogue(Isolate* isolate,
+                         GCType type,
+                         GCCallbackFlags flags) {
+  const uint64_t end = uv_hrtime();
+  GCTracker* tracker = Find(isolate);
+  if (tracker == nullptr || tracker->start_ == 0)
+    return;
+
+  HeapStatistics after;
+  isolate->GetHeapStatistics(&after);
+
+  const double count = tracker->data_[0];
+  const size_t slot = static_cast<uint64_t>(count) % tracker->capacity_;
+  double* event = tracker->data_ + 1 + slot * kGCEventFieldsCount;
+  event[kGCEventTypeIndex] = type;
+  event[kGCEventFlagsIndex] = flags;
+  event[kGCEventStartIndex] = tracker->start_ / 1e6;
+  event[kGCEventDurationIndex] = (end - tracker->start_) / 1e6;
+  event[kGCEventUsedBeforeIndex] = tracker->before_.used_heap_size();
+  event[kGCEventUsedAfterIndex] = after.used_heap_size();
+  event[kGCEventTotalBeforeIndex] = tracker->before_.total_heap_size();
+  event[kGCEventTotalAfterIndex] = after.total_heap_size();
+  tracker->data_[0] = count + 1;
+  tracker->start_ = 0;
+}
+
+
+void StartGCTracking(const FunctionCallbackInfo<Value>& args) {
+  CHECK(args.Length() == 2 && args[0]->IsObject() && args[1]->IsUint32());
+
+  Local<Object> obj = args[0].As<Object>();
+  const size_t capacity = args[1]->Uint32Value();
+
+  CHECK_GT(capacity, 0);
+  CHECK_NE(obj->GetIndexedPropertiesExternalArrayData(), nullptr);
+  ASSERT_EQ(obj->GetIndexedPropertiesExternalArrayDataType(),
+            v8::kExternalFloat64Array);
+  CHECK_EQ(static_cast<size_t>(
+               obj->GetIndexedPropertiesExternalArrayDataLength()),
+           1 + capacity * kGCEventFieldsCount);
+
+  GCTracker::Start(Environment::GetCurrent(args), obj, capacity);
+}
+
+
+void StopGCTracking(const FunctionCallbackInfo<Value>& args) {
+  GCTracker::Stop(args.GetIsolate());
+}
+
+
+#define CPU_PROFILE_NODE_FIELDS(V)                                            \
+  V(0, id, kCpuProfileNodeIdIndex)                                            \
+  V(1, scriptId, kCpuProfileNodeScriptIdIndex)                                \
+  V(2, lineNumber, kCpuProfileNodeLineIndex)                                  \
+  V(3, columnNumber, kCpuProfileNodeColumnIndex)                              \
+  V(4, hitCount, kCpuProfileNodeHitCountIndex)                                \
+  V(5, callUID, kCpuProfileNodeCallUidIndex)                                  \
+  V(6, childCount, kCpuProfileNodeChildCountIndex)
+
+#define V(a, b, c) +1
+static const size_t kCpuProfileNodeFieldsCount = CPU_PROFILE_NODE_FIELDS(V);
+#undef V
+
+enum CpuProfileNodeField {
+#define V(i, _, name) name = i,
+  CPU_PROFILE_NODE_FIELDS(V)
+#undef V
+};
+
+
+static Local<Object> NewFloat64Array(Environment* env,
+                                     const std::vector<double>& values) {
+  Local<Object> obj = Object::New(env->isolate());
+  const size_t byte_length = values.size() * sizeof(values[0]);
+  if (byte_length == 0) {
+    smalloc::Alloc(env, obj, nullptr, 0, v8::kExternalFloat64Array);
+    return obj;
+  }
+  char* data = static_cast<char*>(malloc(byte_length));
+  CHECK_NE(data, nullptr);
+  memcpy(data, &values[0], byte_length);
+  smalloc::Alloc(env, obj, data, byte_length, v8::kExternalFloat64Array);
+  return obj;
+}
+
+
+void StartCpuProfiling(const FunctionCallbackInfo<Value>& args) {
+  CHECK(args[0]->IsString());
+  CHECK(args[1]->IsUint32());
+
+  CpuProfiler* profiler = args.GetIsolate()->GetCpuProfiler();
+  // Only takes effect while no profile is being recorded, lib/v8.js makes
+  // sure of that.
+  profiler->SetSamplingInterval(args[1]->Uint32Value());
+  profiler->StartProfiling(args[0].As<String>(), args[2]->IsTrue());
+}
+
+
+// Stops the profile and copies it out of V8 in one pass, so the profile can
+// be deleted right away.  The call tree is flattened in pre-order: numbers
+// go into a Float64 array with kCpuProfileNodeFieldsCount fields per node,
+// strings into one array per field.  lib/internal/cpu_profile.js rebuilds
+// the tree from the child counts.
+void StopCpuProfiling(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  CHECK(args[0]->IsString());
+
+  CpuProfiler* profiler = env->isolate()->GetCpuProfiler();
+  CpuProfile* profile = profiler->StopProfiling(args[0].As<String>());
+  if (profile == nullptr)
+    return;
+
+  Local<Array> names = Array::New(env->isolate());
+  Local<Array> urls = Array::New(env->isolate());
+  Local<Array> bailouts = Array::New(env->isolate());
+  std::vector<double> fields;
+
+  std::vector<const CpuProfileNode*> stack;
+  stack.push_back(profile->GetTopDownRoot());
+  for (uint32_t i = 0; !stack.empty(); i++) {
+    const CpuProfileNode* node = stack.back();
+    stack.pop_back();
+
+    const int child_count = node->GetChildrenCount();
+    for (int k = child_count - 1; k >= 0; k--)
+      stack.push_back(node->GetChild(k));
+
+    fields.resize(fields.size() + kCpuProfileNodeFieldsCount);
+    double* f = &fields[fields.size() - kCpuProfileNodeFieldsCount];
+    f[kCpuProfileNodeIdIndex] = node->GetNodeId();
+    f[kCpuProfileNodeScriptIdIndex] = node->GetScriptId();
+    f[kCpuProfileNodeLineIndex] = node->GetLineNumber();
+    f[kCpuProfileNodeColumnIndex] = node->GetColumnNumber();
+    f[kCpuProfileNodeHitCountIndex] = node->GetHitCount();
+    f[kCpuProfileNodeCallUidIndex] = node->GetCallUid();
+    f[kCpuProfileNodeChildCountIndex] = child_count;
+
+    names->Set(i, node->GetFunctionName());
+    urls->Set(i, node->GetScriptResourceName());
+    bailouts->Set(i, OneByteString(env->isolate(), node->GetBailoutReason()));
+  }
+
+  const int sample_count = profile->GetSamplesCount();
+  std::vector<double> samples(sample_count);
+  std::vector<double> timestamps(sample_count);
+  for (int i = 0; i < sample_count; i++) {
+    samples[i] = profile->GetSample(i)->GetNodeId();
+    timestamps[i] = static_cast<double>(profile->GetSampleTimestamp(i));
+  }
+
+  Local<Object> result = Object::New(env->isolate());
+  result->Set(env->title_string(), profile->GetTitle());
+  result->Set(FIXED_ONE_BYTE_STRING(env->isolate(), "startTime"),
+              Number::New(env->isolate(),
+                          static_cast<double>(profile->GetStartTime())));
+  result->Set(FIXED_ONE_BYTE_STRING(env->isolate(), "endTime"),
+              Number::New(env->isolate(),
+                          static_cast<double>(profile->GetEndTime())));
+  result->Set(FIXED_ONE_BYTE_STRING(env->isolate(), "nodes"),
+              NewFloat64Array(env, fields));
+  result->Set(FIXED_ONE_BYTE_STRING(env->isolate(), "names"), names);
+  result->Set(FIXED_ONE_BYTE_STRING(env->isolate(), "urls"), urls);
+  result->Set(FIXED_ONE_BYTE_STRING(env->isolate(), "bailouts"), bailouts);
+  result->Set(FIXED_ONE_BYTE_STRING(env->isolate(), "sampleCount"),
+              Integer::New(env->isolate(), sample_count));
+  result->Set(FIXED_ONE_BYTE_STRING(env->isolate(), "samples"),
+              NewFloat64Array(env, samples));
+  result->Set(FIXED_ONE_BYTE_STRING(env->isolate(), "timestamps"),
+              NewFloat64Array(env, timestamps));
+
+  profile->Delete();
+  args.GetReturnValue().Set(result);
+}
+
+
+// Serializes a heap snapshot straight into a file descriptor.  V8 produces
+// the JSON in small chunks on the main thread; they are collected into
+// buffers that a writer thread flushes to the file while serialization goes
+// on.  At most kHeapSnapshotBuffers buffers exist at any time, so memory use
+// does not depend on the size of the heap.
+static const size_t kHeapSnapshotBufferSize = 1024 * 1024;
+static const size_t kHeapSnapshotBuffers = 4;
+static const int kHeapSnapshotChunkSize = 64 * 1024;
+
+class HeapSnapshotWriter : public OutputStream {
+ public:
+  explicit HeapSnapshotWriter(int fd);
+  ~HeapSnapshotWriter();
+
+  // Both return 0 or a libuv error code.
+  int Start();
+  int Finish();
+
+  int GetChunkSize() override { return kHeapSnapshotChunkSize; }
+  WriteResult WriteAsciiChunk(char* data, int size) override;
+  void EndOfStream() override;
+
+ private:
+  struct Buffer {
+    char* data;
+    size_t length;
+  };
+
+  static void Run(void* arg);
+  static int WriteAll(int fd, const char* data, size_t length);
+  bool Flush();
+
+  const int fd_;
+  uv_thread_t thread_;
+  uv_mutex_t mutex_;
+  uv_cond_t cond_;
+  Buffer buffers_[kHeapSnapshotBuffers];
+  // Buffers head_ to head_ + queued_ - 1 wait for the writer thread, the
+  // buffer after them is filled by the main thread.  fill_ is the main
+  // thread's copy of its index, everything else is guarded by mutex_.
+  size_t head_;
+  size_t queued_;
+  size_t fill_;
+  bool done_;
+  int error_;
+};
+
+
+HeapSnapshotWriter::HeapSnapshotWriter(int fd)
+    : fd_(fd), head_(0), queued_(0), fill_(0), done_(false), error_(0) {
+  for (size_t i = 0; i < kHeapSnapshotBuffers; i++) {
+    buffers_[i].data = new char[kHeapSnapshotBufferSize];
+    buffers_[i].length = 0;
+  }
+  CHECK_EQ(0, uv_mutex_init(&mutex_));
+  CHECK_EQ(0, uv_cond_init(&cond_));
+}
+
+
+HeapSnapshotWriter::~HeapSnapshotWriter() {
+  uv_cond_destroy(&cond_);
+  uv_mutex_destroy(&mutex_);
+  for (size_t i = 0; i < kHeapSnapshotBuffers; i++)
+    delete[] buffers_[i].data;
+}
+
+
+int HeapSnapshotWriter::Start() {
+  return uv_thread_create(&thread_, Run, this);
+}
+
+
+// Serialize() does not call EndOfStream() after a failed write, so this is
+// what tells the writer thread to stop.
+int HeapSnapshotWriter::Finish() {
+  uv_mutex_lock(&mutex_);
+  done_ = true;
+  uv_cond_signal(&cond_);
+  uv_mutex_unlock(&mutex_);
+  CHECK_EQ(0, uv_thread_join(&thread_));
+  return error_;
+}
+
+
+// Runs on the writer thread, where uv_fs_write() can't be used.
+int HeapSnapshotWriter::WriteAll(int fd, const char* data, size_t length) {
+  while (length > 0) {
+#ifdef _WIN32
+    const int written = _write(fd, data, static_cast<unsigned int>(length));
+    if (written < 0)
+      return errno == ENOSPC ? UV_ENOSPC : UV_EIO;
+#else
+    const ssize_t written = write(fd, data, length);
+    if (written < 0 && errno == EINTR)
+      continue;
+    if (written < 0)
+      return -errno;
+#endif
+    data += written;
+    length -= written;
+  }
+  return 0;
+}
+
+
+void HeapSnapshotWriter::Run(void* arg) {
+  HeapSnapshotWriter* writer = static_cast<HeapSnapshotWriter*>(arg);
+
+  uv_mutex_lock(&writer->mutex_);
+  for (;;) {
+    while (writer->queued_ == 0 && !writer->done_)
+      uv_cond_wait(&writer->cond_, &writer->mutex_);
+    if (writer->queued_ == 0)
+      break;
+
+    Buffer* buffer = &writer->buffers_[writer->head_];
+    const bool failed = writer->error_ != 0;
+    uv_mutex_unlock(&writer->mutex_);
+
+    // After an error the remaining buffers are only drained.
+    const int err =
+        failed ? 0 : WriteAll(writer->fd_, buffer->data, buffer->length);
+
+    uv_mutex_lock(&writer->mutex_);
+    if (err != 0)
+      writer->error_ = err;
+    buffer->length = 0;
+    writer->head_ = (writer->head_ + 1) % kHeapSnapshotBuffers;
+    writer->queued_ -= 1;
+    uv_cond_signal(&writer->cond_);
+  }
+  uv_mutex_unlock(&writer->mutex_);
+}
+
+
+// Hands the buffer being filled to the writer thread, blocks while all
+// buffers are queued.  Returns false once a write failed.
+bool HeapSnapshotWriter::Flush() {
+  uv_mutex_lock(&mutex_);
+  queued_ += 1;
+  uv_cond_signal(&cond_);
+  while (queued_ == kHeapSnapshotBuffers && error_ == 0)
+    uv_cond_wait(&cond_, &mutex_);
+  const bool ok = error_ == 0;
+  uv_mutex_unlock(&mutex_);
+  fill_ = (fill_ + 1) % kHeapSnapshotBuffers;
+  return ok;
+}
+
+
+OutputStream::WriteResult HeapSnapshotWriter::WriteAsciiChunk(char* data,
+                                                              int size) {
+  while (size > 0) {
+    // The writer thread does not touch this buffer until it is flushed.
+    Buffer* buffer = &buffers_[fill_];
+    size_t length = kHeapSnapshotBufferSize - buffer->length;
+    if (length > static_cast<size_t>(size))
+      length = size;
+    memcpy(buffer->data + buffer->length, data, length);
+    buffer->length += length;
+    data += length;
+    size -= length;
+    if (buffer->length == kHeapSnapshotBufferSize && !Flush())
+      return kAbort;
+  }
+  return kContinue;
+}
+
+
+void HeapSnapshotWriter::EndOfStream() {
+  if (buffers_[fill_].length > 0)
+    Flush();
+}
+
+
+// Takes a heap snapshot and writes it to the file descriptor in args[0].
+// Returns 0 or a libuv error code.
+void WriteHeapSnapshot(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  CHECK(args[0]->IsInt32());
+
+  HeapSnapshotWriter writer(args[0]->Int32Value());
+  int err = writer.Start();
+  if (err == 0) {
+    HeapProfiler* profiler = env->isolate()->GetHeapProfiler();
+    const HeapSnapshot* snapshot =
+        profiler->TakeHeapSnapshot(String::Empty(env->isolate()));
+    snapshot->Serialize(&writer, HeapSnapshot::kJSON);
+    err = writer.Finish();
+    const_cast<HeapSnapshot*>(snapshot)->Delete();
+  }
+
+  args.GetReturnValue().Set(err);
+}
+
+
 void SetFlagsFromString(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
 
@@ -77,7 +619,13 @@ void InitializeV8Bindings(Handle<Object> target,
                           Handle<Context> context) {
   Environment* env = Environment::GetCurrent(context);
   env->SetMethod(target, "getHeapStatistics", GetHeapStatistics);
+  env->SetMethod(target, "getIdleGCStatistics", GetIdleGCStatistics);
   env->SetMethod(target, "setFlagsFromString", SetFlagsFromString);
+  env->SetMethod(target, "startGCTracking", StartGCTracking);
+  env->SetMethod(target, "stopGCTracking", StopGCTracking);
+  env->SetMethod(target, "startCpuProfiling", StartCpuProfiling);
+  env->SetMethod(target, "stopCpuProfiling", StopCpuProfiling);
+  env->SetMethod(target, "writeHeapSnapshot", WriteHeapSnapshot);
 
   target->Set(FIXED_ONE_BYTE_STRING(env->isolate(),
                                     "kHeapStatisticsBufferLength"),
@@ -95,6 +643,49 @@ void InitializeV8Bindings(Handle<Object> target,
 
   HEAP_STATISTICS_PROPERTIES(V)
 #undef V
+
+#define V(name)                                                               \
+  target->Set(FIXED_ONE_BYTE_STRING(env->isolate(), #name),                   \
+              Uint32::NewFromUnsigned(env->isolate(), Environment::name));
+
+  V(kIdleGCNotifications)
+  V(kIdleGCCompleted)
+  V(kIdleGCBudget)
+  V(kIdleGCTime)
+  V(kIdleGCFieldsCount)
+#undef V
+
+  target->Set(FIXED_ONE_BYTE_STRING(env->isolate(), "kGCEventFieldsCount"),
+              Uint32::NewFromUnsigned(env->isolate(), kGCEventFieldsCount));
+
+#define V(i, _, name)                                                         \
+  target->Set(FIXED_ONE_BYTE_STRING(env->isolate(), #name),                   \
+              Uint32::NewFromUnsigned(env->isolate(), i));
+
+  GC_EVENT_FIELDS(V)
+#undef V
+
+  target->Set(FIXED_ONE_BYTE_STRING(env->isolate(),
+                                    "kCpuProfileNodeFieldsCount"),
+              Uint32::NewFromUnsigned(env->isolate(),
+                                      kCpuProfileNodeFieldsCount));
+
+#define V(i, _, name)                                                         \
+  target->Set(FIXED_ONE_BYTE_STRING(env->isolate(), #name),                   \
+              Uint32::NewFromUnsigned(env->isolate(), i));
+
+  CPU_PROFILE_NODE_FIELDS(V)
+#undef V
+
+#define V(name)                                                               \
+  target->Set(FIXED_ONE_BYTE_STRING(env->isolate(), #name),                   \
+              Uint32::NewFromUnsigned(env->isolate(), v8::name));
+
+  V(kGCTypeScavenge)
+  V(kGCTypeMarkSweepCompact)
+  V(kGCCallbackFlagCompacted)
+  V(kGCCallbackFlagForced)
+#undef V
 }
 
 }  // namespace node
@@ -77,6 +77,17 @@ class ZCtx : public AsyncWrap {
     Close();
   }
 
+  size_t self_size() const override {
+    size_t size = sizeof(*this);
+    if (dictionary_ != nullptr)
+      size += dictionary_len_;
+    if (mode_ == DEFLATE || mode_ == GZIP || mode_ == DEFLATERAW)
+      size += kDeflateContextSize;
+    else if (mode_ != NONE)
+      size += kInflateContextSize;
+    return size;
+  }
+
   void Close() {
     if (write_in_progress_) {
       pending_close_ = true;
@@ -571,6 +582,310 @@ class ZCtx : public AsyncWrap {
 };
 
 
+/**
+ * Parallel gzip of a single buffer
+ *
+ * The input is split into blocks that are deflated independently on the
+ * threadpool, the way pigz does it.  Each block is primed with the 32 KB of
+ * input in front of it as a dictionary so matches can still reach across
+ * block boundaries, and all but the last block end with a Z_SYNC_FLUSH so
+ * they end on a byte boundary and can simply be concatenated.  The CRCs of
+ * the blocks are merged with crc32_combine() and the whole thing is wrapped
+ * in a regular gzip header and trailer.
+ */
+class GzipJob : public AsyncWrap {
+ public:
+  static void Start(const FunctionCallbackInfo<Value>& args);
+
+  ~GzipJob() override {
+    for (size_t i = 0; i < block_count_; i++)
+      free(blocks_[i].out);
+    delete[] blocks_;
+    persistent().Reset();
+  }
+
+  size_t self_size() const override {
+    size_t size = sizeof(*this) + block_count_ * sizeof(*blocks_);
+    for (size_t i = 0; i < block_count_; i++)
+      size += blocks_[i].out_length;
+    return size;
+  }
+
+ private:
+  static const size_t kWindowSize = 1 << 15;
+  static const size_t kHeaderSize = 10;
+  static const size_t kTrailerSize = 8;
+
+  struct Block {
+    GzipJob* job;
+    uv_work_t work_req;
+    const char* data;
+    size_t length;
+    size_t dictionary_length;
+    bool last;
+    char* out;
+    size_t out_length;
+    uLong crc;
+    int err;
+  };
+
+  GzipJob(Environment* env,
+          Local<Object> object,
+          const char* data,
+          size_t length,
+          int level,
+          int memLevel,
+          int strategy,
+          size_t block_size,
+          size_t concurrency)
+      : AsyncWrap(env, object, AsyncWrap::PROVIDER_ZLIB),
+        length_(length),
+        level_(level),
+        memLevel_(memLevel),
+        strategy_(strategy),
+        concurrency_(concurrency),
+        block_count_(length == 0 ? 1 : (length + block_size - 1) / block_size),
+        blocks_(new Block[block_count_]),
+        queued_(0),
+        running_(0),
+        err_(Z_OK) {
+    for (size_t i = 0; i < block_count_; i++) {
+      Block* block = &blocks_[i];
+      const size_t offset = i * block_size;
+      block->job = this;
+      block->data = data + offset;
+      block->length = length - offset < block_size ? length - offset
+                                                   : block_size;
+      block->dictionary_length = offset < kWindowSize ? offset : kWindowSize;
+      block->last = i == block_count_ - 1;
+      block->out = nullptr;
+      block->out_length = 0;
+      block->crc = 0;
+      block->err = Z_OK;
+    }
+  }
+
+  void QueueBlocks() {
+    while (err_ == Z_OK &&
+           running_ < concurrency_ &&
+           queued_ < block_count_) {
+      Block* block = &blocks_[queued_++];
+      running_++;
+      uv_queue_work(env()->event_loop(),
+                    &block->work_req,
+                    GzipJob::Process,
+                    GzipJob::After);
+    }
+  }
+
+  // thread pool!
+  static void Process(uv_work_t* work_req) {
+    Block* block = ContainerOf(&Block::work_req, work_req);
+    GzipJob* job = block->job;
+    const Bytef* in = reinterpret_cast<const Bytef*>(block->data);
+
+    block->crc = crc32(0, in, block->length);
+
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    block->err = deflateInit2(&strm,
+                              job->level_,
+                              Z_DEFLATED,
+                              -MAX_WBITS,
+                              job->memLevel_,
+                              job->strategy_);
+    if (block->err != Z_OK)
+      return;
+
+    if (block->dictionary_length > 0) {
+      block->err = deflateSetDictionary(&strm,
+                                        in - block->dictionary_length,
+                                        block->dictionary_length);
+    }
+
+    // deflateBound() does not account for the empty stored block that
+    // Z_SYNC_FLUSH appends, leave room for it and grow if that's not enough.
+    size_t size = deflateBound(&strm, block->length) + 16;
+    const int flush = block->last ? Z_FINISH : Z_SYNC_FLUSH;
+    strm.next_in = const_cast<Bytef*>(in);
+    strm.avail_in = block->length;
+
+    while (block->err == Z_OK) {
+      char* out = static_cast<char*>(realloc(block->out, size));
+      if (out == nullptr) {
+        block->err = Z_MEM_ERROR;
+        break;
+      }
+      block->out = out;
+      strm.next_out = reinterpret_cast<Bytef*>(out + block->out_length);
+      strm.avail_out = size - block->out_length;
+
+      int err = deflate(&strm, flush);
+      block->out_length = size - strm.avail_out;
+      if (err == Z_STREAM_END)
+        break;
+      if (err != Z_OK && err != Z_BUF_ERROR) {
+        block->err = err;
+        break;
+      }
+      // Out of room unless the flush is complete, which for Z_FINISH would
+      // have been Z_STREAM_END.
+      if (strm.avail_out != 0) {
+        if (flush == Z_FINISH)
+          block->err = Z_BUF_ERROR;
+        break;
+      }
+      size *= 2;
+    }
+
+    (void)deflateEnd(&strm);
+  }
+
+  // v8 land!
+  static void After(uv_work_t* work_req, int status) {
+    CHECK_EQ(status, 0);
+
+    Block* block = ContainerOf(&Block::work_req, work_req);
+    GzipJob* job = block->job;
+
+    job->running_--;
+    if (job->err_ == Z_OK)
+      job->err_ = block->err;
+
+    job->QueueBlocks();
+    if (job->running_ == 0)
+      job->Done();
+  }
+
+  void Done() {
+    Environment* env = this->env();
+    HandleScope handle_scope(env->isolate());
+    Context::Scope context_scope(env->context());
+
+    size_t size = kHeaderSize + kTrailerSize;
+    for (size_t i = 0; i < block_count_; i++)
+      size += blocks_[i].out_length;
+
+    if (err_ == Z_OK && size > Buffer::kMaxLength)
+      err_ = Z_BUF_ERROR;
+
+    if (err_ != Z_OK) {
+      Error(err_ == Z_BUF_ERROR ? "Output too large" : "Zlib error", err_);
+      delete this;
+      return;
+    }
+
+    char* data = static_cast<char*>(malloc(size));
+    if (data == nullptr)
+      FatalError("node::GzipJob::Done()", "Out of Memory");
+
+    // No file name or modification time, the OS is "unknown".
+    uint8_t* header = reinterpret_cast<uint8_t*>(data);
+    memset(header, 0, kHeaderSize);
+    header[0] = 0x1f;
+    header[1] = 0x8b;
+    header[2] = Z_DEFLATED;
+    if (level_ == Z_BEST_COMPRESSION)
+      header[8] = 2;
+    else if ((level_ >= 0 && level_ <= Z_BEST_SPEED) ||
+             strategy_ >= Z_HUFFMAN_ONLY)
+      header[8] = 4;
+    header[9] = 255;
+
+    size_t offset = kHeaderSize;
+    uLong crc = 0;
+    for (size_t i = 0; i < block_count_; i++) {
+      const Block* block = &blocks_[i];
+      memcpy(data + offset, block->out, block->out_length);
+      offset += block->out_length;
+      crc = crc32_combine(crc, block->crc, block->length);
+    }
+
+    uint8_t* trailer = reinterpret_cast<uint8_t*>(data + offset);
+    for (int i = 0; i < 4; i++) {
+      trailer[i] = (crc >> (8 * i)) & 0xff;
+      trailer[4 + i] = (static_cast<uint64_t>(length_) >> (8 * i)) & 0xff;
+    }
+
+    Local<Value> arg = Buffer::Use(env, data, size);
+    MakeCallback(env->ondone_string(), 1, &arg);
+    delete this;
+  }
+
+  void Error(const char* message, int err) {
+    Environment* env = this->env();
+    Local<Value> args[2] = {
+      OneByteString(env->isolate(), message),
+      Number::New(env->isolate(), err)
+    };
+    MakeCallback(env->onerror_string(), ARRAY_SIZE(args), args);
+  }
+
+  const size_t length_;
+  const int level_;
+  const int memLevel_;
+  const int strategy_;
+  const size_t concurrency_;
+  const size_t block_count_;
+  Block* const blocks_;
+  size_t queued_;
+  size_t running_;
+  int err_;
+};
+
+
+// gzip(buffer, level, memLevel, strategy, blockSize, concurrency, ondone,
+//      onerror)
+void GzipJob::Start(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+
+  CHECK_EQ(args.Length(), 8);
+  CHECK(Buffer::HasInstance(args[0]));
+  CHECK(args[6]->IsFunction());
+  CHECK(args[7]->IsFunction());
+
+  int level = args[1]->Int32Value();
+  CHECK((level >= -1 && level <= 9) && "invalid compression level");
+
+  int memLevel = args[2]->Uint32Value();
+  CHECK((memLevel >= 1 && memLevel <= 9) && "invalid memlevel");
+
+  int strategy = args[3]->Uint32Value();
+  CHECK((strategy == Z_FILTERED ||
+          strategy == Z_HUFFMAN_ONLY ||
+          strategy == Z_RLE ||
+          strategy == Z_FIXED ||
+          strategy == Z_DEFAULT_STRATEGY) && "invalid strategy");
+
+  size_t block_size = args[4]->Uint32Value();
+  CHECK_GT(block_size, 0);
+
+  size_t concurrency = args[5]->Uint32Value();
+  CHECK_GT(concurrency, 0);
+
+  // The job holds on to the buffer until it is done.
+  Local<Object> buffer = args[0].As<Object>();
+  Local<Object> obj = Object::New(env->isolate());
+  obj->Set(env->buffer_string(), buffer);
+  obj->Set(env->ondone_string(), args[6]);
+  obj->Set(env->onerror_string(), args[7]);
+  // XXX(trevnorris): This will need to go with the rest of domains.
+  if (env->in_domain())
+    obj->Set(env->domain_string(), env->domain_array()->Get(0));
+
+  GzipJob* job = new GzipJob(env,
+                             obj,
+                             Buffer::Data(buffer),
+                             Buffer::Length(buffer),
+                             level,
+                             memLevel,
+                             strategy,
+                             block_size,
+                             concurrency);
+  job->QueueBlocks();
+}
+
+
 void InitZlib(Handle<Object> target,
               Handle<Value> unused,
               Handle<Context> context,
@@ -590,6 +905,8 @@ void InitZlib(Handle<Object> target,
   z->SetClassName(FIXED_ONE_BYTE_STRING(env->isolate(), "Zlib"));
   target->Set(FIXED_ONE_BYTE_STRING(env->isolate(), "Zlib"), z->GetFunction());
 
+  env->SetMethod(target, "gzip", GzipJob::Start);
+
   // valid flush values.
   NODE_DEFINE_CONSTANT(target, Z_NO_FLUSH);
   NODE_DEFINE_CONSTANT(target, Z_PARTIAL_FLUSH);
@@ -10,6 +10,7 @@ namespace node {
 class PipeWrap : public StreamWrap {
  public:
   uv_pipe_t* UVHandle();
+  size_t self_size() const override { return sizeof(*this); }
 
   static v8::Local<v8::Object> Instantiate(Environment* env, AsyncWrap* parent);
   static void Initialize(v8::Handle<v8::Object> target,
@@ -28,6 +28,7 @@
 namespace node {
 namespace smalloc {
 
+using v8::Array;
 using v8::Context;
 using v8::External;
 using v8::ExternalArrayType;
@@ -57,6 +58,7 @@ class CallbackInfo {
   static inline CallbackInfo* New(Isolate* isolate,
                                   Ownership ownership,
                                   Handle<Object> object,
+                                  size_t byte_length,
                                   FreeCallback callback,
                                   void* hint = 0);
   inline void Dispose(Isolate* isolate);
@@ -67,10 +69,14 @@ class CallbackInfo {
   inline CallbackInfo(Isolate* isolate,
                       Ownership ownership,
                       Handle<Object> object,
+                      size_t byte_length,
                       FreeCallback callback,
                       void* hint);
   ~CallbackInfo();
   const Ownership ownership_;
+  // Size of the allocation as reported to V8.  Kept separately because
+  // truncate() shrinks the length of the external array.
+  const size_t byte_length_;
   Persistent<Object> persistent_;
   FreeCallback const callback_;
   void* const hint_;
@@ -86,9 +92,15 @@ void CallbackInfo::Free(char* data, void*) {
 CallbackInfo* CallbackInfo::New(Isolate* isolate,
                                 CallbackInfo::Ownership ownership,
                                 Handle<Object> object,
+                                size_t byte_length,
                                 FreeCallback callback,
                                 void* hint) {
-  return new CallbackInfo(isolate, ownership, object, callback, hint);
+  return new CallbackInfo(isolate,
+                          ownership,
+                          object,
+                          byte_length,
+                          callback,
+                          hint);
 }
 
 
@@ -105,9 +117,11 @@ Persistent<Object>* CallbackInfo::persistent() {
 CallbackInfo::CallbackInfo(Isolate* isolate,
                            CallbackInfo::Ownership ownership,
                            Handle<Object> object,
+                           size_t byte_length,
                            FreeCallback callback,
                            void* hint)
     : ownership_(ownership),
+      byte_length_(byte_length),
       persistent_(isolate, object),
       callback_(callback),
       hint_(hint) {
@@ -156,20 +170,14 @@ inline size_t InternalExternalArraySize(enum ExternalArrayType type) {
 
 void CallbackInfo::WeakCallback(Isolate* isolate, Local<Object> object) {
   void* array_data = object->GetIndexedPropertiesExternalArrayData();
-  size_t array_length = object->GetIndexedPropertiesExternalArrayDataLength();
   enum ExternalArrayType array_type =
       object->GetIndexedPropertiesExternalArrayDataType();
-  size_t array_size = InternalExternalArraySize(array_type);
-  CHECK_GT(array_size, 0);
-  if (array_size > 1 && array_data != NULL) {
-    CHECK_GT(array_length * array_size, array_length);  // Overflow check.
-    array_length *= array_size;
-  }
   object->SetIndexedPropertiesToExternalArrayData(nullptr, array_type, 0);
   callback_(static_cast<char*>(array_data), hint_);
   int64_t change_in_bytes = -static_cast<int64_t>(sizeof(*this));
-  if (ownership_ == kInternal)
-    change_in_bytes -= static_cast<int64_t>(array_length);
+  // AllocDispose() already accounted for memory it freed.
+  if (ownership_ == kInternal && array_data != nullptr)
+    change_in_bytes -= static_cast<int64_t>(byte_length_);
   isolate->AdjustAmountOfExternalAllocatedMemory(change_in_bytes);
   delete this;
 }
@@ -355,10 +363,63 @@ void Alloc(Environment* env,
   CallbackInfo::New(env->isolate(),
                     CallbackInfo::kInternal,
                     obj,
+                    length,
                     CallbackInfo::Free);
 }
 
 
+// Small allocations from C++, node::Buffer::New() in particular, are carved
+// out of shared slabs the same way lib/buffer.js slices its pool.  Every
+// slice keeps its slab alive through its `parent` property, so only the
+// slab has a CallbackInfo and a weak handle, not every buffer.  Slabs are
+// segregated by size class to limit the memory a few long-lived small
+// buffers can pin.
+static const size_t kSlabClassMaxLength[Environment::kSmallocSlabClasses] = {
+  256, 1024, 4096
+};
+static const size_t kSlabClassSize[Environment::kSmallocSlabClasses] = {
+  8 * 1024, 16 * 1024, 32 * 1024
+};
+
+
+bool SlabAlloc(Environment* env, Handle<Object> obj, size_t length) {
+  if (length == 0 || length > kSlabMaxLength)
+    return false;
+
+  int size_class = 0;
+  while (length > kSlabClassMaxLength[size_class])
+    size_class++;
+
+  Isolate* isolate = env->isolate();
+  HandleScope handle_scope(isolate);
+  Local<Array> slabs = env->smalloc_slabs_array();
+  uint32_t* offset = env->smalloc_slab_offsets() + size_class;
+  const size_t slab_size = kSlabClassSize[size_class];
+
+  Local<Value> slab_v = slabs->Get(size_class);
+  if (!slab_v->IsObject() || *offset + length > slab_size) {
+    Local<Object> slab = Object::New(isolate);
+    Alloc(env, slab, slab_size);
+    slabs->Set(size_class, slab);
+    *offset = 0;
+    slab_v = slab;
+  }
+
+  Local<Object> slab = slab_v.As<Object>();
+  char* data =
+      static_cast<char*>(slab->GetIndexedPropertiesExternalArrayData());
+  CHECK_EQ(false, obj->HasIndexedPropertiesInExternalArrayData());
+  obj->SetIndexedPropertiesToExternalArrayData(data + *offset,
+                                               kExternalUint8Array,
+                                               length);
+  obj->Set(env->parent_string(), slab);
+
+  // Keep slices aligned.
+  *offset = (*offset + length + 7) & ~7;
+  return true;
+}
+
+
 // for internal use: dispose(obj);
 void AllocDispose(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
@@ -415,7 +476,8 @@ static void Alloc(Environment* env,
   Isolate* isolate = env->isolate();
   HandleScope handle_scope(isolate);
   env->set_using_smalloc_alloc_cb(true);
-  CallbackInfo* info = CallbackInfo::New(isolate, ownership, obj, fn, hint);
+  CallbackInfo* info =
+      CallbackInfo::New(isolate, ownership, obj, length, fn, hint);
   obj->SetHiddenValue(env->smalloc_p_string(), External::New(isolate, info));
   size_t size = length / InternalExternalArraySize(type);
   obj->SetIndexedPropertiesToExternalArrayData(data, type, size);
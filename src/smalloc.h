@@ -141,6 +141,15 @@ void Alloc(Environment* env,
 void AllocDispose(Environment* env, v8::Handle<v8::Object> obj);
 bool HasExternalData(Environment* env, v8::Local<v8::Object> obj);
 
+// Allocations up to this size can be served from a shared slab.
+static const size_t kSlabMaxLength = 4096;
+
+// Points obj's Uint8 external array data at length bytes of a shared slab
+// and sets obj.parent to keep the slab alive.  The memory can't be freed
+// with AllocDispose().  Returns false if length is too big or zero, the
+// caller should use Alloc() then.
+bool SlabAlloc(Environment* env, v8::Handle<v8::Object> obj, size_t length);
+
 }  // namespace smalloc
 }  // namespace node
 
@@ -0,0 +1,305 @@
+#include "string_bytes.h"
+#include "node.h"
+#include "node_buffer.h"
+#include "node_internals.h"
+#include "base-object.h"
+#include "base-object-inl.h"
+#include "env.h"
+#include "env-inl.h"
+#include "util.h"
+#include "util-inl.h"
+#include "v8.h"
+
+#include <string.h>
+
+namespace node {
+namespace string_decoder {
+
+using v8::Array;
+using v8::Context;
+using v8::FunctionCallbackInfo;
+using v8::FunctionTemplate;
+using v8::Handle;
+using v8::Integer;
+using v8::Isolate;
+using v8::Local;
+using v8::Object;
+using v8::String;
+using v8::Value;
+
+// Splits a series of buffers into strings without breaking apart multi-byte
+// characters, see lib/string_decoder.js.  The bytes of a character that is
+// cut off at the end of a chunk are kept until the next write.  Every chunk
+// is then decoded with a single call into V8, the same way Buffer#toString()
+// decodes it, so invalid input results in the same replacement characters.
+//
+// Only UTF-8, UTF-16LE and base64 need state, the other encodings are
+// handled in JS.  CESU-8, where a surrogate pair is encoded as two 3 byte
+// sequences, is handled as part of UTF-8: a trailing lead surrogate is held
+// back like an incomplete character.
+class StringDecoder : public BaseObject {
+ public:
+  static void Initialize(Environment* env, Local<Object> target);
+
+ private:
+  // Enough for any single character.  UTF-8 needs 4 bytes but CESU-8 may
+  // take up to 6, 3 per surrogate.
+  static const size_t kMaxCharLength = 6;
+
+  StringDecoder(Environment* env, Local<Object> object, enum encoding enc)
+      : BaseObject(env, object),
+        encoding_(enc),
+        surrogate_size_(enc == UCS2 ? 2 : 3),
+        char_received_(0),
+        char_length_(0) {
+    MakeWeak<StringDecoder>(this);
+  }
+
+  Local<String> Decode(const char* data, size_t length) const;
+  Local<String> Write(const char* data, size_t length);
+  Local<String> End();
+  void DetectIncompleteChar(const char* data, size_t length);
+
+  static void New(const FunctionCallbackInfo<Value>& args);
+  static void Write(const FunctionCallbackInfo<Value>& args);
+  static void End(const FunctionCallbackInfo<Value>& args);
+  static void State(const FunctionCallbackInfo<Value>& args);
+
+  const enum encoding encoding_;
+  const size_t surrogate_size_;
+  char char_buffer_[kMaxCharLength];
+  // Bytes received and expected for the current incomplete character.
+  size_t char_received_;
+  size_t char_length_;
+};
+
+
+static inline bool IsLeadSurrogate(uint16_t c) {
+  return c >= 0xD800 && c <= 0xDBFF;
+}
+
+
+static inline bool EndsWithLeadSurrogate(Local<String> string) {
+  const int length = string->Length();
+  if (length == 0)
+    return false;
+  uint16_t c;
+  string->Write(&c, length - 1, 1, String::NO_NULL_TERMINATION);
+  return IsLeadSurrogate(c);
+}
+
+
+Local<String> StringDecoder::Decode(const char* data, size_t length) const {
+  Isolate* isolate = env()->isolate();
+
+  if (encoding_ != UCS2)
+    return StringBytes::Encode(isolate, data, length, encoding_).As<String>();
+
+  // Same as Buffer#ucs2Slice(): the input is little endian and possibly not
+  // aligned.
+  length /= 2;
+  if (IsLittleEndian() && reinterpret_cast<uintptr_t>(data) % 2 == 0) {
+    const uint16_t* buf = reinterpret_cast<const uint16_t*>(data);
+    return StringBytes::Encode(isolate, buf, length).As<String>();
+  }
+
+  uint16_t* copy = new uint16_t[length];
+  for (size_t i = 0, k = 0; i < length; i += 1, k += 2) {
+    const uint8_t lo = static_cast<uint8_t>(data[k + 0]);
+    const uint8_t hi = static_cast<uint8_t>(data[k + 1]);
+    copy[i] = lo | hi << 8;
+  }
+  Local<String> result =
+      StringBytes::Encode(isolate, copy, length).As<String>();
+  delete[] copy;
+  return result;
+}
+
+
+// Sets char_length_ and char_received_ for the character the chunk ends
+// with, both are 0 when that character is complete.
+void StringDecoder::DetectIncompleteChar(const char* data, size_t length) {
+  if (encoding_ == UCS2) {
+    char_received_ = length % 2;
+    char_length_ = char_received_ ? 2 : 0;
+    return;
+  }
+
+  if (encoding_ == BASE64) {
+    char_received_ = length % 3;
+    char_length_ = char_received_ ? 3 : 0;
+    return;
+  }
+
+  // See http://en.wikipedia.org/wiki/UTF-8#Description.  Only the last 3
+  // bytes can start a character that is not complete yet.
+  char_length_ = 0;
+  size_t i = length >= 3 ? 3 : length;
+  for (; i > 0; i--) {
+    const uint8_t c = static_cast<uint8_t>(data[length - i]);
+    // 110XXXXX
+    if (i == 1 && c >> 5 == 0x06) {
+      char_length_ = 2;
+      break;
+    }
+    // 1110XXXX
+    if (i <= 2 && c >> 4 == 0x0E) {
+      char_length_ = 3;
+      break;
+    }
+    // 11110XXX
+    if (c >> 3 == 0x1E) {
+      char_length_ = 4;
+      break;
+    }
+  }
+  char_received_ = char_length_ ? i : 0;
+}
+
+
+Local<String> StringDecoder::Write(const char* data, size_t length) {
+  Local<String> prefix = String::Empty(env()->isolate());
+
+  // Complete the character the last chunk ended with.
+  while (char_length_ > 0) {
+    size_t available = char_length_ - char_received_;
+    if (available > length)
+      available = length;
+    memcpy(char_buffer_ + char_received_, data, available);
+    char_received_ += available;
+    data += available;
+    length -= available;
+
+    if (char_received_ < char_length_)
+      return String::Empty(env()->isolate());
+
+    prefix = Decode(char_buffer_, char_length_);
+    if (char_length_ + surrogate_size_ <= kMaxCharLength &&
+        EndsWithLeadSurrogate(prefix)) {
+      // Wait for the trail surrogate.
+      char_length_ += surrogate_size_;
+      prefix = String::Empty(env()->isolate());
+      continue;
+    }
+    char_received_ = char_length_ = 0;
+
+    if (length == 0)
+      return prefix;
+  }
+
+  DetectIncompleteChar(data, length);
+  const size_t end = length - char_received_;
+  memcpy(char_buffer_, data + end, char_received_);
+
+  Local<String> body = Decode(data, end);
+  if (end >= surrogate_size_ &&
+      char_length_ + surrogate_size_ <= kMaxCharLength &&
+      EndsWithLeadSurrogate(body)) {
+    // Hold the lead surrogate back, in front of the incomplete character.
+    memmove(char_buffer_ + surrogate_size_, char_buffer_, char_received_);
+    memcpy(char_buffer_, data + end - surrogate_size_, surrogate_size_);
+    char_length_ += surrogate_size_;
+    char_received_ += surrogate_size_;
+    body = Decode(data, end - surrogate_size_);
+  }
+
+  if (prefix->Length() == 0)
+    return body;
+  return String::Concat(prefix, body);
+}
+
+
+// Returns whatever is left of an incomplete character, decoded the way
+// Buffer#toString() would, and resets the decoder.
+Local<String> StringDecoder::End() {
+  Local<String> rest = Decode(char_buffer_, char_received_);
+  char_received_ = char_length_ = 0;
+  return rest;
+}
+
+
+void StringDecoder::New(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  CHECK(args.IsConstructCall());
+
+  const enum encoding enc = ParseEncoding(env->isolate(), args[0], UTF8);
+  CHECK(enc == UTF8 || enc == UCS2 || enc == BASE64);
+  new StringDecoder(env, args.This(), enc);
+}
+
+
+void StringDecoder::Write(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  StringDecoder* decoder = Unwrap<StringDecoder>(args.Holder());
+
+  if (!Buffer::HasInstance(args[0]))
+    return env->ThrowTypeError("argument must be a buffer");
+
+  Local<Object> buffer = args[0].As<Object>();
+  args.GetReturnValue().Set(
+      decoder->Write(Buffer::Data(buffer), Buffer::Length(buffer)));
+}
+
+
+// end([buffer])
+void StringDecoder::End(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  StringDecoder* decoder = Unwrap<StringDecoder>(args.Holder());
+
+  Local<String> result = String::Empty(env->isolate());
+  if (!args[0]->IsUndefined() && !args[0]->IsNull()) {
+    if (!Buffer::HasInstance(args[0]))
+      return env->ThrowTypeError("argument must be a buffer");
+    Local<Object> buffer = args[0].As<Object>();
+    result = decoder->Write(Buffer::Data(buffer), Buffer::Length(buffer));
+  }
+
+  Local<String> rest = decoder->End();
+  if (rest->Length() > 0)
+    result = String::Concat(result, rest);
+  args.GetReturnValue().Set(result);
+}
+
+
+// state() returns [charBuffer, charReceived, charLength], a copy of what
+// the old JS implementation kept as properties on the decoder.
+void StringDecoder::State(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  StringDecoder* decoder = Unwrap<StringDecoder>(args.Holder());
+
+  Local<Array> state = Array::New(env->isolate(), 3);
+  state->Set(0, Buffer::New(env, decoder->char_buffer_, kMaxCharLength));
+  state->Set(1, Integer::NewFromUnsigned(
+      env->isolate(), static_cast<uint32_t>(decoder->char_received_)));
+  state->Set(2, Integer::NewFromUnsigned(
+      env->isolate(), static_cast<uint32_t>(decoder->char_length_)));
+  args.GetReturnValue().Set(state);
+}
+
+
+void StringDecoder::Initialize(Environment* env, Local<Object> target) {
+  Local<FunctionTemplate> t = env->NewFunctionTemplate(New);
+  t->InstanceTemplate()->SetInternalFieldCount(1);
+  t->SetClassName(FIXED_ONE_BYTE_STRING(env->isolate(), "StringDecoder"));
+
+  env->SetProtoMethod(t, "write", Write);
+  env->SetProtoMethod(t, "end", End);
+  env->SetProtoMethod(t, "state", State);
+
+  target->Set(FIXED_ONE_BYTE_STRING(env->isolate(), "StringDecoder"),
+              t->GetFunction());
+}
+
+
+void Initialize(Handle<Object> target,
+                Handle<Value> unused,
+                Handle<Context> context) {
+  Environment* env = Environment::GetCurrent(context);
+  StringDecoder::Initialize(env, target);
+}
+
+}  // namespace string_decoder
+}  // namespace node
+
+NODE_MODULE_CONTEXT_AWARE_BUILTIN(string_decoder,
+                                  node::string_decoder::Initialize)
@@ -38,11 +38,11 @@ TLSWrap::TLSWrap(Environment* env,
                  Kind kind,
                  StreamBase* stream,
                  SecureContext* sc)
-    : SSLWrap<TLSWrap>(env, sc, kind),
-      StreamBase(env),
-      AsyncWrap(env,
+    : AsyncWrap(env,
                 env->tls_wrap_constructor_function()->NewInstance(),
                 AsyncWrap::PROVIDER_TLSWRAP),
+      SSLWrap<TLSWrap>(env, sc, kind),
+      StreamBase(env),
       sc_(sc),
       stream_(stream),
       enc_in_(nullptr),
@@ -122,6 +122,20 @@ void TLSWrap::NewSessionDoneCb() {
 }
 
 
+size_t TLSWrap::self_size() const {
+  size_t size = sizeof(*this);
+  // The encrypted side BIOs are owned by ssl_.
+  if (ssl_ != nullptr) {
+    size += kExternalSize;
+    size += NodeBIO::FromBIO(enc_in_)->AllocatedSize();
+    size += NodeBIO::FromBIO(enc_out_)->AllocatedSize();
+  }
+  if (clear_in_ != nullptr)
+    size += clear_in_->AllocatedSize();
+  return size;
+}
+
+
 void TLSWrap::InitSSL() {
   // Initialize SSL
   enc_in_ = NodeBIO::New();
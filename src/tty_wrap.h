@@ -15,6 +15,8 @@ class TTYWrap : public StreamWrap {
 
   uv_tty_t* UVHandle();
 
+  size_t self_size() const override { return sizeof(*this); }
+
  private:
   TTYWrap(Environment* env,
           v8::Handle<v8::Object> object,
@@ -0,0 +1,35 @@
+'use strict';
+var common = require('../common');
+var assert = require('assert');
+
+if (!common.hasCrypto) {
+  console.log('1..0 # Skipped: missing crypto');
+  return;
+}
+var crypto = require('crypto');
+
+// Small buffers created in C++ share slabs: they keep their slab alive
+// through `parent` and must not overlap.
+var digests = [];
+var buffers = [];
+for (var i = 0; i < 1000; i++) {
+  var hash = crypto.createHash('sha1').update('' + i);
+  var buf = hash.digest();
+  assert.equal(buf.length, 20);
+  assert.equal(typeof buf.parent, 'object');
+  buffers.push(buf);
+  digests.push(crypto.createHash('sha1').update('' + i).digest('hex'));
+}
+
+buffers.forEach(function(buf, i) {
+  buf.fill(i & 255, 0, 1);
+});
+buffers.forEach(function(buf, i) {
+  assert.equal(buf[0], i & 255);
+  assert.equal(buf.toString('hex', 1), digests[i].slice(2));
+});
+
+// Big ones still get their own memory.
+var big = crypto.randomBytes(64 * 1024);
+assert.equal(big.length, 64 * 1024);
+assert.equal(big.parent, undefined);
@@ -0,0 +1,114 @@
+'use strict';
+var common = require('../common');
+var assert = require('assert');
+
+if (!common.hasCrypto) {
+  console.log('1..0 # Skipped: missing crypto');
+  process.exit();
+}
+var crypto = require('crypto');
+
+assert.throws(function() {
+  crypto.generateDiffieHellman('256', function() {});
+}, TypeError);
+assert.throws(function() {
+  crypto.generateDiffieHellman(256);
+}, TypeError);
+[512.5, -512, 0, Infinity, NaN, 0x80000000].forEach(function(primeLength) {
+  assert.throws(function() {
+    crypto.generateDiffieHellman(primeLength, function() {});
+  }, /primeLength must be a positive 32-bit integer/);
+});
+[2.5, Infinity, '2', 0x80000000].forEach(function(generator) {
+  assert.throws(function() {
+    crypto.generateDiffieHellman(512, generator, function() {});
+  }, /generator must be a 32-bit integer/);
+});
+
+// Prime generation in the thread pool.
+crypto.generateDiffieHellman(256, common.mustCall(function(err, dh1) {
+  assert.ifError(err);
+  assert(dh1 instanceof crypto.DiffieHellman);
+  assert.equal(dh1.verifyError, 0);
+  assert.equal(dh1.getPrime().length, 32);
+  assert.equal(dh1.getGenerator('hex'), '02');
+
+  var dh2 = crypto.createDiffieHellman(dh1.getPrime(), dh1.getGenerator());
+  dh2.generateKeys();
+
+  dh1.generateKeys('hex', common.mustCall(function(err, key) {
+    assert.ifError(err);
+    assert.equal(key, dh1.getPublicKey('hex'));
+    assert.equal(dh1.computeSecret(dh2.getPublicKey(), null, 'hex'),
+                 dh2.computeSecret(dh1.getPublicKey(), null, 'hex'));
+  }));
+}));
+
+crypto.generateDiffieHellman(256, 5, common.mustCall(function(err, dh) {
+  assert.ifError(err);
+  assert.equal(dh.getGenerator('hex'), '05');
+}));
+
+// ECDH keys in the thread pool.
+var ecdh1 = crypto.createECDH('prime256v1');
+var ecdh2 = crypto.createECDH('prime256v1');
+ecdh2.generateKeys();
+
+ecdh1.generateKeys('hex', 'compressed', common.mustCall(function(err, key) {
+  assert.ifError(err);
+  assert.equal(key, ecdh1.getPublicKey('hex', 'compressed'));
+  assert.equal(ecdh1.computeSecret(ecdh2.getPublicKey(), null, 'hex'),
+               ecdh2.computeSecret(ecdh1.getPublicKey(), null, 'hex'));
+}));
+
+// Key pools.
+assert.throws(function() {
+  crypto.warmKeyPool('no such curve', 1);
+}, /Unknown curve or group/);
+assert.throws(function() {
+  crypto.warmKeyPool('prime256v1', 65);
+}, RangeError);
+assert.throws(function() {
+  crypto.warmKeyPool('prime256v1', -1);
+}, TypeError);
+
+crypto.warmKeyPool('secp384r1', 4, common.mustCall(function(err) {
+  assert.ifError(err);
+
+  var keys = {};
+  for (var i = 0; i < 6; i++) {
+    var ecdh = crypto.createECDH('secp384r1');
+    var key = ecdh.generateKeys('hex');
+    assert(!(key in keys));
+    keys[key] = true;
+  }
+
+  // A pooled key is used right away but the callback is still called
+  // asynchronously.
+  var sync = true;
+  var ecdh3 = crypto.createECDH('secp384r1');
+  ecdh3.generateKeys('hex', common.mustCall(function(err, key) {
+    assert.ifError(err);
+    assert(!sync);
+    assert.equal(key, ecdh3.getPublicKey('hex'));
+    var ecdh4 = crypto.createECDH('secp384r1');
+    ecdh4.generateKeys();
+    assert.equal(ecdh3.computeSecret(ecdh4.getPublicKey(), null, 'hex'),
+                 ecdh4.computeSecret(ecdh3.getPublicKey(), null, 'hex'));
+    crypto.warmKeyPool('secp384r1', 0);
+  }));
+  sync = false;
+}));
+
+crypto.warmKeyPool('modp1', 2, common.mustCall(function(err) {
+  assert.ifError(err);
+
+  var alice = crypto.getDiffieHellman('modp1');
+  var bob = crypto.getDiffieHellman('modp1');
+  alice.generateKeys();
+  bob.generateKeys();
+  assert.notEqual(alice.getPublicKey('hex'), bob.getPublicKey('hex'));
+  assert.equal(alice.computeSecret(bob.getPublicKey(), null, 'hex'),
+               bob.computeSecret(alice.getPublicKey(), null, 'hex'));
+  crypto.warmKeyPool('modp1', 0);
+}));
@@ -0,0 +1,55 @@
+'use strict';
+var common = require('../common');
+var assert = require('assert');
+
+if (!common.hasCrypto) {
+  console.log('1..0 # Skipped: missing crypto');
+  process.exit();
+}
+var crypto = require('crypto');
+var spawn = require('child_process').spawn;
+
+// Keys of several blocks are split across threads, the result must be the
+// same as deriving the blocks in order.
+function check(keylen, digest) {
+  var expected = crypto.pbkdf2Sync('password', 'salt', 1000, keylen, digest);
+  assert.equal(expected.length, keylen);
+  crypto.pbkdf2('password', 'salt', 1000, keylen, digest, common.mustCall(
+    function(err, key) {
+      assert.ifError(err);
+      assert.equal(key.toString('hex'), expected.toString('hex'));
+    }));
+}
+
+[0, 1, 20, 21, 40, 100, 1000].forEach(function(keylen) {
+  check(keylen, 'sha1');
+});
+[32, 33, 64, 65, 200].forEach(function(keylen) {
+  check(keylen, 'sha256');
+});
+check(300, 'sha512');
+
+// RFC 6070, 25 bytes take two SHA-1 blocks.
+var password = 'passwordPASSWORDpassword';
+var salt = 'saltSALTsaltSALTsaltSALTsaltSALTsalt';
+crypto.pbkdf2(password, salt, 4096, 25, common.mustCall(function(err, key) {
+  assert.ifError(err);
+  assert.equal(key.toString('hex'),
+               '3d2eec4fe41c849b80c8d83662c0e44a8b291a964cf2f07038');
+}));
+
+// Once more on a threadpool of its own.
+if (process.argv[2] !== 'child') {
+  var env = {};
+  for (var name in process.env)
+    env[name] = process.env[name];
+  env.NODE_CRYPTO_THREADPOOL_SIZE = '3';
+
+  var child = spawn(process.execPath, [__filename, 'child'], {
+    env: env,
+    stdio: 'inherit'
+  });
+  child.on('exit', common.mustCall(function(code) {
+    assert.equal(code, 0);
+  }));
+}
@@ -0,0 +1,54 @@
+'use strict';
+var common = require('../common');
+var assert = require('assert');
+
+if (!common.hasCrypto) {
+  console.log('1..0 # Skipped: missing crypto');
+  process.exit();
+}
+var crypto = require('crypto');
+
+// Small requests are served from the pool once it has been filled, the
+// first ones go through the thread pool like large ones.  Enough of them
+// to use up a few blocks.
+var seen = {};
+var count = 0;
+var sizes = [0, 1, 16, 32, 255, 256];
+
+function take(n, done) {
+  if (n === 0)
+    return done();
+  var size = sizes[n % sizes.length];
+  var sync = true;
+  crypto.randomBytes(size, common.mustCall(function(err, buf) {
+    assert.ifError(err);
+    assert(!sync);
+    assert(Buffer.isBuffer(buf));
+    assert.equal(buf.length, size);
+    if (size >= 16) {
+      var hex = buf.toString('hex');
+      assert(!(hex in seen));
+      seen[hex] = true;
+      count++;
+    }
+    var sbuf = crypto.randomBytes(size);
+    assert.equal(sbuf.length, size);
+    take(n - 1, done);
+  }));
+  sync = false;
+}
+
+take(1000, common.mustCall(function() {
+  assert(count > 0);
+
+  // Larger requests don't use the pool.
+  crypto.randomBytes(257, common.mustCall(function(err, buf) {
+    assert.ifError(err);
+    assert.equal(buf.length, 257);
+  }));
+  assert.equal(crypto.randomBytes(4096).length, 4096);
+}));
+
+assert.throws(function() {
+  crypto.randomBytes(-1, function() {});
+}, TypeError);
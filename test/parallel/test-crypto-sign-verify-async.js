@@ -0,0 +1,96 @@
+'use strict';
+var common = require('../common');
+var assert = require('assert');
+var fs = require('fs');
+
+if (!common.hasCrypto) {
+  console.log('1..0 # Skipped: missing crypto');
+  process.exit();
+}
+var crypto = require('crypto');
+
+var certPem = fs.readFileSync(common.fixturesDir + '/test_cert.pem', 'ascii');
+var keyPem = fs.readFileSync(common.fixturesDir + '/test_key.pem', 'ascii');
+var rsaPubPem = fs.readFileSync(common.fixturesDir + '/test_rsa_pubkey.pem',
+                                'ascii');
+var rsaKeyPem = fs.readFileSync(common.fixturesDir + '/test_rsa_privkey.pem',
+                                'ascii');
+
+// The signature is the same as the synchronous one, in every encoding.
+['RSA-SHA1', 'RSA-SHA256'].forEach(function(algo) {
+  var expected = crypto.createSign(algo).update('Test123').sign(keyPem);
+
+  var onsign = common.mustCall(function(err, sig) {
+    assert.ifError(err);
+    assert(Buffer.isBuffer(sig));
+    assert.deepEqual(sig, expected);
+
+    crypto.createVerify(algo)
+          .update('Test123')
+          .verify(certPem, sig, common.mustCall(function(err, result) {
+            assert.ifError(err);
+            assert.strictEqual(result, true);
+          }));
+
+    crypto.createVerify(algo)
+          .update('Test124')
+          .verify(certPem, sig, common.mustCall(function(err, result) {
+            assert.ifError(err);
+            assert.strictEqual(result, false);
+          }));
+  });
+  crypto.createSign(algo).update('Test123').sign(keyPem, onsign);
+
+  var sign = crypto.createSign(algo);
+  sign.update('Test123');
+  sign.sign(keyPem, 'hex', common.mustCall(function(err, sig) {
+    assert.ifError(err);
+    assert.equal(sig, expected.toString('hex'));
+
+    crypto.createVerify(algo)
+          .update('Test123')
+          .verify(certPem,
+                  sig,
+                  'hex',
+                  common.mustCall(function(err, result) {
+                    assert.ifError(err);
+                    assert.strictEqual(result, true);
+                  }));
+  }));
+
+  // Like the synchronous version, the object can't be used again.
+  assert.throws(function() {
+    sign.sign(keyPem, function() {});
+  }, /Not initialised/);
+});
+
+// An invalid key throws right away.
+assert.throws(function() {
+  crypto.createSign('RSA-SHA1').update('Test123').sign('nope', function() {});
+});
+
+// Public key encryption round trips through the thread pool.
+var input = new Buffer('I AM THE WALRUS');
+
+crypto.publicEncrypt(rsaPubPem, input, common.mustCall(function(err, enc) {
+  assert.ifError(err);
+  crypto.privateDecrypt(rsaKeyPem, enc, common.mustCall(function(err, dec) {
+    assert.ifError(err);
+    assert.equal(dec.toString(), input.toString());
+  }));
+}));
+
+crypto.privateEncrypt(rsaKeyPem, input, common.mustCall(function(err, enc) {
+  assert.ifError(err);
+  assert.deepEqual(enc, crypto.privateEncrypt(rsaKeyPem, input));
+  crypto.publicDecrypt(rsaPubPem, enc, common.mustCall(function(err, dec) {
+    assert.ifError(err);
+    assert.equal(dec.toString(), input.toString());
+  }));
+}));
+
+// Errors of the operation itself are passed to the callback.
+crypto.privateDecrypt(rsaKeyPem, input, common.mustCall(function(err, result) {
+  assert(err instanceof Error);
+  assert.equal(result, undefined);
+}));
@@ -0,0 +1,110 @@
+'use strict';
+var common = require('../common');
+var assert = require('assert');
+var fs = require('fs');
+var path = require('path');
+
+var root = path.join(common.tmpDir, 'scandir-' + process.pid);
+var sep = path.sep;
+
+function rmrf(p) {
+  fs.readdirSync(p).forEach(function(name) {
+    var child = path.join(p, name);
+    if (fs.lstatSync(child).isDirectory())
+      rmrf(child);
+    else
+      fs.unlinkSync(child);
+  });
+  fs.rmdirSync(p);
+}
+
+if (!fs.existsSync(common.tmpDir))
+  fs.mkdirSync(common.tmpDir);
+fs.mkdirSync(root);
+fs.mkdirSync(path.join(root, 'a'));
+fs.mkdirSync(path.join(root, 'a', 'b'));
+fs.writeFileSync(path.join(root, 'top.txt'), 'x');
+fs.writeFileSync(path.join(root, 'a', 'one.txt'), 'xx');
+fs.writeFileSync(path.join(root, 'a', 'b', 'two.txt'), 'xxx');
+
+process.on('exit', function() {
+  rmrf(root);
+});
+
+function toMap(entries) {
+  var map = {};
+  entries.names.forEach(function(name, i) {
+    map[name] = i;
+  });
+  return map;
+}
+
+// Flat listing, types only.
+var flat = fs.scandirSync(root);
+assert.deepEqual(flat.names.slice().sort(), ['a', 'top.txt']);
+assert.equal(flat.stats, undefined);
+var m = toMap(flat);
+assert(flat.isDirectory(m.a));
+assert(flat.isFile(m['top.txt']));
+assert.throws(function() { flat.getStats(0); }, /stats option/);
+
+// Recursive listing with stats.
+function checkTree(entries) {
+  var names = entries.names.slice().sort();
+  assert.deepEqual(names, [
+    'a',
+    'a' + sep + 'b',
+    'a' + sep + 'b' + sep + 'two.txt',
+    'a' + sep + 'one.txt',
+    'top.txt'
+  ]);
+  var m = toMap(entries);
+  var file = 'a' + sep + 'b' + sep + 'two.txt';
+  assert(entries.isFile(m[file]));
+  assert(entries.isDirectory(m['a' + sep + 'b']));
+
+  var stats = entries.getStats(m[file]);
+  var expected = fs.lstatSync(path.join(root, file));
+  assert(stats instanceof fs.Stats);
+  assert(stats.isFile());
+  assert.equal(stats.size, 3);
+  assert.equal(stats.ino, expected.ino);
+  assert.strictEqual(stats.blksize, expected.blksize);
+  assert.strictEqual(stats.blocks, expected.blocks);
+  assert.equal(stats.mode, expected.mode);
+  assert.equal(stats.mtime.getTime(), expected.mtime.getTime());
+  assert(entries.getStats(m.a).isDirectory());
+}
+
+checkTree(fs.scandirSync(root, { recursive: true, stats: true }));
+
+var calls = 0;
+fs.scandir(root, { recursive: true, stats: true }, function(err, entries) {
+  assert.ifError(err);
+  checkTree(entries);
+  calls++;
+});
+
+fs.scandir(root, function(err, entries) {
+  assert.ifError(err);
+  assert.deepEqual(entries.names.slice().sort(), ['a', 'top.txt']);
+  calls++;
+});
+
+var returned = false;
+fs.scandir(path.join(root, 'nonexistent'), function(err, entries) {
+  assert.ok(returned, 'callback must not run synchronously');
+  assert.equal(err.code, 'ENOENT');
+  assert.equal(err.syscall, 'scandir');
+  assert.equal(entries, undefined);
+  calls++;
+});
+returned = true;
+
+assert.throws(function() {
+  fs.scandirSync(path.join(root, 'nonexistent'));
+}, /ENOENT/);
+
+process.on('exit', function() {
+  assert.equal(calls, 3);
+});
@@ -2,6 +2,7 @@
 var common = require('../common');
 var assert = require('assert');
 var fs = require('fs');
+var util = require('util');
 var got_error = false;
 var success_count = 0;
 
@@ -106,3 +107,46 @@ process.on('exit', function() {
   assert.equal(false, got_error);
 });
 
+
+// The stat family shares one result buffer, make sure the Stats objects
+// handed out don't alias it.
+(function() {
+  var dirStats = fs.statSync('.');
+  var fileStats = fs.statSync(__filename);
+  assert.ok(dirStats.isDirectory());
+  assert.ok(fileStats.isFile());
+  assert.notEqual(dirStats.ino, fileStats.ino);
+
+  assert.deepEqual(Object.keys(fileStats), [
+    'dev', 'mode', 'nlink', 'uid', 'gid', 'rdev', 'blksize', 'ino', 'size',
+    'blocks', 'atime', 'mtime', 'ctime', 'birthtime'
+  ]);
+  var json = JSON.parse(JSON.stringify(fileStats));
+  assert.equal(json.mtime, fileStats.mtime.toJSON());
+  assert.equal(util.inspect(fileStats).indexOf('Getter'), -1);
+})();
+
+// The dates are only created when they are read, and only once.
+(function() {
+  var RealDate = Date;
+  var created = 0;
+  global.Date = function(value) {
+    created++;
+    return new RealDate(value);
+  };
+  try {
+    var stats = fs.statSync(__filename);
+    assert.deepEqual(Object.keys(stats).slice(-4),
+                     ['atime', 'mtime', 'ctime', 'birthtime']);
+    assert.equal(created, 0);
+    var mtime = stats.mtime;
+    assert.ok(mtime instanceof RealDate);
+    assert.strictEqual(stats.mtime, mtime);
+    assert.equal(created, 1);
+    stats.atime = 'overwritten';
+    assert.equal(stats.atime, 'overwritten');
+    assert.equal(created, 1);
+  } finally {
+    global.Date = RealDate;
+  }
+})();
@@ -0,0 +1,47 @@
+'use strict';
+var common = require('../common');
+var assert = require('assert');
+var http = require('http');
+
+var invalidNames = ['', 'foo bar', 'foo:bar', 'foo\r\nbar', 'föö', '{}'];
+var responses = 0;
+
+var server = http.createServer(function(req, res) {
+  invalidNames.forEach(function(name) {
+    var headers = {};
+    headers[name] = 'value';
+    assert.throws(function() {
+      res.writeHead(200, headers);
+    }, TypeError);
+    assert.throws(function() {
+      res.writeHead(200, [[name, 'value']]);
+    }, TypeError);
+  });
+
+  // Array form, repeated headers and the automatic header detection all go
+  // through the same serializer.
+  res.writeHead(200, [
+    ['X-Multi', 'a'],
+    ['X-Multi', 'b'],
+    ['CONTENT-LENGTH', '2'],
+    ['connection', 'Close']
+  ]);
+  assert(/\r\nX-Multi: a\r\nX-Multi: b\r\n/.test(res._header));
+  assert(!/Transfer-Encoding/.test(res._header));
+  assert(!/Connection: keep-alive/.test(res._header));
+  res.end('ok');
+});
+
+server.listen(common.PORT, function() {
+  http.get({ port: common.PORT }, function(res) {
+    assert.equal(res.headers['content-length'], '2');
+    assert.equal(res.headers.connection, 'Close');
+    responses++;
+    res.resume();
+    server.close();
+  });
+});
+
+process.on('exit', function() {
+  assert.equal(responses, 1);
+});
@@ -239,6 +239,40 @@ function expectBody(expected) {
 })();
 
 
+//
+// Test lower-cased header names.
+//
+(function() {
+  var request = Buffer(
+      'GET / HTTP/1.1' + CRLF +
+      'Host: example.com' + CRLF +
+      'CONTENT-LENGTH: 0' + CRLF +
+      'ETag: "x"' + CRLF +
+      'x-lower: 1' + CRLF +
+      'X-Mixed-Case: 2' + CRLF +
+      CRLF);
+
+  var onHeadersComplete = function(versionMajor, versionMinor, headers, method,
+                                   url, statusCode, statusMessage, upgrade,
+                                   shouldKeepAlive, headerNames) {
+    assert.deepEqual(headers, [
+      'Host', 'example.com',
+      'CONTENT-LENGTH', '0',
+      'ETag', '"x"',
+      'x-lower', '1',
+      'X-Mixed-Case', '2'
+    ]);
+    assert.deepEqual(headerNames,
+                     ['host', 'content-length', 'etag', 'x-lower',
+                      'x-mixed-case']);
+  };
+
+  var parser = newParser(REQUEST);
+  parser[kOnHeadersComplete] = mustCall(onHeadersComplete);
+  parser.execute(request, 0, request.length);
+})();
+
+
 //
 // Test large number of headers
 //
@@ -0,0 +1,71 @@
+'use strict';
+var common = require('../common');
+var assert = require('assert');
+var fs = require('fs');
+var path = require('path');
+var Module = require('module');
+
+var dir = path.join(common.tmpDir, 'bundle-' + process.pid);
+var bundleFile = path.join(common.tmpDir, 'test-' + process.pid + '.bundle');
+
+if (!fs.existsSync(common.tmpDir))
+  fs.mkdirSync(common.tmpDir);
+fs.mkdirSync(dir);
+fs.mkdirSync(path.join(dir, 'pkg'));
+
+var files = {
+  'main.js': 'module.exports = require("./pkg").concat("ascii");',
+  'pkg/package.json': '{"main": "lib"}',
+  'pkg/lib.js': 'module.exports = ["héllo ☃"];',
+  'data.json': '{"answer": 42}',
+  'late.js': 'module.exports = "late";'
+};
+var filenames = Object.keys(files).map(function(name) {
+  var filename = path.join(dir, name);
+  fs.writeFileSync(filename, files[name]);
+  return filename;
+});
+
+Module._writeBundle(bundleFile, filenames);
+
+// Everything must come from the bundle from now on.
+filenames.forEach(function(filename) {
+  fs.unlinkSync(filename);
+});
+fs.rmdirSync(path.join(dir, 'pkg'));
+fs.rmdirSync(dir);
+
+Module._loadBundle(bundleFile);
+
+assert.deepEqual(require(path.join(dir, 'main')),
+                 ['héllo ☃', 'ascii']);
+assert.equal(require(path.join(dir, 'data.json')).answer, 42);
+assert.equal(require.resolve(path.join(dir, 'pkg')),
+             path.join(dir, 'pkg', 'lib.js'));
+assert.throws(function() {
+  require(path.join(dir, 'missing'));
+}, /Cannot find module/);
+
+// Files outside the bundle still load from disk.
+assert.equal(require('../common'), common);
+
+// Writing a bundle renames a new file over the old one, so the mapping of
+// the loaded bundle keeps its contents.
+Module._writeBundle(bundleFile, []);
+assert.equal(require(path.join(dir, 'late')), 'late');
+assert.deepEqual(fs.readdirSync(common.tmpDir).filter(function(name) {
+  return name.indexOf(path.basename(bundleFile) + '.') === 0;
+}), []);
+fs.unlinkSync(bundleFile);
+
+// The loaded bundle stays mapped, use another file for the error cases.
+var invalidFile = bundleFile + '.invalid';
+fs.writeFileSync(invalidFile, 'not a bundle');
+assert.throws(function() {
+  Module._loadBundle(invalidFile);
+}, /Invalid module bundle/);
+fs.unlinkSync(invalidFile);
+
+assert.throws(function() {
+  Module._loadBundle(invalidFile);
+}, /ENOENT/);
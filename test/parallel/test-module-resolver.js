@@ -0,0 +1,110 @@
+'use strict';
+var common = require('../common');
+var assert = require('assert');
+var fs = require('fs');
+var path = require('path');
+
+var root = path.join(common.tmpDir, 'resolver-' + process.pid);
+var created = [];
+
+function mkdir(name) {
+  var dir = path.join(root, name);
+  fs.mkdirSync(dir);
+  created.unshift(dir);
+}
+
+function write(name, contents) {
+  var file = path.join(root, name);
+  fs.writeFileSync(file, contents);
+  created.unshift(file);
+  return file;
+}
+
+process.on('exit', function() {
+  created.forEach(function(p) {
+    if (fs.statSync(p).isDirectory())
+      fs.rmdirSync(p);
+    else
+      fs.unlinkSync(p);
+  });
+  fs.rmdirSync(root);
+});
+
+if (!fs.existsSync(common.tmpDir))
+  fs.mkdirSync(common.tmpDir);
+fs.mkdirSync(root);
+
+// "main" pointing at a directory with a trailing slash and '..' segments.
+mkdir('pkg');
+mkdir('pkg/lib');
+mkdir('pkg/other');
+write('pkg/package.json', '{"name": "pkg", "main": "./other/../lib/"}');
+var index = write('pkg/lib/index.js', 'module.exports = "lib";');
+assert.equal(require(path.join(root, 'pkg')), 'lib');
+assert.equal(require.resolve(path.join(root, 'pkg')), index);
+
+// A BOM, "main" without an extension, the last "main" key wins, nested
+// values are skipped.
+mkdir('ext');
+write('ext/package.json',
+      '\ufeff{"main": "x", "config": {"main": "y", "a": [1, -2.5e3, null]},' +
+      ' "main": "entry"}');
+write('ext/entry.js', 'module.exports = "entry";');
+assert.equal(require(path.join(root, 'ext')), 'entry');
+
+// No "main", falls back to index.js.
+mkdir('nomain');
+write('nomain/package.json', '{"name": "nomain"}');
+write('nomain/index.js', 'module.exports = "index";');
+assert.equal(require(path.join(root, 'nomain')), 'index');
+
+// Escape sequences are handled by the JS fallback.
+mkdir('escaped');
+write('escaped/package.json', '{"main": "m\\u0061in.js"}');
+write('escaped/main.js', 'module.exports = "escaped";');
+assert.equal(require(path.join(root, 'escaped')), 'escaped');
+
+// Malformed package.json still reports the parse error.
+mkdir('broken');
+write('broken/package.json', '{"main": "index.js",}');
+write('broken/index.js', '');
+assert.throws(function() {
+  require(path.join(root, 'broken'));
+}, /Error parsing .*package\.json/);
+
+// So are errors in values the scanner skips.
+[
+  '{"x": "\\q", "main": "index.js"}',
+  '{"x": "\\u12", "main": "index.js"}',
+  '{"x": 1.e5, "main": "index.js"}',
+  '{"x": 1-2, "main": "index.js"}',
+  '{"x": -, "main": "index.js"}',
+  '{"x": 2e, "main": "index.js"}'
+].forEach(function(json, i) {
+  mkdir('broken' + i);
+  write('broken' + i + '/package.json', json);
+  write('broken' + i + '/index.js', '');
+  assert.throws(function() {
+    require(path.join(root, 'broken' + i));
+  }, /Error parsing .*package\.json/);
+});
+
+// Negative results don't stick across lookups of other files.
+assert.throws(function() {
+  require(path.join(root, 'later'));
+}, /Cannot find module/);
+write('later.js', 'module.exports = "later";');
+assert.equal(require(path.join(root, 'later')), 'later');
+
+// A package.json created after the directory was searched is found.
+mkdir('late');
+write('late/index.js', '');
+var main = write('late/main.js', '');
+assert.equal(require.resolve(path.join(root, 'late')),
+             path.join(root, 'late/index.js'));
+write('late/package.json', '{"main": "main.js"}');
+var Module = require('module');
+Object.keys(Module._pathCache).forEach(function(key) {
+  delete Module._pathCache[key];
+});
+assert.equal(require.resolve(path.join(root, 'late')), main);
@@ -0,0 +1,35 @@
+'use strict';
+var common = require('../common');
+var assert = require('assert');
+var net = require('net');
+
+function tcpStats(options) {
+  return process.getAsyncResourceStats(options).TCPWRAP ||
+         { live: 0, created: 0, destroyed: 0 };
+}
+
+var before = tcpStats();
+assert.strictEqual(before.nativeBytes, undefined);
+
+var server = net.createServer().listen(common.PORT, function() {
+  var during = tcpStats({ nativeBytes: true });
+  assert.strictEqual(during.live, before.live + 1);
+  assert.strictEqual(during.created, before.created + 1);
+  assert.strictEqual(during.destroyed, before.destroyed);
+  assert(during.nativeBytes > 0);
+
+  server.close(function() {
+    // 'close' is emitted before libuv has closed the handle, which is when
+    // the wrap is destroyed.  That happens in the close phase of this loop
+    // iteration, the check phase of the next one runs after it.
+    setImmediate(function() {
+      setImmediate(function() {
+        var after = tcpStats({ nativeBytes: true });
+        assert.strictEqual(after.live, before.live);
+        assert.strictEqual(after.created, before.created + 1);
+        assert.strictEqual(after.destroyed, before.destroyed + 1);
+        assert.strictEqual(after.live, after.created - after.destroyed);
+      });
+    });
+  });
+});
@@ -0,0 +1,55 @@
+'use strict';
+var common = require('../common');
+var assert = require('assert');
+
+var m = process.loopMetrics();
+assert.strictEqual(m.enabled, false);
+assert.strictEqual(m.iterations, 0);
+assert.strictEqual(m.utilization, 0);
+
+process.startLoopMetrics();
+
+function spin(ms) {
+  var end = Date.now() + ms;
+  while (Date.now() < end);
+}
+
+var ticks = 0;
+var timer = setInterval(function() {
+  spin(2);
+  setImmediate(spin, 1);
+
+  if (++ticks < 20)
+    return;
+
+  clearInterval(timer);
+
+  var m = process.loopMetrics();
+  assert.strictEqual(m.enabled, true);
+  assert(m.iterations >= 20, 'iterations: ' + m.iterations);
+  assert(m.loopTime > 0);
+  assert(m.idleTime > 0);
+  assert(m.immediateTime >= 10, 'immediateTime: ' + m.immediateTime);
+  assert(m.utilization > 0 && m.utilization < 1);
+
+  var sum = m.idleTime + m.ioTime + m.immediateTime + m.otherTime;
+  assert(Math.abs(sum - m.loopTime) < 1e-6);
+
+  var l = m.latency;
+  assert(l.p50 <= l.p90 && l.p90 <= l.p99 && l.p99 <= l.max);
+  assert(l.max >= 1, 'max: ' + l.max);
+
+  var total = m.histogram.counts.reduce(function(a, b) { return a + b; }, 0);
+  assert.strictEqual(total, m.iterations);
+  for (var i = 1; i < m.histogram.limits.length; i++)
+    assert(m.histogram.limits[i] > m.histogram.limits[i - 1]);
+
+  process.stopLoopMetrics();
+  var iterations = process.loopMetrics().iterations;
+  setTimeout(function() {
+    assert.strictEqual(process.loopMetrics().iterations, iterations);
+    process.resetLoopMetrics();
+    assert.strictEqual(process.loopMetrics().iterations, 0);
+    assert.deepEqual(process.loopMetrics().histogram.counts, []);
+  }, 10);
+}, 5);
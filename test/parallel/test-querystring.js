@@ -175,6 +175,28 @@ assert.equal(f, 'a:b;q:x%3Ay%3By%3Az');
 assert.deepEqual({}, qs.parse());
 
 
+// '+' is replaced before the key/value separator is looked for
+assert.deepEqual(qs.parse('a+b', '&', '+'), { 'a b': '' });
+assert.deepEqual(qs.parse('a+b', '&', '%'), { a: '20b' });
+
+// The native parser agrees with the JS one used for custom decoders
+(function() {
+  var jsOptions = {
+    decodeURIComponent: function(s) { return qs.unescape(s); }
+  };
+  [
+    ['a+b=c+d&e', '&', '='],
+    ['a+b&c+d', '&', '+'],
+    ['x+%2B=1;y=2+0', ';', '0'],
+    ['a::b&c::d::e', '&', '::'],
+    ['a=>1&&b=>2&&&c', '&&', '=>']
+  ].forEach(function(args) {
+    assert.deepEqual(qs.parse(args[0], args[1], args[2]),
+                     qs.parse(args[0], args[1], args[2], jsOptions));
+  });
+})();
+
+
 // Test limiting
 assert.equal(
     Object.keys(qs.parse('a=1&b=1&c=1', null, null, { maxKeys: 1 })).length,
@@ -246,3 +268,28 @@ qs.unescape = function(str) {
 };
 assert.deepEqual(qs.parse('foo=bor'), {f__: 'b_r'});
 qs.unescape = prevUnescape;
+
+// Malformed escapes are copied through the same way unescapeBuffer() does
+assert.deepEqual(qs.parse('a=%4'), { a: '%4' });
+assert.deepEqual(qs.parse('a=%'), { a: '%' });
+assert.deepEqual(qs.parse('a=%+'), { a: '%%20' });
+assert.deepEqual(qs.parse('a=%%41+b'), { a: '%%41 b' });
+assert.deepEqual(qs.parse('a=%C3'), { a: '\ufffd' });
+assert.deepEqual(qs.parse('a=%E4%B8%AD&b=%F0%9F%98%80'),
+                 { a: '中', b: '😀' });
+assert.deepEqual(qs.parse('中=文&b=%E6%96%87'),
+                 { '中': '文', b: '文' });
+
+// Multi-character separators; only the first character of eq is skipped
+assert.deepEqual(qs.parse('a=>1&&b=>2&&&c', '&&', '=>'),
+                 { a: '>1', b: '>2', '&c': '' });
+
+// Limiting counts empty parts too
+assert.deepEqual(qs.parse('&&a=1', null, null, { maxKeys: 2 }),
+                 { '': ['', ''] });
+
+// Unpaired surrogates are encoded as if the missing half were zero
+assert.equal(qs.escape('😀'), '%F0%9F%98%80');
+assert.equal(qs.escape('a\ud83d'), 'a%F0%9F%90%80');
+assert.equal(qs.escape(''), '');
+assert.equal(qs.escape(42), '42');
@@ -25,6 +25,8 @@ test(
 
 // CESU-8
 test('utf-8', new Buffer('EDA0BDEDB18D', 'hex'), '\ud83d\udc4d'); // thumbs up
+// Lead surrogate at the end of a chunk that starts with something else
+test('utf-8', new Buffer('61EDA0BDEDB18D', 'hex'), 'a\ud83d\udc4d');
 
 // UCS-2
 test('ucs2', new Buffer('ababc', 'ucs2'), 'ababc');
@@ -34,6 +36,24 @@ test('ucs2', new Buffer('3DD84DDC', 'hex'),  '\ud83d\udc4d'); // thumbs up
 
 console.log(' crayon!');
 
+// Strings are passed through, readline writes them
+var decoder = new StringDecoder('utf8');
+assert.strictEqual(decoder.write('asdf\n'), 'asdf\n');
+assert.strictEqual(decoder.end('a'), 'a');
+
+// The state of an incomplete character can still be read
+decoder = new StringDecoder('utf8');
+assert.strictEqual(decoder.surrogateSize, 3);
+assert.strictEqual(decoder.write(new Buffer([0xE2, 0x82])), '');
+assert.strictEqual(decoder.charReceived, 2);
+assert.strictEqual(decoder.charLength, 3);
+assert.deepEqual(decoder.charBuffer.slice(0, 2), new Buffer([0xE2, 0x82]));
+assert.strictEqual(decoder.write(new Buffer([0xAC])), '\u20ac');
+assert.strictEqual(decoder.charReceived, 0);
+assert.strictEqual(decoder.charLength, 0);
+assert.strictEqual(new StringDecoder('ucs2').surrogateSize, 2);
+assert.strictEqual(new StringDecoder('hex').charReceived, undefined);
+
 // test verifies that StringDecoder will correctly decode the given input
 // buffer with the given encoding to the expected output. It will attempt all
 // possible ways to write() the input buffer, see writeSequences(). The
@@ -58,8 +78,7 @@ function test(encoding, input, expected, singleSequence) {
         'Expected "' + unicodeEscape(expected) + '", ' +
         'but got "' + unicodeEscape(output) + '"\n' +
         'Write sequence: ' + JSON.stringify(sequence) + '\n' +
-        'Decoder charBuffer: 0x' + decoder.charBuffer.toString('hex') + '\n' +
-        'Full Decoder State: ' + JSON.stringify(decoder, null, 2);
+        'Encoding: ' + encoding;
       assert.fail(output, expected, message);
     }
   });
@@ -0,0 +1,67 @@
+'use strict';
+// tls.connect() shares one native context between connections with the
+// same options.  Connections with different options must not get it.
+
+var common = require('../common');
+var assert = require('assert');
+
+if (!common.hasCrypto) {
+  console.log('1..0 # Skipped: missing crypto');
+  process.exit();
+}
+var tls = require('tls');
+
+var fs = require('fs');
+var join = require('path').join;
+
+function read(file) {
+  return fs.readFileSync(join(common.fixturesDir, 'keys', file));
+}
+
+var ca1 = read('ca1-cert.pem');
+var ca2 = read('ca2-cert.pem');
+
+var server = tls.createServer({
+  key: read('agent1-key.pem'),
+  cert: read('agent1-cert.pem')
+}, function(socket) {
+  socket.end();
+});
+
+// Expected authorizationError, null if the server should be trusted.
+var tests = [
+  [{ ca: ca1 }, null],
+  [{ ca: ca1 }, null],
+  [{ ca: [ca1] }, null],
+  [{ ca: ca2 }, 'UNABLE_TO_VERIFY_LEAF_SIGNATURE'],
+  [{ ca: ca1.toString() }, null],
+  [{ ca: ca1, ciphers: 'AES128-SHA' }, null],
+  [{}, 'UNABLE_TO_VERIFY_LEAF_SIGNATURE'],
+  [{}, 'UNABLE_TO_VERIFY_LEAF_SIGNATURE'],
+  [{ ca: ca2 }, 'UNABLE_TO_VERIFY_LEAF_SIGNATURE'],
+  [{ ca: ca1 }, null]
+];
+
+function next() {
+  var test = tests.shift();
+  if (!test)
+    return server.close();
+
+  var options = test[0];
+  options.port = common.PORT;
+  options.servername = 'agent1';
+  options.rejectUnauthorized = false;
+
+  var socket = tls.connect(options, function() {
+    assert.equal(socket.authorized, test[1] === null);
+    assert.equal(socket.authorizationError || null, test[1]);
+    socket.end();
+  });
+  socket.on('close', next);
+}
+
+server.listen(common.PORT, next);
+
+process.on('exit', function() {
+  assert.equal(tests.length, 0);
+});
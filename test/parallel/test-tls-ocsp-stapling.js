@@ -0,0 +1,115 @@
+'use strict';
+var common = require('../common');
+
+if (!process.features.tls_ocsp) {
+  console.error('Skipping because node compiled without OpenSSL or ' +
+                'with old OpenSSL version.');
+  process.exit(0);
+}
+
+if (!common.hasCrypto) {
+  console.log('1..0 # Skipped: missing crypto');
+  process.exit();
+}
+var tls = require('tls');
+
+var assert = require('assert');
+var fs = require('fs');
+var join = require('path').join;
+
+function read(name) {
+  return fs.readFileSync(join(common.fixturesDir, 'keys', name));
+}
+
+var options = {
+  key: read('agent1-key.pem'),
+  cert: read('agent1-cert.pem'),
+  ca: [read('ca1-cert.pem')]
+};
+var response = read('agent1-ocsp-response.der');
+
+var fetches = 0;
+var staples = 0;
+var responses = 0;
+var errors = [];
+
+// Stands in for the OCSP responder.
+function fetcher(certificate, issuer, callback) {
+  fetches++;
+  assert(Buffer.isBuffer(certificate));
+  assert(Buffer.isBuffer(issuer));
+  setTimeout(function() {
+    callback(null, response);
+  }, 10);
+}
+
+options.ocspStapling = fetcher;
+var server = tls.createServer(options, function(socket) {
+  socket.end();
+});
+
+server.on('OCSPStaple', function(resp, nextUpdate) {
+  staples++;
+  assert.deepEqual(resp, response);
+  assert(nextUpdate instanceof Date);
+  assert(nextUpdate > Date.now());
+
+  server.listen(common.PORT, function() {
+    connect(function() {
+      connect(function() {
+        server.close();
+      });
+    });
+  });
+});
+
+function connect(cb) {
+  var client = tls.connect({
+    port: common.PORT,
+    requestOCSP: true,
+    rejectUnauthorized: false
+  });
+  client.on('OCSPResponse', function(resp) {
+    responses++;
+    assert.deepEqual(resp, response);
+  });
+  client.on('close', cb);
+  client.resume();
+}
+
+// Responses that can't be stapled.
+function rejects(fetch, expected) {
+  var server = tls.createServer({
+    key: options.key,
+    cert: options.cert,
+    ca: options.ca,
+    ocspStapling: fetch
+  });
+  server.on('OCSPStaple', function() {
+    assert(false, 'OCSPStaple emitted');
+  });
+  server.on('OCSPStapleError', function(err) {
+    assert(expected.test(err.message), err.message);
+    errors.push(err);
+    server.close();
+  });
+  // close() only works on a listening server.
+  server.listen(0);
+}
+
+rejects(function(certificate, issuer, callback) {
+  callback(new Error('responder is down'));
+}, /responder is down/);
+rejects(function(certificate, issuer, callback) {
+  callback(null, new Buffer('hello world'));
+}, /Invalid OCSP response/);
+rejects(function(certificate, issuer, callback) {
+  callback(null, 'hello world');
+}, /must be a Buffer/);
+
+process.on('exit', function() {
+  assert.equal(fetches, 1);
+  assert.equal(staples, 1);
+  assert.equal(responses, 2);
+  assert.equal(errors.length, 3);
+});
@@ -0,0 +1,81 @@
+'use strict';
+var common = require('../common');
+var assert = require('assert');
+var stream = require('stream');
+var v8 = require('v8');
+
+assert.strictEqual(v8.stopCpuProfiling(), null);
+assert.throws(function() {
+  v8.startCpuProfiling({ interval: 0 });
+}, RangeError);
+
+v8.startCpuProfiling({ interval: 100 });
+assert.throws(function() {
+  v8.startCpuProfiling();
+}, /already being recorded/);
+
+function busyLoop() {
+  var end = Date.now() + 200;
+  var n = 0;
+  while (Date.now() < end)
+    n += Math.sqrt(n);
+  return n;
+}
+busyLoop();
+
+var profile = v8.stopCpuProfiling();
+assert(profile.nodeCount > 0);
+assert(profile.sampleCount > 0);
+assert(profile.endTime >= profile.startTime);
+
+var json = profile.toJSON();
+assert.equal(json.head.functionName, '(root)');
+assert.equal(json.samples.length, profile.sampleCount);
+assert.equal(json.timestamps.length, profile.sampleCount);
+
+var nodes = 0;
+var found = false;
+(function walk(node) {
+  nodes++;
+  if (node.functionName === 'busyLoop') {
+    found = true;
+    assert.equal(node.url, __filename);
+  }
+  node.children.forEach(walk);
+})(json.head);
+assert.equal(nodes, profile.nodeCount);
+assert(found, 'busyLoop not in profile');
+
+function collect(format, callback) {
+  var sink = new stream.Writable({ highWaterMark: 1024 });
+  var chunks = [];
+  sink._write = function(chunk, encoding, cb) {
+    chunks.push(chunk);
+    setImmediate(cb);
+  };
+  profile.write(sink, format, common.mustCall(function(err) {
+    assert.ifError(err);
+    callback(Buffer.concat(chunks));
+  }));
+}
+
+collect('json', function(data) {
+  assert.deepEqual(JSON.parse(data), json);
+});
+
+collect('binary', function(data) {
+  assert.equal(data.toString('binary', 0, 8), 'NODECPUP');
+  assert.equal(data.readUInt32LE(8), 1);
+  assert.equal(data.readUInt32LE(12), profile.nodeCount);
+  assert.equal(data.readUInt32LE(16), profile.sampleCount);
+  assert.equal(data.readDoubleLE(20), profile.startTime);
+  assert.equal(data.readDoubleLE(28), profile.endTime);
+  var tail = data.length - profile.sampleCount * 12;
+  assert.equal(data.readUInt32LE(tail), json.samples[0]);
+  assert.equal(data.readDoubleLE(data.length - 8),
+               json.timestamps[json.timestamps.length - 1]);
+});
+
+assert.throws(function() {
+  profile.write(new stream.PassThrough(), 'xml');
+}, TypeError);
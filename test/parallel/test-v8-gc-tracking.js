@@ -0,0 +1,63 @@
+'use strict';
+// Flags: --expose-gc
+
+var common = require('../common');
+var assert = require('assert');
+var v8 = require('v8');
+
+assert.deepEqual(v8.drainGCEvents(), { events: [], dropped: 0 });
+
+assert.throws(function() { v8.startGCTracking(0); }, RangeError);
+assert.throws(function() { v8.startGCTracking(1.5); }, RangeError);
+assert.throws(function() { v8.startGCTracking('8'); }, RangeError);
+
+v8.startGCTracking(4);
+
+var before = process.hrtime();
+gc();
+var result = v8.drainGCEvents();
+assert.equal(result.dropped, 0);
+assert(result.events.length >= 1);
+
+var e = result.events[result.events.length - 1];
+assert.equal(e.type, 'mark-sweep-compact');
+assert.equal(e.forced, true);
+assert(e.start >= before[0] * 1e3 + before[1] / 1e6);
+assert(e.duration >= 0);
+assert(e.used_heap_size_before > 0);
+assert(e.used_heap_size_after > 0);
+assert(e.total_heap_size_after >= e.used_heap_size_after);
+
+// Nothing new since the last drain.
+assert.equal(v8.drainGCEvents().events.length, 0);
+
+// Overflowing the buffer drops the oldest events.
+for (var i = 0; i < 6; i++)
+  gc();
+result = v8.drainGCEvents();
+assert.equal(result.events.length, 4);
+assert(result.dropped >= 2);
+for (i = 1; i < result.events.length; i++)
+  assert(result.events[i].start > result.events[i - 1].start);
+
+// Scavenges are recorded too.
+var garbage;
+for (i = 0; i < 1e5; i++)
+  garbage = { i: i, s: 'x' + i };
+assert(v8.drainGCEvents().events.some(function(e) {
+  return e.type === 'scavenge';
+}));
+
+v8.stopGCTracking();
+gc();
+assert.equal(v8.drainGCEvents().events.length, 0);
+
+// A tracker that is still running when the process exits is torn down
+// together with its environment.
+var child = require('child_process').spawnSync(process.execPath, [
+  '--expose-gc',
+  '-e',
+  'require("v8").startGCTracking(4); gc(); setImmediate(gc);'
+]);
+assert.equal(child.status, 0);
+assert.equal(child.signal, null);
@@ -0,0 +1,38 @@
+'use strict';
+var common = require('../common');
+var assert = require('assert');
+var fs = require('fs');
+var net = require('net');
+var path = require('path');
+var v8 = require('v8');
+
+assert.throws(function() {
+  v8.writeHeapSnapshot(42);
+}, TypeError);
+
+assert.throws(function() {
+  v8.writeHeapSnapshot(path.join(common.tmpDir, 'missing', 'x.heapsnapshot'));
+}, /ENOENT/);
+
+var server = net.createServer().listen(common.PORT, function() {
+  var filename = path.join(common.tmpDir, 'test.heapsnapshot');
+  try {
+    fs.unlinkSync(filename);
+  } catch (e) {}
+
+  assert.strictEqual(v8.writeHeapSnapshot(filename), filename);
+  server.close();
+
+  var snapshot = JSON.parse(fs.readFileSync(filename, 'utf8'));
+  var meta = snapshot.snapshot.meta;
+  assert(snapshot.snapshot.node_count > 0);
+  assert.strictEqual(snapshot.nodes.length,
+                     snapshot.snapshot.node_count * meta.node_fields.length);
+  assert.strictEqual(snapshot.edges.length,
+                     snapshot.snapshot.edge_count * meta.edge_fields.length);
+
+  // The listening socket is reported as a native object.
+  assert.notStrictEqual(snapshot.strings.indexOf('TCPWRAP'), -1);
+
+  fs.unlinkSync(filename);
+});
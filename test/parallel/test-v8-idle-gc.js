@@ -0,0 +1,34 @@
+'use strict';
+// Flags: --idle-gc
+
+var common = require('../common');
+var assert = require('assert');
+var v8 = require('v8');
+
+assert.strictEqual(process.idleGC, true);
+
+var garbage = [];
+var ticks = 0;
+
+// Produce some garbage and leave the loop idle between timer callbacks.
+var timer = setInterval(function() {
+  garbage = [];
+  for (var i = 0; i < 1e4; i++)
+    garbage.push({ i: i, s: 'x' + i });
+
+  if (++ticks < 10)
+    return;
+
+  clearInterval(timer);
+
+  var s = v8.getIdleGCStatistics();
+  assert.deepEqual(Object.keys(s).sort(),
+                   ['budget_ms', 'completed', 'enabled', 'notifications',
+                    'time_ms']);
+  assert.strictEqual(s.enabled, true);
+  assert(s.notifications > 0);
+  assert(s.budget_ms >= s.notifications);
+  assert(s.budget_ms <= s.notifications * 10);
+  assert(s.completed <= s.notifications);
+  assert(s.time_ms >= 0);
+}, 20);
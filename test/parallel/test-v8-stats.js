@@ -14,3 +14,9 @@ assert.deepEqual(Object.keys(s).sort(), keys);
 keys.forEach(function(key) {
   assert.equal(typeof s[key], 'number');
 });
+
+// Idle-time GC is off unless requested with --idle-gc.
+var idle = v8.getIdleGCStatistics();
+assert.strictEqual(idle.enabled, false);
+assert.strictEqual(idle.notifications, 0);
+assert.strictEqual(idle.time_ms, 0);
@@ -0,0 +1,65 @@
+'use strict';
+// The CRC-32 in the gzip trailer and the Adler-32 in the zlib trailer are
+// computed with SIMD instructions on CPUs that have them.  Check them against
+// plain JS implementations, for lengths on both sides of the block sizes.
+
+var common = require('../common');
+var assert = require('assert');
+var zlib = require('zlib');
+
+var crcTable = [];
+for (var n = 0; n < 256; n++) {
+  var c = n;
+  for (var k = 0; k < 8; k++)
+    c = c & 1 ? 0xedb88320 ^ (c >>> 1) : c >>> 1;
+  crcTable[n] = c >>> 0;
+}
+
+function crc32(buf) {
+  var crc = 0xffffffff;
+  for (var i = 0; i < buf.length; i++)
+    crc = crcTable[(crc ^ buf[i]) & 0xff] ^ (crc >>> 8);
+  return (crc ^ 0xffffffff) >>> 0;
+}
+
+function adler32(buf) {
+  var a = 1;
+  var b = 0;
+  for (var i = 0; i < buf.length; i++) {
+    a = (a + buf[i]) % 65521;
+    b = (b + a) % 65521;
+  }
+  return (b * 65536 + a) >>> 0;
+}
+
+// Deterministic, not very compressible input.
+var data = new Buffer(300000);
+var seed = 1;
+for (var i = 0; i < data.length; i++) {
+  seed = (seed * 1103515245 + 12345) & 0x7fffffff;
+  data[i] = seed >>> 16;
+}
+
+[0, 1, 15, 16, 63, 64, 65, 127, 1000, 5552, 65537, data.length - 1,
+ data.length].forEach(function(length) {
+  // Slice at an odd offset so the input is not aligned.
+  var input = data.slice(1, length + 1);
+  if (input.length !== length) input = data.slice(0, length);
+
+  var gzipped = zlib.gzipSync(input);
+  assert.equal(gzipped.readUInt32LE(gzipped.length - 8), crc32(input),
+               'crc32 of ' + length + ' bytes');
+
+  var deflated = zlib.deflateSync(input);
+  assert.equal(deflated.readUInt32BE(deflated.length - 4), adler32(input),
+               'adler32 of ' + length + ' bytes');
+
+  assert.deepEqual(zlib.gunzipSync(gzipped), input);
+  assert.deepEqual(zlib.inflateSync(deflated), input);
+});
+
+// All ones is the worst case for the Adler-32 sums.
+var ones = new Buffer(100000);
+ones.fill(0xff);
+var deflated = zlib.deflateSync(ones);
+assert.equal(deflated.readUInt32BE(deflated.length - 4), adler32(ones));
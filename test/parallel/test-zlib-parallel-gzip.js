@@ -0,0 +1,78 @@
+'use strict';
+// zlib.gzip() with `parallel: true` compresses blocks of the input on the
+// threadpool and joins them into a single gzip stream.
+
+var common = require('../common');
+var assert = require('assert');
+var crypto = require('crypto');
+var zlib = require('zlib');
+
+// Random data repeated every 1000 bytes, so every block after the first one
+// compresses well only if it was primed with the input before it.
+var pattern = crypto.pseudoRandomBytes(1000);
+function input(length) {
+  var buf = new Buffer(length);
+  for (var i = 0; i < length; i += pattern.length)
+    pattern.copy(buf, i);
+  return buf;
+}
+
+var cases = [
+  { length: 0 },
+  { length: 1 },
+  { length: 1000, blockSize: 4096 },
+  { length: 4096, blockSize: 1024 },
+  { length: 10000, blockSize: 1024, concurrency: 2 },
+  { length: 10000, blockSize: 64, concurrency: 1, level: 1 },
+  { length: 300000 },
+  { length: 300000, level: 9, memLevel: 9 },
+  { length: 100000, blockSize: 4096, strategy: zlib.Z_HUFFMAN_ONLY }
+];
+
+var done = 0;
+cases.forEach(function(c) {
+  var buf = input(c.length);
+  var opts = { parallel: true };
+  Object.keys(c).forEach(function(key) {
+    if (key !== 'length') opts[key] = c[key];
+  });
+
+  zlib.gzip(buf, opts, function(err, result) {
+    assert.ifError(err);
+    assert.equal(result[0], 0x1f);
+    assert.equal(result[1], 0x8b);
+    assert.deepEqual(zlib.gunzipSync(result), buf);
+    assert.equal(result.readUInt32LE(result.length - 4), c.length);
+    // Matches reach back into the previous block.
+    if (c.length >= 10000 && c.blockSize !== 64 && c.strategy === undefined)
+      assert(result.length < c.length / 5, JSON.stringify(c));
+    done++;
+  });
+});
+
+zlib.gzip('hello world', { parallel: true }, function(err, result) {
+  assert.ifError(err);
+  assert.equal(zlib.gunzipSync(result).toString(), 'hello world');
+  done++;
+});
+
+var small = input(100);
+assert.throws(function() {
+  zlib.gzip({}, { parallel: true }, function() {});
+}, TypeError);
+assert.throws(function() {
+  zlib.gzip(small, { parallel: true, blockSize: 1 }, function() {});
+}, /Invalid block size/);
+assert.throws(function() {
+  zlib.gzip(small, { parallel: true, blockSize: 1.5 }, function() {});
+}, /Invalid block size/);
+assert.throws(function() {
+  zlib.gzip(small, { parallel: true, concurrency: 0 }, function() {});
+}, /Invalid concurrency/);
+assert.throws(function() {
+  zlib.gzip(small, { parallel: true, level: 10 }, function() {});
+}, /Invalid compression level/);
+
+process.on('exit', function() {
+  assert.equal(done, cases.length + 1);
+});
@@ -0,0 +1,111 @@
+#!/usr/bin/env python
+#
+# Converts the PEM root certificates in src/node_root_certs.h to DER, so
+# they don't have to be base64 decoded and parsed at startup.  The output is
+# a C header with the DER bytes of all certificates in one array and, for
+# each certificate, its offset and length in there along with those of its
+# subject name.  src/node_crypto.cc looks issuers up by subject name and only
+# parses the certificates that are actually needed.
+#
+# Usage: genrootcerts.py <output.h> <node_root_certs.h>
+
+import base64
+import re
+import sys
+
+
+def read_pem_certs(filename):
+  certs = []
+  name = None
+  lines = None
+  with open(filename) as f:
+    for line in f:
+      line = line.strip()
+      comment = re.match(r'^/\* (.*) \*/$', line)
+      if comment:
+        name = comment.group(1)
+        continue
+      string = re.match(r'^"(.*)\\n",?$', line)
+      if not string:
+        continue
+      text = string.group(1)
+      if text == '-----BEGIN CERTIFICATE-----':
+        lines = []
+      elif text == '-----END CERTIFICATE-----':
+        certs.append((name, base64.b64decode(''.join(lines))))
+        name = lines = None
+      elif lines is not None:
+        lines.append(text)
+  return certs
+
+
+def der_element(der, offset):
+  """Returns (header length, content length) of the DER element at offset."""
+  length = der[offset + 1]
+  if length < 0x80:
+    return 2, length
+  count = length & 0x7f
+  length = 0
+  for i in range(count):
+    length = (length << 8) | der[offset + 2 + i]
+  return 2 + count, length
+
+
+def subject_range(der):
+  """Returns (offset, length) of the subject name in a DER certificate.
+
+  Certificate ::= SEQUENCE { tbsCertificate, ... }
+  TBSCertificate ::= SEQUENCE { [0] version OPTIONAL, serialNumber,
+                                signature, issuer, validity, subject, ... }
+  """
+  header, _ = der_element(der, 0)
+  offset = header
+  header, _ = der_element(der, offset)
+  offset += header
+  if der[offset] == 0xa0:
+    header, length = der_element(der, offset)
+    offset += header + length
+  # serialNumber, signature, issuer, validity
+  for _ in range(4):
+    header, length = der_element(der, offset)
+    offset += header + length
+  header, length = der_element(der, offset)
+  return offset, header + length
+
+
+def main():
+  output, source = sys.argv[1], sys.argv[2]
+  certs = read_pem_certs(source)
+
+  data = []
+  entries = []
+  for name, der in certs:
+    der = bytearray(der)
+    subject_offset, subject_length = subject_range(der)
+    entries.append((name, len(data), len(der),
+                    len(data) + subject_offset, subject_length))
+    data.extend(der)
+
+  out = []
+  out.append('// Generated by tools/genrootcerts.py from %s, do not edit.'
+             % source.replace('\\', '/'))
+  out.append('')
+  out.append('static const unsigned char root_certs_der[] = {')
+  for i in range(0, len(data), 16):
+    out.append('  ' + ', '.join('0x%02x' % b for b in data[i:i + 16]) + ',')
+  out.append('};')
+  out.append('')
+  out.append('static const RootCertificate root_certs[] = {')
+  for name, offset, length, subject_offset, subject_length in entries:
+    out.append('  // %s' % name)
+    out.append('  { %d, %d, %d, %d },' %
+               (offset, length, subject_offset, subject_length))
+  out.append('};')
+  out.append('')
+
+  with open(output, 'w') as f:
+    f.write('\n'.join(out))
+
+
+if __name__ == '__main__':
+  main()